@@ -0,0 +1,354 @@
+/*
+ * bench_pubtrans3.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+/**
+ * Benchmark of the route checks, the RouteWriter and the railway handlers on a synthetic network.
+ *
+ * The network consists of bus and train routes. Each route has stops and platforms followed by a
+ * chain of ways. Some ways are roundabouts, some chains have gaps and some members are missing
+ * (incomplete relations). All output is written to in-memory datasets.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <osmium/index/id_set.hpp>
+#include <osmium/storage/item_stash.hpp>
+#include <osmium/visitor.hpp>
+
+#include "object_builder_utilities.hpp"
+
+#include <candidate_filter.hpp>
+#include <ptv2_checker.hpp>
+#include <railway_handler_pass1.hpp>
+#include <railway_handler_pass2.hpp>
+
+struct BenchConfig {
+    size_t routes = 10000;
+    size_t members = 200;
+    /// probability of a gap before a way
+    double gap_rate = 0.01;
+    /// probability of a member to be missing
+    double missing_rate = 0.005;
+    /// probability of a way to be a roundabout
+    double roundabout_rate = 0.02;
+    /// share of train routes, all other routes are bus routes
+    double train_share = 0.25;
+    /// number of routes generated into one buffer
+    size_t batch_size = 1000;
+    unsigned int seed = 42;
+};
+
+/**
+ * Accumulated run time of a benchmarked function.
+ */
+class Timer {
+    std::string m_name;
+    const char* m_unit;
+    std::chrono::steady_clock::duration m_total {0};
+    uint64_t m_objects = 0;
+
+public:
+    Timer(const char* name, const char* unit) :
+        m_name(name),
+        m_unit(unit) {
+    }
+
+    void add(const std::chrono::steady_clock::duration duration, const uint64_t objects) {
+        m_total += duration;
+        m_objects += objects;
+    }
+
+    void print() const {
+        const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(m_total).count());
+        std::cout << std::left << std::setw(52) << m_name << std::right << std::setw(12) << m_objects << ' '
+            << std::left << std::setw(8) << m_unit << std::right << std::setw(12) << std::fixed << std::setprecision(1)
+            << (m_objects ? ns / m_objects : 0.0) << " ns/object\n";
+    }
+};
+
+/**
+ * A generated route. Its objects are referenced by their offsets in the buffer because the buffer
+ * may be reallocated while the batch is generated.
+ */
+struct SyntheticRoute {
+    size_t relation_offset;
+    std::vector<size_t> member_offsets;
+    std::vector<bool> missing;
+};
+
+class NetworkGenerator {
+    const BenchConfig& m_config;
+    std::mt19937 m_random;
+    std::uniform_real_distribution<double> m_distribution {0.0, 1.0};
+    osmium::object_id_type m_next_node_id = 1;
+    osmium::object_id_type m_next_way_id = 1;
+    osmium::object_id_type m_next_relation_id = 1;
+    tagmap m_bus_route_tags = test_utils::get_bus_route_tags();
+    tagmap m_train_route_tags = test_utils::get_train_route_tags();
+    tagmap m_bus_stop_tags {{"public_transport", "stop_position"}, {"bus", "yes"}};
+    tagmap m_bus_platform_tags {{"public_transport", "platform"}, {"highway", "bus_stop"}};
+    tagmap m_train_stop_tags {{"public_transport", "stop_position"}, {"railway", "stop"}, {"train", "yes"}};
+    tagmap m_train_platform_tags {{"public_transport", "platform"}, {"railway", "platform"}};
+    tagmap m_road_tags {{"highway", "secondary"}};
+    tagmap m_roundabout_tags {{"highway", "secondary"}, {"junction", "roundabout"}};
+    tagmap m_rail_tags {{"railway", "rail"}};
+
+    bool chance(const double rate) {
+        return m_distribution(m_random) < rate;
+    }
+
+    size_t add_node(osmium::memory::Buffer& buffer, const osmium::object_id_type id, const osmium::Location& location,
+            const tagmap& tags) {
+        test_utils::create_new_node(buffer, id, location, tags);
+        return buffer.commit();
+    }
+
+    size_t add_way(osmium::memory::Buffer& buffer, std::vector<osmium::NodeRef>& nodes, const tagmap& tags) {
+        std::vector<const osmium::NodeRef*> node_refs;
+        for (const osmium::NodeRef& nr : nodes) {
+            node_refs.push_back(&nr);
+        }
+        test_utils::create_way(buffer, m_next_way_id++, node_refs, tags);
+        return buffer.commit();
+    }
+
+    SyntheticRoute generate_route(osmium::memory::Buffer& buffer, const size_t index) {
+        SyntheticRoute route;
+        const bool train = chance(m_config.train_share);
+        const size_t stop_count = std::max<size_t>(2, m_config.members / 10) & ~static_cast<size_t>(1);
+        const size_t way_count = m_config.members > stop_count ? m_config.members - stop_count : 1;
+        // spread the routes over a grid to get distinct geometries
+        double x = -170.0 + static_cast<double>(index % 3000) * 0.1;
+        const double y = -60.0 + static_cast<double>((index / 3000) % 1200) * 0.1;
+        std::vector<osmium::object_id_type> ids;
+        std::vector<osmium::item_type> types;
+        std::vector<std::string> roles;
+        std::vector<osmium::NodeRef> stops;
+
+        for (size_t i = 0; i < stop_count; ++i) {
+            const bool is_stop = i % 2 == 0;
+            const osmium::object_id_type id = m_next_node_id++;
+            const osmium::Location location {x + 0.0001 * i, y};
+            const tagmap& tags = is_stop ? (train ? m_train_stop_tags : m_bus_stop_tags)
+                    : (train ? m_train_platform_tags : m_bus_platform_tags);
+            route.member_offsets.push_back(add_node(buffer, id, location, tags));
+            if (is_stop) {
+                stops.emplace_back(id, location);
+            }
+            ids.push_back(id);
+            types.push_back(osmium::item_type::node);
+            roles.push_back(is_stop ? "stop" : "platform");
+        }
+
+        osmium::NodeRef previous_end {m_next_node_id++, osmium::Location{x, y}};
+        for (size_t i = 0; i < way_count; ++i) {
+            osmium::NodeRef start = previous_end;
+            if (chance(m_config.gap_rate)) {
+                x += 0.001;
+                start = osmium::NodeRef{m_next_node_id++, osmium::Location{x, y + 0.001}};
+            }
+            std::vector<osmium::NodeRef> nodes {start};
+            const bool roundabout = !train && chance(m_config.roundabout_rate);
+            if (roundabout) {
+                nodes.emplace_back(m_next_node_id++, osmium::Location{x + 0.0001, y + 0.0001});
+                nodes.emplace_back(m_next_node_id++, osmium::Location{x, y + 0.0002});
+                nodes.push_back(start);
+            } else {
+                // stop positions are nodes of the ways
+                if (i < stops.size()) {
+                    nodes.push_back(stops[i]);
+                } else {
+                    nodes.emplace_back(m_next_node_id++, osmium::Location{x + 0.0001, y});
+                }
+                x += 0.0002;
+                nodes.emplace_back(m_next_node_id++, osmium::Location{x, y});
+            }
+            route.member_offsets.push_back(add_way(buffer, nodes, train ? m_rail_tags : (roundabout ? m_roundabout_tags : m_road_tags)));
+            previous_end = nodes.back();
+            ids.push_back(m_next_way_id - 1);
+            types.push_back(osmium::item_type::way);
+            roles.push_back("");
+        }
+
+        for (size_t i = 0; i < route.member_offsets.size(); ++i) {
+            route.missing.push_back(chance(m_config.missing_rate));
+        }
+        test_utils::create_relation(buffer, m_next_relation_id++, train ? m_train_route_tags : m_bus_route_tags,
+                ids, types, roles);
+        route.relation_offset = buffer.commit();
+        return route;
+    }
+
+public:
+    explicit NetworkGenerator(const BenchConfig& config) :
+        m_config(config),
+        m_random(config.seed) {
+    }
+
+    std::vector<SyntheticRoute> generate(osmium::memory::Buffer& buffer, const size_t first_index, const size_t count) {
+        std::vector<SyntheticRoute> routes;
+        routes.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            routes.push_back(generate_route(buffer, first_index + i));
+        }
+        return routes;
+    }
+};
+
+void print_help(char* arg0) {
+    std::cerr << "Usage: " << arg0 << " [OPTIONS]\n" \
+              << "Options:\n" \
+              << "  -h, --help              This help message.\n" \
+              << "  -r, --routes=NUM        Number of routes (default: 10000)\n" \
+              << "  -m, --members=NUM       Number of members per route (default: 200)\n" \
+              << "  --gap-rate=RATE         Probability of a gap before a way (default: 0.01)\n" \
+              << "  --missing-rate=RATE     Probability of a missing member (default: 0.005)\n" \
+              << "  --roundabout-rate=RATE  Probability of a way being a roundabout (default: 0.02)\n" \
+              << "  --seed=NUM              Seed of the random number generator (default: 42)\n";
+}
+
+int main(int argc, char* argv[]) {
+    const int GAP_RATE = 1000;
+    const int MISSING_RATE = 1001;
+    const int ROUNDABOUT_RATE = 1002;
+    const int SEED = 1003;
+
+    static struct option long_options[] = {
+        {"gap-rate", required_argument, 0, GAP_RATE},
+        {"help",   no_argument, 0, 'h'},
+        {"members", required_argument, 0, 'm'},
+        {"missing-rate", required_argument, 0, MISSING_RATE},
+        {"roundabout-rate", required_argument, 0, ROUNDABOUT_RATE},
+        {"routes", required_argument, 0, 'r'},
+        {"seed", required_argument, 0, SEED},
+        {0, 0, 0, 0}
+    };
+
+    BenchConfig config;
+    while (true) {
+        int c = getopt_long(argc, argv, "hm:r:", long_options, 0);
+        if (c == -1) {
+            break;
+        }
+        switch (c) {
+            case 'm':
+                config.members = static_cast<size_t>(atol(optarg));
+                break;
+            case 'r':
+                config.routes = static_cast<size_t>(atol(optarg));
+                break;
+            case GAP_RATE:
+                config.gap_rate = atof(optarg);
+                break;
+            case MISSING_RATE:
+                config.missing_rate = atof(optarg);
+                break;
+            case ROUNDABOUT_RATE:
+                config.roundabout_rate = atof(optarg);
+                break;
+            case SEED:
+                config.seed = static_cast<unsigned int>(atol(optarg));
+                break;
+            default:
+                print_help(argv[0]);
+                exit(1);
+        }
+    }
+
+    Options options;
+    options.output_format = "Memory";
+    options.output_directory = ".";
+    // The time spent by the writer should be measured on the calling thread.
+    options.async_output = false;
+    osmium::util::VerboseOutput verbose_output {false};
+    OGRWriter ogr_writer {options, verbose_output};
+    RouteWriter route_writer {ogr_writer, options, verbose_output};
+    PTv2Checker checker {route_writer};
+    osmium::ItemStash must_on_track;
+    std::unordered_map<osmium::object_id_type, osmium::ItemStash::handle_type> must_on_track_handles;
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> via_nodes;
+    RailwayHandlerPass1 railway_handler1 {ogr_writer, options, verbose_output, must_on_track, must_on_track_handles};
+    RailwayHandlerPass2 railway_handler2 {ogr_writer, via_nodes, must_on_track_handles, must_on_track, options, verbose_output};
+    // The handlers see the objects through the same prefilter as in osmi_pubtrans3.
+    CandidateFilter<RailwayHandlerPass1> candidate_handler1 {railway_handler1, RailwayHandlerPass1::node_keys(), &RailwayHandlerPass1::way_keys()};
+    CandidateFilter<RailwayHandlerPass2> candidate_handler2 {railway_handler2, RailwayHandlerPass2::node_keys(), nullptr};
+
+    Timer generator_timer {"synthetic network generator", "objects"};
+    Timer roles_timer {"PTv2Checker::check_roles_order_and_type", "members"};
+    Timer gaps_timer {"PTv2Checker::find_gaps", "members"};
+    Timer valid_timer {"RouteWriter::write_valid_route", "routes"};
+    Timer invalid_timer {"RouteWriter::write_invalid_route", "routes"};
+    Timer pass1_timer {"RailwayHandlerPass1", "objects"};
+    Timer pass2_timer {"RailwayHandlerPass2 (including after_ways)", "objects"};
+
+    NetworkGenerator generator {config};
+    osmium::memory::Buffer buffer {10 * 1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (size_t first = 0; first < config.routes; first += config.batch_size) {
+        const size_t count = std::min(config.batch_size, config.routes - first);
+        buffer.clear();
+        auto start = std::chrono::steady_clock::now();
+        const std::vector<SyntheticRoute> routes = generator.generate(buffer, first, count);
+        const uint64_t object_count = static_cast<uint64_t>(std::distance(buffer.begin(), buffer.end()));
+        generator_timer.add(std::chrono::steady_clock::now() - start, object_count);
+
+        start = std::chrono::steady_clock::now();
+        osmium::apply(buffer, candidate_handler1);
+        pass1_timer.add(std::chrono::steady_clock::now() - start, object_count);
+        start = std::chrono::steady_clock::now();
+        osmium::apply(buffer, candidate_handler2);
+        pass2_timer.add(std::chrono::steady_clock::now() - start, object_count);
+
+        for (const SyntheticRoute& route : routes) {
+            const osmium::Relation& relation = buffer.get<osmium::Relation>(route.relation_offset);
+            std::vector<const osmium::OSMObject*> member_objects;
+            std::vector<const char*> roles;
+            size_t i = 0;
+            for (const osmium::RelationMember& member : relation.members()) {
+                member_objects.push_back(route.missing[i] ? nullptr : &buffer.get<osmium::OSMObject>(route.member_offsets[i]));
+                roles.push_back(member.role());
+                ++i;
+            }
+            start = std::chrono::steady_clock::now();
+            RouteError result = checker.check_roles_order_and_type(relation, member_objects);
+            roles_timer.add(std::chrono::steady_clock::now() - start, member_objects.size());
+            start = std::chrono::steady_clock::now();
+            if (checker.find_gaps(relation, member_objects) > 0) {
+                result |= RouteError::UNORDERED_GAP;
+            }
+            gaps_timer.add(std::chrono::steady_clock::now() - start, member_objects.size());
+            start = std::chrono::steady_clock::now();
+            if (result == RouteError::CLEAN) {
+                route_writer.write_valid_route(relation, member_objects, roles);
+                valid_timer.add(std::chrono::steady_clock::now() - start, 1);
+            } else {
+                route_writer.write_invalid_route(relation, member_objects, result);
+                invalid_timer.add(std::chrono::steady_clock::now() - start, 1);
+            }
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    railway_handler2.after_ways();
+    pass2_timer.add(std::chrono::steady_clock::now() - start, 0);
+
+    std::cout << "routes: " << config.routes << ", members per route: " << config.members << '\n';
+    generator_timer.print();
+    roles_timer.print();
+    gaps_timer.print();
+    valid_timer.print();
+    invalid_timer.print();
+    pass1_timer.print();
+    pass2_timer.print();
+}
@@ -0,0 +1,324 @@
+/*
+ * blob_index.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <protozero/pbf_reader.hpp>
+
+#include "blob_index.hpp"
+
+/// magic bytes at the beginning of an index file, the last character is the version of the format
+static constexpr const char* BLOB_INDEX_MAGIC = "OSMIBLX1";
+
+/// maximum size of a blob header according to the PBF specification
+static constexpr uint32_t MAX_BLOB_HEADER_SIZE = 64 * 1024;
+
+/// maximum size of an uncompressed blob according to the PBF specification
+static constexpr uint32_t MAX_UNCOMPRESSED_BLOB_SIZE = 32 * 1024 * 1024;
+
+/**
+ * Read exactly size bytes. Returns false if the end of the file is reached before the first byte.
+ */
+static bool read_exactly(const int fd, char* buffer, const size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t result = ::read(fd, buffer + done, size - done);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0) {
+            throw std::system_error(errno, std::system_category(), "Reading PBF file for blob index failed");
+        }
+        if (result == 0) {
+            if (done == 0) {
+                return false;
+            }
+            throw std::runtime_error("Blob index: unexpected end of PBF file");
+        }
+        done += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+/**
+ * Get size and modification time of a file.
+ */
+static void file_size_and_mtime(const std::string& filename, uint64_t& size, int64_t& mtime) {
+    struct stat st;
+    if (::stat(filename.c_str(), &st) != 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot stat " + filename);
+    }
+    size = static_cast<uint64_t>(st.st_size);
+    mtime = static_cast<int64_t>(st.st_mtime);
+}
+
+/**
+ * Decompress the blob (message Blob of fileformat.proto).
+ */
+static std::string blob_data(const std::string& blob) {
+    protozero::pbf_reader message(blob);
+    protozero::data_view zlib_data;
+    int32_t raw_size = 0;
+    while (message.next()) {
+        switch (message.tag()) {
+        case 1: // raw
+            return message.get_string();
+        case 2: // raw_size
+            raw_size = message.get_int32();
+            break;
+        case 3: // zlib_data
+            zlib_data = message.get_view();
+            break;
+        case 4: // lzma_data
+        case 6: // lz4_data
+        case 7: // zstd_data
+            throw BlobIndexUnsupportedError("Blob index: only uncompressed and zlib compressed blobs are supported");
+        default:
+            message.skip();
+        }
+    }
+    if (raw_size <= 0 || static_cast<uint32_t>(raw_size) > MAX_UNCOMPRESSED_BLOB_SIZE) {
+        throw std::runtime_error("Blob index: invalid raw_size of blob");
+    }
+    std::string result(static_cast<size_t>(raw_size), '\0');
+    uLongf length = static_cast<uLongf>(raw_size);
+    if (::uncompress(reinterpret_cast<Bytef*>(&result[0]), &length, reinterpret_cast<const Bytef*>(zlib_data.data()),
+            static_cast<uLong>(zlib_data.size())) != Z_OK || length != static_cast<uLongf>(raw_size)) {
+        throw std::runtime_error("Blob index: failed to decompress blob");
+    }
+    return result;
+}
+
+static void update_id_range(BlobIndexEntry& entry, const osmium::object_id_type id) {
+    entry.min_id = std::min(entry.min_id, id);
+    entry.max_id = std::max(entry.max_id, id);
+}
+
+/*static*/ void BlobIndex::parse_primitive_block(const std::string& data, BlobIndexEntry& entry) {
+    protozero::pbf_reader block(data);
+    while (block.next(2)) { // primitivegroup
+        protozero::pbf_reader group = block.get_message();
+        while (group.next()) {
+            switch (group.tag()) {
+            case 1: { // nodes
+                entry.types |= osmium::osm_entity_bits::node;
+                protozero::pbf_reader node = group.get_message();
+                if (node.next(1)) {
+                    update_id_range(entry, node.get_sint64());
+                }
+                break;
+            }
+            case 2: { // dense
+                entry.types |= osmium::osm_entity_bits::node;
+                protozero::pbf_reader dense = group.get_message();
+                if (dense.next(1)) {
+                    osmium::object_id_type id = 0;
+                    for (const int64_t delta : dense.get_packed_sint64()) {
+                        id += delta;
+                        update_id_range(entry, id);
+                    }
+                }
+                break;
+            }
+            case 3: { // ways
+                entry.types |= osmium::osm_entity_bits::way;
+                protozero::pbf_reader way = group.get_message();
+                if (way.next(1)) {
+                    update_id_range(entry, way.get_int64());
+                }
+                break;
+            }
+            case 4: { // relations
+                entry.types |= osmium::osm_entity_bits::relation;
+                protozero::pbf_reader relation = group.get_message();
+                if (relation.next(1)) {
+                    update_id_range(entry, relation.get_int64());
+                }
+                break;
+            }
+            default:
+                group.skip();
+            }
+        }
+    }
+}
+
+void BlobIndex::build(const std::string& pbf_filename) {
+    m_entries.clear();
+    const int fd = ::open(pbf_filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot open " + pbf_filename);
+    }
+    uint64_t offset = 0;
+    std::string header;
+    std::string blob;
+    try {
+        while (true) {
+            unsigned char size_buffer[4];
+            if (!read_exactly(fd, reinterpret_cast<char*>(size_buffer), sizeof(size_buffer))) {
+                break;
+            }
+            const uint32_t header_size = (static_cast<uint32_t>(size_buffer[0]) << 24)
+                    | (static_cast<uint32_t>(size_buffer[1]) << 16)
+                    | (static_cast<uint32_t>(size_buffer[2]) << 8)
+                    | static_cast<uint32_t>(size_buffer[3]);
+            if (header_size > MAX_BLOB_HEADER_SIZE) {
+                throw std::runtime_error("Blob index: invalid BlobHeader size");
+            }
+            header.resize(header_size);
+            read_exactly(fd, &header[0], header_size);
+            std::string type;
+            int32_t data_size = 0;
+            protozero::pbf_reader header_message(header);
+            while (header_message.next()) {
+                switch (header_message.tag()) {
+                case 1: // type
+                    type = header_message.get_string();
+                    break;
+                case 3: // datasize
+                    data_size = header_message.get_int32();
+                    break;
+                default:
+                    header_message.skip();
+                }
+            }
+            if (data_size <= 0 || static_cast<uint32_t>(data_size) > MAX_UNCOMPRESSED_BLOB_SIZE) {
+                throw std::runtime_error("Blob index: invalid blob size");
+            }
+            blob.resize(static_cast<size_t>(data_size));
+            read_exactly(fd, &blob[0], blob.size());
+
+            BlobIndexEntry entry;
+            entry.offset = offset;
+            entry.size = sizeof(size_buffer) + header_size + static_cast<uint64_t>(data_size);
+            entry.min_id = std::numeric_limits<osmium::object_id_type>::max();
+            entry.max_id = std::numeric_limits<osmium::object_id_type>::min();
+            entry.types = 0;
+            if (type == "OSMData") {
+                parse_primitive_block(blob_data(blob), entry);
+            } else if (type != "OSMHeader") {
+                throw std::runtime_error("Blob index: unknown blob type " + type);
+            }
+            if (entry.types == 0) {
+                entry.min_id = 0;
+                entry.max_id = 0;
+            }
+            m_entries.push_back(entry);
+            offset += entry.size;
+        }
+    } catch (...) {
+        ::close(fd);
+        m_entries.clear();
+        throw;
+    }
+    ::close(fd);
+}
+
+bool BlobIndex::load(const std::string& index_filename, const std::string& pbf_filename) {
+    m_entries.clear();
+    FILE* file = fopen(index_filename.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    uint64_t pbf_size;
+    int64_t pbf_mtime;
+    file_size_and_mtime(pbf_filename, pbf_size, pbf_mtime);
+    char magic[8];
+    uint64_t stored_size;
+    int64_t stored_mtime;
+    uint64_t count;
+    bool valid = fread(magic, sizeof(magic), 1, file) == 1
+            && std::equal(magic, magic + sizeof(magic), BLOB_INDEX_MAGIC)
+            && fread(&stored_size, sizeof(stored_size), 1, file) == 1
+            && fread(&stored_mtime, sizeof(stored_mtime), 1, file) == 1
+            && fread(&count, sizeof(count), 1, file) == 1
+            && stored_size == pbf_size && stored_mtime == pbf_mtime;
+    if (valid) {
+        m_entries.resize(count);
+        for (BlobIndexEntry& entry : m_entries) {
+            if (fread(&entry.offset, sizeof(entry.offset), 1, file) != 1
+                    || fread(&entry.size, sizeof(entry.size), 1, file) != 1
+                    || fread(&entry.min_id, sizeof(entry.min_id), 1, file) != 1
+                    || fread(&entry.max_id, sizeof(entry.max_id), 1, file) != 1
+                    || fread(&entry.types, sizeof(entry.types), 1, file) != 1) {
+                valid = false;
+                break;
+            }
+        }
+    }
+    fclose(file);
+    if (!valid) {
+        m_entries.clear();
+    }
+    return valid;
+}
+
+void BlobIndex::save(const std::string& index_filename, const std::string& pbf_filename) const {
+    uint64_t pbf_size;
+    int64_t pbf_mtime;
+    file_size_and_mtime(pbf_filename, pbf_size, pbf_mtime);
+    // Write to a temporary file first. Other processes should never see an incomplete index.
+    std::string tmp_filename = index_filename + ".tmp";
+    FILE* file = fopen(tmp_filename.c_str(), "wb");
+    if (!file) {
+        throw std::system_error(errno, std::system_category(), "Cannot open " + tmp_filename);
+    }
+    const uint64_t count = m_entries.size();
+    bool ok = fwrite(BLOB_INDEX_MAGIC, 8, 1, file) == 1
+            && fwrite(&pbf_size, sizeof(pbf_size), 1, file) == 1
+            && fwrite(&pbf_mtime, sizeof(pbf_mtime), 1, file) == 1
+            && fwrite(&count, sizeof(count), 1, file) == 1;
+    for (const BlobIndexEntry& entry : m_entries) {
+        ok = ok && fwrite(&entry.offset, sizeof(entry.offset), 1, file) == 1
+                && fwrite(&entry.size, sizeof(entry.size), 1, file) == 1
+                && fwrite(&entry.min_id, sizeof(entry.min_id), 1, file) == 1
+                && fwrite(&entry.max_id, sizeof(entry.max_id), 1, file) == 1
+                && fwrite(&entry.types, sizeof(entry.types), 1, file) == 1;
+    }
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(tmp_filename.c_str(), index_filename.c_str()) != 0) {
+        throw std::system_error(errno, std::system_category(), "Writing blob index " + index_filename + " failed");
+    }
+}
+
+const std::vector<BlobIndexEntry>& BlobIndex::entries() const noexcept {
+    return m_entries;
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> BlobIndex::ranges(osmium::osm_entity_bits::type types) const {
+    std::vector<std::pair<uint64_t, uint64_t>> result;
+    for (const BlobIndexEntry& entry : m_entries) {
+        if (entry.types != 0 && (entry.types & types) == 0) {
+            continue;
+        }
+        if (!result.empty() && result.back().first + result.back().second == entry.offset) {
+            result.back().second += entry.size;
+        } else {
+            result.emplace_back(entry.offset, entry.size);
+        }
+    }
+    return result;
+}
+
+osmium::object_id_type BlobIndex::max_id(osmium::osm_entity_bits::type type) const noexcept {
+    osmium::object_id_type result = 0;
+    for (const BlobIndexEntry& entry : m_entries) {
+        if (entry.types & type) {
+            result = std::max(result, entry.max_id);
+        }
+    }
+    return result;
+}
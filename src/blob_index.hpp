@@ -0,0 +1,104 @@
+/*
+ * blob_index.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_BLOB_INDEX_HPP_
+#define SRC_BLOB_INDEX_HPP_
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/types.hpp>
+
+/**
+ * Entry of the blob index, describes one blob of a PBF file.
+ */
+struct BlobIndexEntry {
+    /// offset of the length prefix of the blob header in the file
+    uint64_t offset;
+
+    /// size of the length prefix, the blob header and the blob
+    uint64_t size;
+
+    /// smallest ID of all objects in the blob
+    osmium::object_id_type min_id;
+
+    /// largest ID of all objects in the blob
+    osmium::object_id_type max_id;
+
+    /// types of the objects in the blob (osmium::osm_entity_bits), 0 for the header blob
+    uint8_t types;
+};
+
+/**
+ * Thrown if a blob of the PBF file uses a compression the blob index does not support.
+ */
+struct BlobIndexUnsupportedError : public std::runtime_error {
+    explicit BlobIndexUnsupportedError(const char* what) :
+        std::runtime_error(what) {}
+};
+
+/**
+ * Sidecar index of the blobs of a PBF file.
+ *
+ * Building the index requires to decompress every blob once. Afterwards, the blobs which contain
+ * a given object type can be read without decompressing the others.
+ *
+ * The index file stores the size and the modification time of the PBF file. It is not used if the
+ * PBF file has changed.
+ */
+class BlobIndex {
+
+    std::vector<BlobIndexEntry> m_entries;
+
+    static void parse_primitive_block(const std::string& data, BlobIndexEntry& entry);
+
+public:
+    BlobIndex() = default;
+
+    /**
+     * Read the blobs of a PBF file and build the index.
+     *
+     * \throws BlobIndexUnsupportedError if a blob is compressed with LZMA, LZ4 or Zstandard. The index
+     *         is empty afterwards.
+     * \throws std::runtime_error if the file cannot be read or is not a valid PBF file
+     */
+    void build(const std::string& pbf_filename);
+
+    /**
+     * Load the index from a sidecar file.
+     *
+     * \returns false if the index file does not exist or does not belong to the current version of the PBF file.
+     */
+    bool load(const std::string& index_filename, const std::string& pbf_filename);
+
+    /**
+     * Write the index to a sidecar file.
+     *
+     * \throws std::system_error if the file cannot be written
+     */
+    void save(const std::string& index_filename, const std::string& pbf_filename) const;
+
+    const std::vector<BlobIndexEntry>& entries() const noexcept;
+
+    /**
+     * Get the byte ranges (offset, length) of the header blob and of all blobs containing at least one
+     * of the given types. Adjacent ranges are joined.
+     */
+    std::vector<std::pair<uint64_t, uint64_t>> ranges(osmium::osm_entity_bits::type types) const;
+
+    /**
+     * Get the largest ID of the given type.
+     *
+     * \returns 0 if there is no object of this type.
+     */
+    osmium::object_id_type max_id(osmium::osm_entity_bits::type type) const noexcept;
+};
+
+#endif /* SRC_BLOB_INDEX_HPP_ */
@@ -0,0 +1,114 @@
+/*
+ * candidate_filter.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_CANDIDATE_FILTER_HPP_
+#define SRC_CANDIDATE_FILTER_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+#include <osmium/handler.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/way.hpp>
+
+/**
+ * Set of keys an object has to carry at least one of to be of interest for a handler.
+ *
+ * Most tags of the input have keys which do not share their first byte with any key of the set.
+ * They are rejected by a look-up in a bitmap of first bytes without comparing the strings.
+ */
+class CandidateKeys {
+
+    std::vector<const char*> m_keys;
+
+    /// bit c is set if a key of the set starts with the byte c
+    uint64_t m_first_bytes[4];
+
+    bool first_byte_matches(const char* key) const noexcept {
+        const unsigned char c = static_cast<unsigned char>(*key);
+        return (m_first_bytes[c >> 6] >> (c & 63)) & 1;
+    }
+
+public:
+    CandidateKeys() = delete;
+
+    /**
+     * \param keys keys of the set, the strings have to live as long as the set
+     */
+    CandidateKeys(std::initializer_list<const char*> keys) :
+            m_keys(keys),
+            m_first_bytes() {
+        for (const char* key : m_keys) {
+            const unsigned char c = static_cast<unsigned char>(*key);
+            m_first_bytes[c >> 6] |= uint64_t{1} << (c & 63);
+        }
+    }
+
+    /**
+     * Does the tag list contain a key of the set?
+     */
+    bool matches(const osmium::TagList& tags) const noexcept {
+        for (const osmium::Tag& tag : tags) {
+            if (!first_byte_matches(tag.key())) {
+                continue;
+            }
+            for (const char* key : m_keys) {
+                if (!strcmp(tag.key(), key)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+};
+
+/**
+ * Handler passing only candidates to another handler. Nodes and ways are candidates if they carry
+ * a key of the candidate keys of their type. Relations are always passed.
+ *
+ * The filter belongs behind the location handler in the chain of handlers because the locations of
+ * all nodes are needed to build the geometries of the ways.
+ */
+template <typename THandler>
+class CandidateFilter : public osmium::handler::Handler {
+
+    THandler& m_handler;
+
+    const CandidateKeys& m_node_keys;
+
+    /// keys of way candidates, nullptr if all ways should be passed
+    const CandidateKeys* m_way_keys;
+
+public:
+    CandidateFilter() = delete;
+
+    CandidateFilter(THandler& handler, const CandidateKeys& node_keys, const CandidateKeys* way_keys) :
+        m_handler(handler),
+        m_node_keys(node_keys),
+        m_way_keys(way_keys) {}
+
+    void node(const osmium::Node& node) {
+        if (m_node_keys.matches(node.tags())) {
+            m_handler.node(node);
+        }
+    }
+
+    void way(const osmium::Way& way) {
+        if (!m_way_keys || m_way_keys->matches(way.tags())) {
+            m_handler.way(way);
+        }
+    }
+
+    void relation(const osmium::Relation& relation) {
+        m_handler.relation(relation);
+    }
+};
+
+#endif /* SRC_CANDIDATE_FILTER_HPP_ */
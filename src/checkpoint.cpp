@@ -0,0 +1,188 @@
+/*
+ * checkpoint.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <gdal_priv.h>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+
+#include "checkpoint.hpp"
+#include "directory.hpp"
+
+/**
+ * Read a whole file.
+ */
+static std::string read_file(const std::string& filename) {
+    std::ifstream file {filename, std::ios::binary};
+    if (!file) {
+        throw std::runtime_error{"Cannot read checkpoint file " + filename};
+    }
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+/**
+ * Write a whole file.
+ */
+static void write_file(const std::string& filename, const std::string& content) {
+    std::ofstream file {filename, std::ios::binary | std::ios::trunc};
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    file.close();
+    if (!file) {
+        throw std::system_error(errno, std::system_category(), "Writing checkpoint file " + filename + " failed");
+    }
+}
+
+Checkpoint::Checkpoint(const std::string& directory, osmium::util::VerboseOutput& verbose_output) :
+        m_directory(directory),
+        m_verbose_output(verbose_output) {
+    if (mkdir(m_directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::system_error(errno, std::system_category(), "Cannot create " + m_directory);
+    }
+}
+
+std::string Checkpoint::pass_directory(int pass) const {
+    return m_directory + "/pass" + std::to_string(pass);
+}
+
+/*static*/ std::string Checkpoint::input_id(const std::string& input_filename) {
+    struct stat st;
+    if (::stat(input_filename.c_str(), &st) != 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot stat " + input_filename);
+    }
+    return std::to_string(static_cast<uint64_t>(st.st_size)) + ' ' + std::to_string(static_cast<int64_t>(st.st_mtime));
+}
+
+/*static*/ std::string Checkpoint::options_id(const Options& options) {
+    std::string id;
+    auto add = [&id](const char* name, const std::string& value) {
+        id += name;
+        id += '=';
+        id += value;
+        id += '\n';
+    };
+    add("input_format", options.input_format);
+    add("output_format", options.output_format);
+    add("srs", std::to_string(options.srs));
+    add("bbox", options.bbox);
+    add("polygon", options.polygon_file);
+    add("way_rules", options.way_rules);
+    add("fused", std::to_string(options.fused));
+    add("crossings", std::to_string(options.crossings));
+    add("platforms", std::to_string(options.platforms));
+    add("points", std::to_string(options.points));
+    add("railway_details", std::to_string(options.railway_details));
+    add("stations", std::to_string(options.stations));
+    add("stops", std::to_string(options.stops));
+    return id;
+}
+
+int Checkpoint::completed_pass(const std::string& input_filename, const Options& options) const {
+    const std::string id = input_id(input_filename) + '\n';
+    const std::string expected_options = options_id(options);
+    for (const int pass : {3, 2}) {
+        const std::string marker = pass_directory(pass) + "/.complete";
+        if (access(marker.c_str(), R_OK) != 0) {
+            continue;
+        }
+        const std::string content = read_file(marker);
+        // Checkpoints of another version of the input file are outdated.
+        if (content.compare(0, id.size(), id) != 0) {
+            continue;
+        }
+        if (content.substr(id.size()) != expected_options) {
+            throw std::runtime_error{"Checkpoint " + pass_directory(pass)
+                + " has been written with other options. Use the same options or --checkpoint to start again."};
+        }
+        return pass;
+    }
+    return 0;
+}
+
+void Checkpoint::save(int pass, const std::string& input_filename, const Options& options, OGRWriter& writer,
+        const osmium::ItemStash& must_on_track, const handles_type& must_on_track_handles,
+        const osmium::index::IdSetDense<osmium::unsigned_object_id_type>& point_node_members) {
+    m_verbose_output << "Writing checkpoint after pass " << pass << " ...";
+    const std::string directory = pass_directory(pass);
+    const std::string tmp_directory = directory + ".tmp";
+    remove_directory(tmp_directory);
+    if (mkdir(tmp_directory.c_str(), 0755) != 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot create " + tmp_directory);
+    }
+    {
+        // The layers are copied using the dataset handles of the writer. They see the features of
+        // the transaction which has not been committed yet.
+        Options checkpoint_options = options;
+        checkpoint_options.output_directory = tmp_directory;
+        checkpoint_options.async_output = false;
+        checkpoint_options.bulk_load = false;
+        OGRWriter checkpoint_writer {checkpoint_options, m_verbose_output};
+        std::vector<GDALDataset*> datasets;
+        for (auto& dataset : writer.datasets()) {
+            datasets.push_back(&dataset->get());
+        }
+        checkpoint_writer.merge_datasets({datasets}, false);
+    }
+    // nodes ordered by ID to get the same order of handles after restoring
+    std::vector<std::pair<osmium::object_id_type, osmium::ItemStash::handle_type>> nodes {
+        must_on_track_handles.begin(), must_on_track_handles.end()};
+    std::sort(nodes.begin(), nodes.end());
+    std::string nodes_data;
+    for (const auto& node : nodes) {
+        const osmium::memory::Item& item = must_on_track.get_item(node.second);
+        nodes_data.append(reinterpret_cast<const char*>(item.data()), item.padded_size());
+    }
+    write_file(tmp_directory + "/.must_on_track", nodes_data);
+    std::string via_nodes_data;
+    for (const osmium::unsigned_object_id_type id : point_node_members) {
+        via_nodes_data.append(reinterpret_cast<const char*>(&id), sizeof(id));
+    }
+    write_file(tmp_directory + "/.via_nodes", via_nodes_data);
+    write_file(tmp_directory + "/.complete", input_id(input_filename) + '\n' + options_id(options));
+    remove_directory(directory);
+    if (rename(tmp_directory.c_str(), directory.c_str()) != 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot rename " + tmp_directory);
+    }
+    m_verbose_output << " done\n";
+}
+
+void Checkpoint::restore(int pass, OGRWriter& writer, osmium::ItemStash& must_on_track, handles_type& must_on_track_handles,
+        osmium::index::IdSetDense<osmium::unsigned_object_id_type>& point_node_members) const {
+    const std::string directory = pass_directory(pass);
+    m_verbose_output << "Restoring checkpoint " << directory << " ...";
+    std::vector<GDALDataset*> datasets = OGRWriter::open_datasets(directory);
+    writer.merge_datasets({datasets}, false);
+    for (GDALDataset* dataset : datasets) {
+        GDALClose(dataset);
+    }
+    const std::string nodes_data = read_file(directory + "/.must_on_track");
+    if (!nodes_data.empty()) {
+        osmium::memory::Buffer buffer {nodes_data.size(), osmium::memory::Buffer::auto_grow::yes};
+        std::copy(nodes_data.begin(), nodes_data.end(), buffer.reserve_space(nodes_data.size()));
+        buffer.commit();
+        for (const osmium::Node& node : buffer.select<osmium::Node>()) {
+            must_on_track_handles.emplace(node.id(), must_on_track.add_item(node));
+        }
+    }
+    const std::string via_nodes_data = read_file(directory + "/.via_nodes");
+    for (size_t offset = 0; offset + sizeof(osmium::unsigned_object_id_type) <= via_nodes_data.size();
+            offset += sizeof(osmium::unsigned_object_id_type)) {
+        osmium::unsigned_object_id_type id;
+        std::copy_n(via_nodes_data.data() + offset, sizeof(id), reinterpret_cast<char*>(&id));
+        point_node_members.set(id);
+    }
+    m_verbose_output << " done\n";
+}
@@ -0,0 +1,92 @@
+/*
+ * checkpoint.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_CHECKPOINT_HPP_
+#define SRC_CHECKPOINT_HPP_
+
+#include <string>
+#include <unordered_map>
+
+#include <osmium/index/id_set.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/storage/item_stash.hpp>
+#include <osmium/util/verbose_output.hpp>
+
+#include "ogr_writer.hpp"
+#include "options.hpp"
+
+/**
+ * Checkpoints written after pass 2 and pass 3 to resume an interrupted run.
+ *
+ * A checkpoint is a subdirectory (`pass2`, `pass3`) of the checkpoint directory containing
+ * * a copy of all layers written so far in the output format,
+ * * the nodes which have to be on a track (`.must_on_track`),
+ * * the via nodes of turn restrictions (`.via_nodes`),
+ * * a marker file (`.complete`) identifying the input file and the options affecting the output.
+ *   It is written last.
+ *
+ * A resumed run copies the layers into its output and continues with the next pass without reading
+ * the input for the completed passes.
+ */
+class Checkpoint {
+
+    std::string m_directory;
+
+    osmium::util::VerboseOutput& m_verbose_output;
+
+    std::string pass_directory(int pass) const;
+
+    /**
+     * Size and modification time of the input file.
+     */
+    static std::string input_id(const std::string& input_filename);
+
+    /**
+     * Options which change the content of the checkpoint, one `name=value` per line.
+     */
+    static std::string options_id(const Options& options);
+
+public:
+    using handles_type = std::unordered_map<osmium::object_id_type, osmium::ItemStash::handle_type>;
+
+    Checkpoint() = delete;
+
+    /**
+     * \param directory checkpoint directory, it is created if necessary
+     * \param verbose_output verbose output
+     *
+     * \throws std::system_error if the directory cannot be created
+     */
+    Checkpoint(const std::string& directory, osmium::util::VerboseOutput& verbose_output);
+
+    /**
+     * Get the last pass with a complete checkpoint for this input file.
+     *
+     * \returns number of the pass or 0 if there is none
+     *
+     * \throws std::runtime_error if the checkpoint has been written with different options
+     */
+    int completed_pass(const std::string& input_filename, const Options& options) const;
+
+    /**
+     * Write a checkpoint. An older checkpoint of the same pass is replaced.
+     *
+     * \throws std::system_error or gdalcpp::gdal_error if writing fails
+     */
+    void save(int pass, const std::string& input_filename, const Options& options, OGRWriter& writer,
+            const osmium::ItemStash& must_on_track, const handles_type& must_on_track_handles,
+            const osmium::index::IdSetDense<osmium::unsigned_object_id_type>& point_node_members);
+
+    /**
+     * Restore the state after a pass.
+     *
+     * \throws std::runtime_error if the checkpoint cannot be read
+     */
+    void restore(int pass, OGRWriter& writer, osmium::ItemStash& must_on_track, handles_type& must_on_track_handles,
+            osmium::index::IdSetDense<osmium::unsigned_object_id_type>& point_node_members) const;
+};
+
+#endif /* SRC_CHECKPOINT_HPP_ */
@@ -0,0 +1,52 @@
+/*
+ * directory.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "directory.hpp"
+
+std::vector<std::string> directory_entries(const std::string& directory) {
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        throw std::runtime_error{"Cannot read directory " + directory};
+    }
+    std::vector<std::string> names;
+    while (const dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            names.emplace_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+void remove_directory(const std::string& directory) {
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        return;
+    }
+    while (const dirent* entry = readdir(dir)) {
+        if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+            continue;
+        }
+        const std::string path = directory + '/' + entry->d_name;
+        struct stat file_status;
+        if (lstat(path.c_str(), &file_status) == 0 && S_ISDIR(file_status.st_mode)) {
+            remove_directory(path);
+        } else {
+            unlink(path.c_str());
+        }
+    }
+    closedir(dir);
+    rmdir(directory.c_str());
+}
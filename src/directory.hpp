@@ -0,0 +1,26 @@
+/*
+ * directory.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_DIRECTORY_HPP_
+#define SRC_DIRECTORY_HPP_
+
+#include <string>
+#include <vector>
+
+/**
+ * Get the names of the entries of a directory in alphabetical order. Hidden entries (starting
+ * with a dot) are skipped. They are used for temporary and internal files.
+ *
+ * \throws std::runtime_error if the directory cannot be read
+ */
+std::vector<std::string> directory_entries(const std::string& directory);
+
+/**
+ * Remove a directory and everything in it. Errors are ignored.
+ */
+void remove_directory(const std::string& directory);
+
+#endif /* SRC_DIRECTORY_HPP_ */
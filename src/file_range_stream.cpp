@@ -0,0 +1,96 @@
+/*
+ * file_range_stream.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <iostream>
+#include <system_error>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "file_range_stream.hpp"
+
+/// size of the buffer used to copy from the file to the pipe
+static constexpr size_t COPY_BUFFER_SIZE = 1024 * 1024;
+
+FileRangeStream::FileRangeStream(const std::string& filename, std::vector<std::pair<uint64_t, uint64_t>> ranges) :
+        m_input_fd(::open(filename.c_str(), O_RDONLY)),
+        m_ranges(std::move(ranges)),
+        m_thread() {
+    if (m_input_fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot open " + filename);
+    }
+    if (::pipe(m_pipe) != 0) {
+        const int error = errno;
+        ::close(m_input_fd);
+        throw std::system_error(error, std::system_category(), "Cannot create pipe");
+    }
+    m_thread = std::thread(&FileRangeStream::run, this);
+}
+
+FileRangeStream::~FileRangeStream() {
+    // If the reader has stopped early, the writing thread gets EPIPE now.
+    ::close(m_pipe[0]);
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    ::close(m_input_fd);
+}
+
+std::string FileRangeStream::path() const {
+    return "/dev/fd/" + std::to_string(m_pipe[0]);
+}
+
+void FileRangeStream::run() {
+    // Writing into a pipe without readers should fail with EPIPE instead of killing the process.
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+
+    std::vector<char> buffer(COPY_BUFFER_SIZE);
+    for (const auto& range : m_ranges) {
+        uint64_t offset = range.first;
+        uint64_t remaining = range.second;
+        while (remaining > 0) {
+            const size_t chunk = remaining < buffer.size() ? static_cast<size_t>(remaining) : buffer.size();
+            const ssize_t read_bytes = ::pread(m_input_fd, buffer.data(), chunk, static_cast<off_t>(offset));
+            if (read_bytes < 0 && errno == EINTR) {
+                continue;
+            }
+            if (read_bytes <= 0) {
+                std::cerr << "ERROR: Reading input file at offset " << offset << " failed.\n";
+                ::close(m_pipe[1]);
+                return;
+            }
+            if (!write_to_pipe(buffer.data(), static_cast<size_t>(read_bytes))) {
+                ::close(m_pipe[1]);
+                return;
+            }
+            offset += static_cast<uint64_t>(read_bytes);
+            remaining -= static_cast<uint64_t>(read_bytes);
+        }
+    }
+    ::close(m_pipe[1]);
+}
+
+bool FileRangeStream::write_to_pipe(const char* data, size_t size) {
+    while (size > 0) {
+        const ssize_t result = ::write(m_pipe[1], data, size);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0) {
+            // reader is gone
+            return false;
+        }
+        data += result;
+        size -= static_cast<size_t>(result);
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+/*
+ * file_range_stream.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_FILE_RANGE_STREAM_HPP_
+#define SRC_FILE_RANGE_STREAM_HPP_
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Stream a selection of byte ranges of a file through a pipe.
+ *
+ * A background thread copies the ranges into the pipe. The reading end is available as a path
+ * (`/dev/fd/N`) which can be opened by osmium::io::Reader like a normal file. This way, only the
+ * selected parts of the input file have to be read and decompressed.
+ *
+ * The stream can be read only once. The instance must outlive the reader.
+ */
+class FileRangeStream {
+
+    /// input file
+    int m_input_fd;
+
+    /// read and write end of the pipe
+    int m_pipe[2];
+
+    std::vector<std::pair<uint64_t, uint64_t>> m_ranges;
+
+    std::thread m_thread;
+
+    void run();
+
+    /**
+     * Write the buffer completely into the pipe.
+     *
+     * \returns false if the reader is gone
+     */
+    bool write_to_pipe(const char* data, size_t size);
+
+public:
+    FileRangeStream() = delete;
+
+    FileRangeStream(const FileRangeStream&) = delete;
+
+    FileRangeStream& operator=(const FileRangeStream&) = delete;
+
+    /**
+     * \param filename file to read from
+     * \param ranges byte ranges (offset, length) to copy into the pipe in the given order
+     *
+     * \throws std::system_error if the file cannot be opened or the pipe cannot be created
+     */
+    FileRangeStream(const std::string& filename, std::vector<std::pair<uint64_t, uint64_t>> ranges);
+
+    ~FileRangeStream();
+
+    /**
+     * Path of the reading end of the pipe.
+     */
+    std::string path() const;
+};
+
+#endif /* SRC_FILE_RANGE_STREAM_HPP_ */
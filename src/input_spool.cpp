@@ -0,0 +1,161 @@
+/*
+ * input_spool.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "input_spool.hpp"
+
+/// size of the buffer used to copy the input
+static constexpr size_t COPY_BUFFER_SIZE = 1024 * 1024;
+
+/**
+ * Write the buffer completely.
+ *
+ * \returns false if writing failed
+ */
+static bool write_all(const int fd, const char* data, size_t size) {
+    while (size > 0) {
+        const ssize_t result = ::write(fd, data, size);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0) {
+            return false;
+        }
+        data += result;
+        size -= static_cast<size_t>(result);
+    }
+    return true;
+}
+
+/**
+ * Get the suffix of the file name (e.g. `.osm.pbf`) which is used to detect the file format.
+ */
+static std::string file_suffix(const std::string& filename) {
+    const size_t slash = filename.rfind('/');
+    const size_t dot = filename.find('.', slash == std::string::npos ? 0 : slash + 1);
+    return dot == std::string::npos ? "" : filename.substr(dot);
+}
+
+/*static*/ bool InputSpool::needed(const std::string& input_filename) {
+    struct stat st;
+    return input_filename == "-" || (stat(input_filename.c_str(), &st) == 0 && !S_ISREG(st.st_mode));
+}
+
+InputSpool::InputSpool(const std::string& input_filename, const std::string& directory) :
+        m_input_fd(input_filename == "-" ? 0 : ::open(input_filename.c_str(), O_RDONLY)),
+        m_spool_fd(-1),
+        m_suffix(file_suffix(input_filename)),
+        m_spool_filename(directory + "/.input_spool.XXXXXX" + m_suffix),
+        m_thread() {
+    if (m_input_fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot open " + input_filename);
+    }
+    // Keep the suffix to let the file format be detected from the name of the temporary file.
+    m_spool_fd = ::mkstemps(&m_spool_filename[0], static_cast<int>(m_suffix.size()));
+    if (m_spool_fd < 0) {
+        const int error = errno;
+        if (m_input_fd > 0) {
+            ::close(m_input_fd);
+        }
+        throw std::system_error(error, std::system_category(), "Cannot create " + m_spool_filename);
+    }
+    if (::pipe(m_pipe) != 0) {
+        const int error = errno;
+        ::close(m_spool_fd);
+        ::unlink(m_spool_filename.c_str());
+        if (m_input_fd > 0) {
+            ::close(m_input_fd);
+        }
+        throw std::system_error(error, std::system_category(), "Cannot create pipe");
+    }
+    m_thread = std::thread(&InputSpool::run, this);
+}
+
+InputSpool::~InputSpool() {
+    if (m_pipe[0] >= 0) {
+        ::close(m_pipe[0]);
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    ::close(m_spool_fd);
+    ::unlink(m_spool_filename.c_str());
+    if (m_input_fd > 0) {
+        ::close(m_input_fd);
+    }
+}
+
+std::string InputSpool::stream_path() const {
+    return "/dev/fd/" + std::to_string(m_pipe[0]);
+}
+
+std::string InputSpool::format() const {
+    return m_suffix.empty() ? "" : m_suffix.substr(1);
+}
+
+void InputSpool::finish() {
+    // The reader of the pipe might not have read until the end. Closing the pipe lets the copying
+    // thread continue with the temporary file only.
+    ::close(m_pipe[0]);
+    m_pipe[0] = -1;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    if (m_failed) {
+        throw std::runtime_error{"Spooling the input to " + m_spool_filename + " failed."};
+    }
+}
+
+const std::string& InputSpool::filename() const noexcept {
+    return m_spool_filename;
+}
+
+void InputSpool::run() {
+    // Writing into a pipe without readers should fail with EPIPE instead of killing the process.
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+
+    std::vector<char> buffer(COPY_BUFFER_SIZE);
+    bool pipe_open = true;
+    while (true) {
+        const ssize_t read_bytes = ::read(m_input_fd, buffer.data(), buffer.size());
+        if (read_bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (read_bytes < 0) {
+            std::cerr << "ERROR: Reading the input failed.\n";
+            m_failed = true;
+            break;
+        }
+        if (read_bytes == 0) {
+            break;
+        }
+        if (!write_all(m_spool_fd, buffer.data(), static_cast<size_t>(read_bytes))) {
+            std::cerr << "ERROR: Writing to " << m_spool_filename << " failed.\n";
+            m_failed = true;
+            break;
+        }
+        if (pipe_open && !write_all(m_pipe[1], buffer.data(), static_cast<size_t>(read_bytes))) {
+            // reader is gone
+            pipe_open = false;
+        }
+    }
+    ::close(m_pipe[1]);
+}
@@ -0,0 +1,90 @@
+/*
+ * input_spool.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_INPUT_SPOOL_HPP_
+#define SRC_INPUT_SPOOL_HPP_
+
+#include <string>
+#include <thread>
+
+/**
+ * Spool an input which can be read only once (STDIN, pipes) to a temporary file.
+ *
+ * A background thread copies the input into the temporary file and into a pipe at the same time.
+ * The first pass reads from the pipe (`stream_path()`) while the input arrives. All later passes
+ * read the temporary file (`filename()`). This way, the input is read only once and written only
+ * once.
+ *
+ * The temporary file is removed by the destructor.
+ */
+class InputSpool {
+
+    int m_input_fd;
+
+    int m_spool_fd;
+
+    /// read and write end of the pipe
+    int m_pipe[2];
+
+    /// suffix of the input file name, e.g. `.osm.pbf`
+    std::string m_suffix;
+
+    std::string m_spool_filename;
+
+    std::thread m_thread;
+
+    /// set by the copying thread if reading the input or writing the temporary file failed
+    bool m_failed = false;
+
+    void run();
+
+public:
+    InputSpool() = delete;
+
+    InputSpool(const InputSpool&) = delete;
+
+    InputSpool& operator=(const InputSpool&) = delete;
+
+    /**
+     * Does this input have to be spooled because it cannot be read multiple times?
+     */
+    static bool needed(const std::string& input_filename);
+
+    /**
+     * \param input_filename name of the input file, `-` for STDIN
+     * \param directory directory to create the temporary file in
+     *
+     * \throws std::system_error if the input or the temporary file cannot be opened or the pipe cannot be created
+     */
+    InputSpool(const std::string& input_filename, const std::string& directory);
+
+    ~InputSpool();
+
+    /**
+     * Path of the reading end of the pipe. It can be read only once.
+     */
+    std::string stream_path() const;
+
+    /**
+     * Format of the input as detected from the suffix of its name, empty if the name has no suffix.
+     * The pipe has no suffix, therefore the format has to be passed to the reader.
+     */
+    std::string format() const;
+
+    /**
+     * Wait until the input has been copied completely. Closes the pipe.
+     *
+     * \throws std::runtime_error if copying failed
+     */
+    void finish();
+
+    /**
+     * Name of the temporary file. It is complete after finish() has been called.
+     */
+    const std::string& filename() const noexcept;
+};
+
+#endif /* SRC_INPUT_SPOOL_HPP_ */
@@ -0,0 +1,139 @@
+/*
+ * location_cache.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <osmium/index/index.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/reader.hpp>
+
+#include "location_cache.hpp"
+
+LocationCache::LocationCache(const std::string& directory, const osmium::io::File& input_file) :
+        m_directory(directory),
+        m_key(),
+        m_temporary_filename() {
+    struct stat st;
+    if (::stat(input_file.filename().c_str(), &st) != 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot stat " + input_file.filename());
+    }
+    std::string timestamp;
+    {
+        osmium::io::Reader reader {input_file, osmium::osm_entity_bits::nothing};
+        timestamp = reader.header().get("osmosis_replication_timestamp");
+        reader.close();
+    }
+    if (timestamp.empty()) {
+        timestamp = std::to_string(static_cast<int64_t>(st.st_mtime));
+    }
+    m_key = std::to_string(static_cast<uint64_t>(st.st_size)) + '-' + timestamp;
+}
+
+std::string LocationCache::filename(bool dense) const {
+    return m_directory + "/locations-" + m_key + (dense ? ".dense" : ".sparse");
+}
+
+std::string LocationCache::find() const {
+    for (const bool dense : {true, false}) {
+        if (access(filename(dense).c_str(), R_OK) == 0) {
+            return filename(dense);
+        }
+    }
+    return "";
+}
+
+std::string LocationCache::writable_index_type(const std::string& index_type) {
+    m_dense = index_type.find("dense") != std::string::npos;
+    // Several processes may write the same index at the same time.
+    m_temporary_filename = filename(m_dense) + ".tmp" + std::to_string(getpid());
+    return std::string{m_dense ? "dense_file_array," : "sparse_file_array,"} + m_temporary_filename;
+}
+
+void LocationCache::commit() {
+    if (m_temporary_filename.empty()) {
+        return;
+    }
+    if (rename(m_temporary_filename.c_str(), filename(m_dense).c_str()) != 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot rename " + m_temporary_filename);
+    }
+    m_temporary_filename.clear();
+}
+
+/**
+ * Open a file read-only and return its file descriptor.
+ */
+static int open_readonly(const std::string& filename) {
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot open " + filename);
+    }
+    return fd;
+}
+
+/**
+ * Get the size of an open file.
+ */
+static size_t file_size(const int fd) {
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot stat location cache");
+    }
+    return static_cast<size_t>(st.st_size);
+}
+
+CachedLocationMap::CachedLocationMap(const std::string& filename) :
+        m_fd(open_readonly(filename)),
+        m_dense(filename.size() > 6 && filename.compare(filename.size() - 6, 6, ".dense") == 0),
+        m_size(file_size(m_fd) / (m_dense ? sizeof(osmium::Location) : sizeof(sparse_element_type))),
+        m_mapping(file_size(m_fd), osmium::util::MemoryMapping::mapping_mode::readonly, m_fd) {
+}
+
+CachedLocationMap::~CachedLocationMap() noexcept {
+    m_mapping.unmap();
+    ::close(m_fd);
+}
+
+osmium::Location CachedLocationMap::get(const osmium::unsigned_object_id_type id) const {
+    const osmium::Location location = get_noexcept(id);
+    if (!location) {
+        throw osmium::not_found{id};
+    }
+    return location;
+}
+
+osmium::Location CachedLocationMap::get_noexcept(const osmium::unsigned_object_id_type id) const noexcept {
+    if (m_dense) {
+        if (id >= m_size) {
+            return osmium::Location{};
+        }
+        return m_mapping.get_addr<osmium::Location>()[id];
+    }
+    const sparse_element_type* begin = m_mapping.get_addr<sparse_element_type>();
+    const sparse_element_type* end = begin + m_size;
+    const sparse_element_type* it = std::lower_bound(begin, end, id,
+            [](const sparse_element_type& element, const osmium::unsigned_object_id_type value) {
+        return element.first < value;
+    });
+    if (it == end || it->first != id) {
+        return osmium::Location{};
+    }
+    return it->second;
+}
+
+size_t CachedLocationMap::size() const {
+    return m_size;
+}
+
+size_t CachedLocationMap::used_memory() const {
+    return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * location_cache.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_LOCATION_CACHE_HPP_
+#define SRC_LOCATION_CACHE_HPP_
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include <osmium/index/map.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+/**
+ * A directory of location indexes which are reused by later runs on the same input file.
+ *
+ * The files have the same format as the indexes `dense_file_array` and `sparse_file_array` of
+ * Osmium. Their names contain the size of the input file and its replication timestamp (or its
+ * modification time if the header has no replication timestamp), e.g.
+ * `locations-123456789-2026-10-18T00:00:00Z.dense`. A file is written under a temporary name and
+ * renamed after pass 2 has completed. Therefore, all files with the right name are valid.
+ */
+class LocationCache {
+
+    std::string m_directory;
+
+    /// size and timestamp of the input file
+    std::string m_key;
+
+    /// name of the index being written, empty if no index is written
+    std::string m_temporary_filename;
+
+    bool m_dense = false;
+
+    std::string filename(bool dense) const;
+
+public:
+    LocationCache() = delete;
+
+    /**
+     * \param directory directory of the cache, it has to exist
+     * \param input_file input file whose locations are cached
+     *
+     * \throws std::system_error if the input file cannot be accessed
+     */
+    LocationCache(const std::string& directory, const osmium::io::File& input_file);
+
+    /**
+     * Get the name of a valid index for the input file.
+     *
+     * \returns the file name or an empty string if there is none
+     */
+    std::string find() const;
+
+    /**
+     * Get the configuration of a file-backed index to be passed to osmium::index::MapFactory::create_map().
+     * The index is written under a temporary name.
+     *
+     * \param index_type type of the index which would be used without the cache. The cache uses a
+     *        dense index if this is a dense index and a sparse index otherwise.
+     */
+    std::string writable_index_type(const std::string& index_type);
+
+    /**
+     * Make the written index available to later runs.
+     */
+    void commit();
+};
+
+/**
+ * A location index of the cache mapped read-only into memory.
+ *
+ * Locations are only looked up. Calls of `set()` are ignored because the index is complete
+ * already. This way, NodeLocationsForWays can be used unchanged.
+ */
+class CachedLocationMap : public osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location> {
+
+    using sparse_element_type = std::pair<osmium::unsigned_object_id_type, osmium::Location>;
+
+    int m_fd;
+
+    bool m_dense;
+
+    /// number of elements in the file
+    size_t m_size;
+
+    osmium::util::MemoryMapping m_mapping;
+
+public:
+    /**
+     * \param filename file name returned by LocationCache::find()
+     *
+     * \throws std::system_error if the file cannot be opened
+     */
+    explicit CachedLocationMap(const std::string& filename);
+
+    ~CachedLocationMap() noexcept override;
+
+    void set(const osmium::unsigned_object_id_type /*id*/, const osmium::Location /*value*/) final {
+    }
+
+    osmium::Location get(const osmium::unsigned_object_id_type id) const final;
+
+    osmium::Location get_noexcept(const osmium::unsigned_object_id_type id) const noexcept final;
+
+    size_t size() const final;
+
+    /**
+     * The mapped file is not counted because it is shared with the page cache.
+     */
+    size_t used_memory() const final;
+
+    void clear() final {
+    }
+};
+
+#endif /* SRC_LOCATION_CACHE_HPP_ */
@@ -0,0 +1,49 @@
+/*
+ * location_filter.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include "location_filter.hpp"
+#include "railway_handler_pass1.hpp"
+
+LocationFilter::LocationFilter(RouteManager& route_manager, Options& options) :
+        m_route_manager(route_manager),
+        m_options(options),
+        m_shard(options),
+        m_route_ways(),
+        m_nodes() {}
+
+bool LocationFilter::enabled() const noexcept {
+    return m_options.filter_locations;
+}
+
+void LocationFilter::relation(const osmium::Relation& relation) {
+    if (!m_route_manager.new_relation(relation)) {
+        return;
+    }
+    for (const osmium::RelationMember& member : relation.members()) {
+        if (member.type() == osmium::item_type::way) {
+            m_route_ways.set(member.positive_ref());
+        }
+    }
+}
+
+void LocationFilter::way(const osmium::Way& way) {
+    // The relations of other shards have been skipped by the route manager already.
+    if (!m_route_ways.get(way.positive_id())
+            && !(m_shard.owns(way) && RailwayHandlerPass1::needs_way_geometry(way, m_options))) {
+        return;
+    }
+    for (const osmium::NodeRef& nd_ref : way.nodes()) {
+        m_nodes.set(nd_ref.positive_ref());
+    }
+}
+
+void LocationFilter::after_ways() {
+    m_route_ways.clear();
+}
+
+bool LocationFilter::node_needed(const osmium::object_id_type id) const noexcept {
+    return m_nodes.get(static_cast<osmium::unsigned_object_id_type>(id));
+}
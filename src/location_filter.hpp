@@ -0,0 +1,96 @@
+/*
+ * location_filter.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_LOCATION_FILTER_HPP_
+#define SRC_LOCATION_FILTER_HPP_
+
+#include <osmium/handler.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+
+#include "options.hpp"
+#include "route_manager.hpp"
+#include "shard.hpp"
+
+/**
+ * This class collects the IDs of all nodes whose locations are needed to build the geometries of
+ * the output.
+ *
+ * Geometries of ways are needed for the members of the routes and for the ways written to the
+ * platforms_l and stations_l layers. Nodes carry their location themselves. In sharded mode, only
+ * the routes and ways owned by the shard are taken into account.
+ *
+ * Usage: Call relation() for all relations (pass 1), then way() for all ways (an additional pass
+ * reading ways only). Afterwards, node_needed() answers if a location has to be stored.
+ */
+class LocationFilter : public osmium::handler::Handler {
+
+    RouteManager& m_route_manager;
+
+    Options& m_options;
+
+    Shard m_shard;
+
+    /// ways which are members of a route handled by the route manager
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> m_route_ways;
+
+    /// nodes whose locations are needed
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> m_nodes;
+
+public:
+    LocationFilter() = delete;
+
+    LocationFilter(RouteManager& route_manager, Options& options);
+
+    /**
+     * Is the filter enabled? If not, all locations are needed.
+     */
+    bool enabled() const noexcept;
+
+    void relation(const osmium::Relation& relation);
+
+    void way(const osmium::Way& way);
+
+    /**
+     * To be called after the last way. Releases the memory which is not needed any more.
+     */
+    void after_ways();
+
+    bool node_needed(const osmium::object_id_type id) const noexcept;
+};
+
+/**
+ * This handler passes only the nodes accepted by a LocationFilter to a location handler.
+ * Ways are always passed to the location handler.
+ */
+template <typename TLocationHandler>
+class FilteredLocationHandler : public osmium::handler::Handler {
+
+    TLocationHandler& m_location_handler;
+
+    const LocationFilter& m_filter;
+
+public:
+    FilteredLocationHandler() = delete;
+
+    FilteredLocationHandler(TLocationHandler& location_handler, const LocationFilter& filter) :
+        m_location_handler(location_handler),
+        m_filter(filter) {}
+
+    void node(const osmium::Node& node) {
+        if (!m_filter.enabled() || m_filter.node_needed(node.id())) {
+            m_location_handler.node(node);
+        }
+    }
+
+    void way(osmium::Way& way) {
+        m_location_handler.way(way);
+    }
+};
+
+#endif /* SRC_LOCATION_FILTER_HPP_ */
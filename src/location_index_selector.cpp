@@ -0,0 +1,119 @@
+/*
+ * location_index_selector.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <algorithm>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <osmium/index/map.hpp>
+#include <osmium/io/any_input.hpp>
+#include <osmium/osm/location.hpp>
+
+#include "location_index_selector.hpp"
+
+/// Nodes per byte of a PBF file. Measured on a planet file and rounded up.
+static constexpr double NODES_PER_PBF_BYTE = 0.15;
+
+/// number of nodes in the planet, used if the size of the input is unknown, rounded up
+static constexpr uint64_t PLANET_NODE_COUNT = 11000000000ULL;
+
+/// used as highest node ID if there is no blob index, rounded up
+static constexpr uint64_t ESTIMATED_MAX_NODE_ID = 14000000000ULL;
+
+/// area of the world in square degrees
+static constexpr double WORLD_AREA = 360.0 * 180.0;
+
+/**
+ * Memory used per node by a sparse in-memory index. It stores ID and location (16 bytes).
+ * The vector grows by doubling its capacity, therefore we add 50 %.
+ */
+static constexpr uint64_t SPARSE_BYTES_PER_NODE = 24;
+
+/// memory used per possible node ID by a dense index
+static constexpr uint64_t DENSE_BYTES_PER_ID = sizeof(osmium::Location);
+
+/// Memory pages of a dense index are only allocated if they are used. Each node uses at most one page.
+static constexpr uint64_t DENSE_BYTES_PER_NODE = 4096;
+
+/// Share of the budget reserved for the other data structures (relations, stashes, GDAL caches).
+static constexpr double RESERVED_SHARE = 0.2;
+
+static constexpr uint64_t MEGABYTE = 1024 * 1024;
+
+LocationIndexSelector::LocationIndexSelector(Options& options, osmium::util::VerboseOutput& verbose_output) :
+        m_options(options),
+        m_verbose_output(verbose_output) {}
+
+uint64_t LocationIndexSelector::estimate_node_count(const osmium::io::File& input_file) {
+    struct stat st;
+    const std::string& input_filename = input_file.filename();
+    if (input_filename.empty() || input_filename == "-" || stat(input_filename.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        // Pipes cannot be inspected without consuming them.
+        m_verbose_output << "  input file size unknown, assuming a planet file\n";
+        return PLANET_NODE_COUNT;
+    }
+    m_verbose_output << "  input file size: " << (static_cast<uint64_t>(st.st_size) / MEGABYTE) << " MB\n";
+    osmium::io::Reader reader(input_file, osmium::osm_entity_bits::nothing);
+    const osmium::Box box = reader.header().box();
+    reader.close();
+    if (box.valid()) {
+        const double share = std::min(1.0, box.size() / WORLD_AREA);
+        m_verbose_output << "  bounding box in header covers " << static_cast<int>(share * 100) << " % of the world\n";
+        // The node density varies a lot. Therefore, the bounding box only limits the estimate.
+        return std::min(static_cast<uint64_t>(st.st_size * NODES_PER_PBF_BYTE),
+                static_cast<uint64_t>(PLANET_NODE_COUNT * share) + 1);
+    }
+    return static_cast<uint64_t>(st.st_size * NODES_PER_PBF_BYTE);
+}
+
+uint64_t LocationIndexSelector::memory_budget() const {
+    uint64_t budget = m_options.max_memory * MEGABYTE;
+    if (budget == 0) {
+        budget = static_cast<uint64_t>(sysconf(_SC_PHYS_PAGES)) * static_cast<uint64_t>(sysconf(_SC_PAGE_SIZE));
+    }
+    return static_cast<uint64_t>(budget * (1.0 - RESERVED_SHARE));
+}
+
+std::string LocationIndexSelector::select(const osmium::io::File& input_file, const BlobIndex& blob_index,
+        const std::string& index_filename) {
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+    m_verbose_output << "Selecting location index:\n";
+    const uint64_t node_count = estimate_node_count(input_file);
+    uint64_t max_id = static_cast<uint64_t>(blob_index.max_id(osmium::osm_entity_bits::node));
+    if (max_id == 0) {
+        max_id = ESTIMATED_MAX_NODE_ID;
+        m_verbose_output << "  highest node ID (estimated): " << max_id << '\n';
+    } else {
+        m_verbose_output << "  highest node ID (from blob index): " << max_id << '\n';
+    }
+    const uint64_t dense_size = std::min(max_id * DENSE_BYTES_PER_ID, node_count * DENSE_BYTES_PER_NODE);
+    const uint64_t sparse_size = node_count * SPARSE_BYTES_PER_NODE;
+    const uint64_t budget = memory_budget();
+    m_verbose_output << "  estimated number of nodes: " << node_count << '\n'
+            << "  estimated size of a dense index: " << (dense_size / MEGABYTE) << " MB\n"
+            << "  estimated size of a sparse index: " << (sparse_size / MEGABYTE) << " MB\n"
+            << "  memory budget for the index: " << (budget / MEGABYTE) << " MB\n";
+
+    std::string result;
+    const bool dense_preferred = dense_size < sparse_size;
+    const char* dense_mem = map_factory.has_map_type("dense_mmap_array") ? "dense_mmap_array" : "dense_mem_array";
+    if (dense_preferred && dense_size <= budget) {
+        result = dense_mem;
+    } else if (sparse_size <= budget) {
+        result = "sparse_mem_array";
+    } else if (dense_size <= budget) {
+        result = dense_mem;
+    } else if (dense_preferred) {
+        result = "dense_file_array,";
+        result += index_filename;
+    } else {
+        result = "sparse_file_array,";
+        result += index_filename;
+    }
+    m_verbose_output << "  selected location index: " << result << '\n';
+    return result;
+}
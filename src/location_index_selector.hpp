@@ -0,0 +1,58 @@
+/*
+ * location_index_selector.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_LOCATION_INDEX_SELECTOR_HPP_
+#define SRC_LOCATION_INDEX_SELECTOR_HPP_
+
+#include <cstdint>
+#include <string>
+
+#include <osmium/io/file.hpp>
+#include <osmium/util/verbose_output.hpp>
+
+#include "blob_index.hpp"
+#include "options.hpp"
+
+/**
+ * Choose the type of the location index if the user requested the index type `auto`.
+ *
+ * The choice is based on estimates of the number of nodes (derived from the size of the input
+ * file or the bounding box in its header) and of the highest node ID (taken from the blob index if
+ * available). In-memory indexes are preferred. If none of them fits into the memory budget, a
+ * file-backed index is used.
+ */
+class LocationIndexSelector {
+
+    Options& m_options;
+
+    osmium::util::VerboseOutput& m_verbose_output;
+
+    /**
+     * Estimate the number of nodes in the input file.
+     */
+    uint64_t estimate_node_count(const osmium::io::File& input_file);
+
+    /**
+     * Memory available for the location index in bytes.
+     */
+    uint64_t memory_budget() const;
+
+public:
+    LocationIndexSelector() = delete;
+
+    LocationIndexSelector(Options& options, osmium::util::VerboseOutput& verbose_output);
+
+    /**
+     * Get the configuration string of the index to be passed to osmium::index::MapFactory::create_map().
+     *
+     * \param input_file input file
+     * \param blob_index blob index of the input file, may be empty
+     * \param index_filename name of the file used if a file-backed index is chosen
+     */
+    std::string select(const osmium::io::File& input_file, const BlobIndex& blob_index, const std::string& index_filename);
+};
+
+#endif /* SRC_LOCATION_INDEX_SELECTOR_HPP_ */
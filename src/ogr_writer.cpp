@@ -5,13 +5,19 @@
  *      Author: Michael Reichert <michael.reichert@geofabrik.de>
  */
 
-#include "ogr_writer.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <tuple>
 
-OGRWriter::OGRWriter(Options& options, osmium::util::VerboseOutput& verbose_output) :
-    m_verbose_output(verbose_output),
-    m_options(options),
-    m_datasets() {
-}
+#include <cpl_vsi.h>
+#include <gdal_version.h>
+#include <ogr_spatialref.h>
+
+#include "directory.hpp"
+#include "ogr_writer.hpp"
 
 
 /**
@@ -28,6 +34,119 @@ bool case_insensitive_comp_left(const std::string& a, const std::string& b) {
     );
 }
 
+OGRWriter::OGRWriter(Options& options, osmium::util::VerboseOutput& verbose_output) :
+    m_verbose_output(verbose_output),
+    m_options(options),
+    m_datasets(),
+    m_dataset_filenames(),
+    m_layers(),
+    m_targets(),
+    m_target_layers(),
+    m_pending_features(),
+    m_output_queue(MAX_OUTPUT_QUEUE_SIZE, "ogr_writer"),
+    m_output_thread(),
+    m_output_failed(false),
+    m_output_error() {
+    for (const OutputTarget& output_target : m_options.output_targets) {
+        std::unique_ptr<Target> target {new Target()};
+        target->options = m_options;
+        target->options.output_targets.clear();
+        target->options.output_format = output_target.format;
+        target->options.srs = output_target.srs;
+        target->options.output_directory = output_target.directory;
+        // The features are written by the output thread of this writer.
+        target->options.async_output = false;
+        target->options.bulk_load = m_options.bulk_load && case_insensitive_comp_left(output_target.format, "sqlite");
+        target->writer.reset(new OGRWriter(target->options, m_verbose_output));
+        if (output_target.srs != m_options.srs) {
+            OGRSpatialReference source;
+            OGRSpatialReference destination;
+            source.importFromEPSG(m_options.srs);
+            destination.importFromEPSG(output_target.srs);
+#if GDAL_VERSION_MAJOR >= 3
+            source.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+            destination.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+#endif
+            target->transformation.reset(OGRCreateCoordinateTransformation(&source, &destination));
+            if (!target->transformation) {
+                throw std::runtime_error{"Cannot transform from EPSG:" + std::to_string(m_options.srs)
+                    + " to EPSG:" + std::to_string(output_target.srs)};
+            }
+        }
+        m_targets.push_back(std::move(target));
+    }
+}
+
+OGRWriter::~OGRWriter() {
+    // The datasets have to outlive the output thread.
+    try {
+        flush();
+    } catch (std::exception& err) {
+        std::cerr << "ERROR: " << err.what() << '\n';
+    }
+}
+
+void OGRWriter::run_output_thread() {
+    while (true) {
+        std::vector<OutputFeature> batch;
+        m_output_queue.wait_and_pop(batch);
+        if (batch.empty()) {
+            return;
+        }
+        if (m_output_failed) {
+            // Continue draining the queue to avoid blocking the handlers.
+            continue;
+        }
+        try {
+            for (OutputFeature& feature : batch) {
+                feature.write();
+            }
+        } catch (...) {
+            m_output_error = std::current_exception();
+            m_output_failed = true;
+        }
+    }
+}
+
+void OGRWriter::add_feature(OutputFeature&& feature) {
+    if (!m_options.async_output) {
+        feature.write();
+        return;
+    }
+    if (m_output_failed) {
+        // rethrow the exception of the output thread
+        flush();
+    }
+    if (!m_output_thread.joinable()) {
+        m_output_thread = std::thread(&OGRWriter::run_output_thread, this);
+    }
+    m_pending_features.push_back(std::move(feature));
+    if (m_pending_features.size() >= OUTPUT_BATCH_SIZE) {
+        m_output_queue.push(std::move(m_pending_features));
+        m_pending_features.clear();
+        m_pending_features.reserve(OUTPUT_BATCH_SIZE);
+    }
+}
+
+void OGRWriter::flush() {
+    if (!m_output_thread.joinable()) {
+        return;
+    }
+    if (!m_pending_features.empty()) {
+        m_output_queue.push(std::move(m_pending_features));
+        m_pending_features.clear();
+    }
+    m_output_queue.push(std::vector<OutputFeature>{});
+    m_output_thread.join();
+    if (m_output_failed) {
+        std::exception_ptr error = m_output_error;
+        m_output_error = nullptr;
+        m_output_failed = false;
+        std::rethrow_exception(error);
+    }
+}
+
+
 bool OGRWriter::one_layer_per_datasource_only() {
     return case_insensitive_comp_left(m_options.output_format, "geojson")
         || case_insensitive_comp_left(m_options.output_format, "esri shapefile");
@@ -43,6 +162,13 @@ std::string OGRWriter::filename_suffix() {
 }
 
 void OGRWriter::rename_output_files(const std::string& view_name) {
+    flush();
+    for (auto& target : m_targets) {
+        target->writer->rename_output_files(view_name);
+    }
+    if (m_options.bulk_load) {
+        write_bulk_loaded_datasets();
+    }
     if (m_datasets.size() == 1 && filename_suffix().length()) {
         // rename output file if there is one output dataset only
         std::string destination_name {m_options.output_directory};
@@ -52,30 +178,105 @@ void OGRWriter::rename_output_files(const std::string& view_name) {
         if (access(destination_name.c_str(), F_OK) == 0) {
             std::cerr << "ERROR: Cannot rename output file from to " << destination_name << " because file exists already.\n";
         } else {
-            if (rename(m_datasets.front()->dataset_name().c_str(), destination_name.c_str())) {
-                std::cerr << "ERROR: Rename from " << m_datasets.front()->dataset_name() << " to " << destination_name << "failed.\n";
+            if (rename(m_dataset_filenames.front().c_str(), destination_name.c_str())) {
+                std::cerr << "ERROR: Rename from " << m_dataset_filenames.front() << " to " << destination_name << "failed.\n";
             }
         }
     } else if (m_datasets.size() > 1 && filename_suffix().length()) {
-        for (auto& d: m_datasets) {
-            std::string destination_name = d->dataset_name();
+        for (auto& filename: m_dataset_filenames) {
+            std::string destination_name = filename;
             destination_name += filename_suffix();
             if (access(destination_name.c_str(), F_OK) == 0) {
                 std::cerr << "ERROR: Cannot rename output file from to " << destination_name << " because file exists already.\n";
             } else {
-                if (rename(d->dataset_name().c_str(), destination_name.c_str())) {
-                    std::cerr << "ERROR: Rename from " << m_datasets.front()->dataset_name() << " to " << destination_name << "failed.\n";
+                if (rename(filename.c_str(), destination_name.c_str())) {
+                    std::cerr << "ERROR: Rename from " << filename << " to " << destination_name << "failed.\n";
                 }
             }
         }
     }
 }
 
+OGRWriter::datasets_type& OGRWriter::datasets() {
+    flush();
+    return m_datasets;
+}
+
+std::vector<std::pair<std::string, int64_t>> OGRWriter::feature_counts() {
+    flush();
+    std::vector<std::pair<std::string, int64_t>> result;
+    for (auto& d : m_datasets) {
+        if (!d) {
+            continue;
+        }
+        for (int l = 0; l < d->get().GetLayerCount(); ++l) {
+            OGRLayer* layer = d->get().GetLayer(l);
+            result.emplace_back(layer->GetName(), static_cast<int64_t>(layer->GetFeatureCount()));
+        }
+    }
+    return result;
+}
+
+void OGRWriter::write_bulk_loaded_datasets() {
+    for (size_t i = 0; i < m_datasets.size(); ++i) {
+        if (!m_datasets[i]) {
+            continue;
+        }
+        m_verbose_output << "Creating spatial indexes of " << m_dataset_filenames[i] << " ...";
+        GDALDataset& dataset = m_datasets[i]->get();
+        for (int l = 0; l < dataset.GetLayerCount(); ++l) {
+            OGRLayer* layer = dataset.GetLayer(l);
+            std::string sql = "SELECT CreateSpatialIndex('";
+            sql += layer->GetName();
+            sql += "', '";
+            sql += layer->GetGeometryColumn();
+            sql += "')";
+            // CreateSpatialIndex() returns 1 on success.
+            bool created = false;
+            OGRLayer* result = dataset.ExecuteSQL(sql.c_str(), nullptr, nullptr);
+            if (result) {
+                OGRFeature* feature = result->GetNextFeature();
+                created = feature && feature->GetFieldAsInteger(0) == 1;
+                OGRFeature::DestroyFeature(feature);
+                dataset.ReleaseResultSet(result);
+            }
+            if (!created) {
+                std::cerr << "ERROR: Creating the spatial index of layer " << layer->GetName() << " in "
+                        << m_dataset_filenames[i] << " failed.\n";
+            }
+        }
+        m_verbose_output << " done\n";
+        const std::string memory_name = m_datasets[i]->dataset_name();
+        // closing the dataset commits the last transaction
+        m_datasets[i].reset();
+        m_verbose_output << "Writing " << m_dataset_filenames[i] << " ...";
+        vsi_l_offset length = 0;
+        GByte* data = VSIGetMemFileBuffer(memory_name.c_str(), &length, FALSE);
+        std::ofstream file(m_dataset_filenames[i], std::ios::binary);
+        if (!data || !file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(length))) {
+            std::cerr << "ERROR: Writing " << m_dataset_filenames[i] << " failed.\n";
+        }
+        VSIUnlink(memory_name.c_str());
+        m_verbose_output << " done\n";
+    }
+}
+
 void OGRWriter::ensure_writeable_dataset(const char* layer_name) {
+    flush();
     if (m_datasets.empty() || one_layer_per_datasource_only()) {
         std::string output_filename = m_options.output_directory;
         output_filename += '/';
         output_filename += layer_name;
+        m_dataset_filenames.push_back(output_filename);
+        if (m_options.bulk_load) {
+            // The database is built in memory and copied to the output file at the end.
+            // The main output and the additional outputs have layers with the same names. Therefore,
+            // the name of the in-memory file contains the address of the writer.
+            output_filename = "/vsimem/osmi_pubtrans3_";
+            output_filename += std::to_string(reinterpret_cast<uintptr_t>(this));
+            output_filename += '_';
+            output_filename += layer_name;
+        }
         std::unique_ptr<gdalcpp::Dataset> ds {new gdalcpp::Dataset(m_options.output_format,
                 output_filename, gdalcpp::SRS(m_options.srs), get_gdal_default_dataset_options(m_options.output_format))};
         m_datasets.push_back(std::move(ds));
@@ -86,19 +287,54 @@ void OGRWriter::ensure_writeable_dataset(const char* layer_name) {
 gdalcpp::Layer OGRWriter::create_layer(const char* layer_name, OGRwkbGeometryType type) {
     ensure_writeable_dataset(layer_name);
     const std::vector<std::string>& options = get_gdal_default_layer_options(m_options.output_format);
-    return gdalcpp::Layer(*(m_datasets.back()), layer_name, type, options);
+    m_layers.emplace_back(*(m_datasets.back()), layer_name, type, options);
+    create_target_layers(layer_name, type);
+    return m_layers.back();
 }
 
 std::unique_ptr<gdalcpp::Layer> OGRWriter::create_layer_ptr(const char* layer_name, OGRwkbGeometryType type) {
     ensure_writeable_dataset(layer_name);
     const std::vector<std::string>& options = get_gdal_default_layer_options(m_options.output_format);
-    return std::unique_ptr<gdalcpp::Layer>{new gdalcpp::Layer(*(m_datasets.back()), layer_name, type, options)};
+    m_layers.emplace_back(*(m_datasets.back()), layer_name, type, options);
+    create_target_layers(layer_name, type);
+    return std::unique_ptr<gdalcpp::Layer>{new gdalcpp::Layer(m_layers.back())};
+}
+
+void OGRWriter::create_target_layers(const char* layer_name, OGRwkbGeometryType type) {
+    if (m_targets.empty()) {
+        return;
+    }
+    std::vector<target_layer_type>& layers = m_target_layers[&m_layers.back().get()];
+    for (auto& target : m_targets) {
+        layers.push_back(target_layer_type{target->writer->create_layer(layer_name, type), target->transformation.get(),
+                target->options.srs == 3857 && m_options.srs != 3857});
+    }
+}
+
+std::vector<OGRWriter::target_layer_type>& OGRWriter::target_layers(gdalcpp::Layer& layer) {
+    static std::vector<target_layer_type> no_layers;
+    if (m_targets.empty()) {
+        return no_layers;
+    }
+    auto it = m_target_layers.find(&layer.get());
+    if (it == m_target_layers.end()) {
+        return no_layers;
+    }
+    OGRFeatureDefn* definition = layer.get().GetLayerDefn();
+    for (target_layer_type& target_layer : it->second) {
+        // The fields are added by the handlers after the layer has been created.
+        for (int f = target_layer.layer.get().GetLayerDefn()->GetFieldCount(); f < definition->GetFieldCount(); ++f) {
+            OGRFieldDefn* field = definition->GetFieldDefn(f);
+            target_layer.layer.add_field(field->GetNameRef(), field->GetType(), field->GetWidth());
+        }
+    }
+    return it->second;
 }
 
 std::vector<std::string> OGRWriter::get_gdal_default_dataset_options(std::string& output_format) {
     std::vector<std::string> default_options;
     // default layer creation options
-    if (output_format == "SQlite") {
+    if (case_insensitive_comp_left(output_format, "sqlite")) {
         CPLSetConfigOption("OGR_SQLITE_PRAGMA", "journal_mode=OFF,TEMP_STORE=MEMORY,temp_store=memory,LOCKING_MODE=EXCLUSIVE");
         CPLSetConfigOption("OGR_SQLITE_CACHE", "600");
         CPLSetConfigOption("OGR_SQLITE_JOURNAL", "OFF");
@@ -113,7 +349,7 @@ std::vector<std::string> OGRWriter::get_gdal_default_dataset_options(std::string
 std::vector<std::string> OGRWriter::get_gdal_default_layer_options(std::string& output_format) {
     std::vector<std::string> default_options;
     // default layer creation options
-    if (output_format == "SQlite") {
+    if (case_insensitive_comp_left(output_format, "sqlite")) {
         default_options.emplace_back("SPATIAL_INDEX=NO");
         default_options.emplace_back("COMPRESS_GEOM=NO");
     } else if (output_format == "ESRI Shapefile") {
@@ -121,3 +357,114 @@ std::vector<std::string> OGRWriter::get_gdal_default_layer_options(std::string&
     }
     return default_options;
 }
+
+/*static*/ void OGRWriter::merge_layers(gdalcpp::Layer& destination, std::vector<OGRLayer*>& sources) {
+    // next feature of each source layer, nullptr if the source layer is exhausted
+    std::vector<OGRFeature*> heads;
+    for (OGRLayer* source : sources) {
+        source->ResetReading();
+        heads.push_back(source->GetNextFeature());
+    }
+    while (true) {
+        size_t next = heads.size();
+        for (size_t i = 0; i < heads.size(); ++i) {
+            if (heads[i] && (next == heads.size()
+                    || heads[i]->GetFieldAsInteger64(0) < heads[next]->GetFieldAsInteger64(0))) {
+                next = i;
+            }
+        }
+        if (next == heads.size()) {
+            break;
+        }
+        OGRFeature* feature = OGRFeature::CreateFeature(destination.get().GetLayerDefn());
+        feature->SetFrom(heads[next]);
+        // The feature IDs of the sources overlap. Let the destination assign new ones.
+        feature->SetFID(OGRNullFID);
+        destination.create_feature(feature);
+        OGRFeature::DestroyFeature(feature);
+        OGRFeature::DestroyFeature(heads[next]);
+        heads[next] = sources[next]->GetNextFeature();
+    }
+}
+
+/*static*/ void OGRWriter::merge_layers_by_id(gdalcpp::Layer& destination, std::vector<OGRLayer*>& sources) {
+    // (OSM ID, source index, feature ID) of all features
+    std::vector<std::tuple<int64_t, size_t, GIntBig>> order;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        sources[i]->ResetReading();
+        while (OGRFeature* feature = sources[i]->GetNextFeature()) {
+            order.emplace_back(feature->GetFieldAsInteger64(0), i, feature->GetFID());
+            OGRFeature::DestroyFeature(feature);
+        }
+    }
+    std::sort(order.begin(), order.end());
+    for (const auto& entry : order) {
+        OGRFeature* source_feature = sources[std::get<1>(entry)]->GetFeature(std::get<2>(entry));
+        OGRFeature* feature = OGRFeature::CreateFeature(destination.get().GetLayerDefn());
+        feature->SetFrom(source_feature);
+        // The feature IDs of the sources overlap. Let the destination assign new ones.
+        feature->SetFID(OGRNullFID);
+        destination.create_feature(feature);
+        OGRFeature::DestroyFeature(feature);
+        OGRFeature::DestroyFeature(source_feature);
+    }
+}
+
+/*static*/ std::vector<GDALDataset*> OGRWriter::open_datasets(const std::string& directory) {
+    std::vector<GDALDataset*> result;
+    for (const std::string& name : directory_entries(directory)) {
+        const std::string path = directory + '/' + name;
+        GDALDataset* dataset = static_cast<GDALDataset*>(GDALOpenEx(path.c_str(),
+                GDAL_OF_VECTOR | GDAL_OF_READONLY, nullptr, nullptr, nullptr));
+        if (!dataset) {
+            for (GDALDataset* d : result) {
+                GDALClose(d);
+            }
+            throw std::runtime_error{"Cannot open dataset " + path};
+        }
+        result.push_back(dataset);
+    }
+    return result;
+}
+
+void OGRWriter::merge_datasets(const std::vector<std::vector<GDALDataset*>>& sources, bool sort_by_id /* = true */) {
+    if (sources.empty()) {
+        return;
+    }
+    flush();
+    for (GDALDataset* first_dataset : sources.front()) {
+        for (int l = 0; l < first_dataset->GetLayerCount(); ++l) {
+            OGRLayer* first_layer = first_dataset->GetLayer(l);
+            auto existing = std::find_if(m_layers.begin(), m_layers.end(), [first_layer](gdalcpp::Layer& layer) {
+                return !strcmp(layer.get().GetName(), first_layer->GetName());
+            });
+            std::unique_ptr<gdalcpp::Layer> destination;
+            if (existing != m_layers.end()) {
+                destination.reset(new gdalcpp::Layer(*existing));
+            } else {
+                OGRFeatureDefn* definition = first_layer->GetLayerDefn();
+                destination = create_layer_ptr(first_layer->GetName(), definition->GetGeomType());
+                for (int f = 0; f < definition->GetFieldCount(); ++f) {
+                    OGRFieldDefn* field = definition->GetFieldDefn(f);
+                    destination->add_field(field->GetNameRef(), field->GetType(), field->GetWidth());
+                }
+            }
+            std::vector<OGRLayer*> layers;
+            for (const auto& datasets : sources) {
+                for (GDALDataset* dataset : datasets) {
+                    OGRLayer* layer = dataset->GetLayerByName(first_layer->GetName());
+                    if (layer) {
+                        layers.push_back(layer);
+                        break;
+                    }
+                }
+            }
+            // The routes are written in the order they are completed, therefore the layers are not ordered.
+            if (sort_by_id) {
+                merge_layers_by_id(*destination, layers);
+            } else {
+                merge_layers(*destination, layers);
+            }
+        }
+    }
+}
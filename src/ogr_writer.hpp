@@ -8,22 +8,63 @@
 #ifndef SRC_OGR_WRITER_HPP_
 #define SRC_OGR_WRITER_HPP_
 
+#include <atomic>
+#include <exception>
 #include <memory>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <gdalcpp.hpp>
+#include <osmium/thread/queue.hpp>
 #include <osmium/util/verbose_output.hpp>
 #include "options.hpp"
+#include "output_feature.hpp"
 
 /**
  * This class manages the output datasets and serves as factory for layers.
+ *
+ * If Options::async_output is set, features are written by an output thread. The handlers hand
+ * batches of features over to it using a bounded queue. The handlers have to wait if the queue
+ * is full. All other operations on the datasets wait until the queue is empty.
+ *
+ * The writer can write the same features to several outputs (Options::output_targets). The
+ * geometries are built once in the SRS of the main output and transformed for each additional
+ * output.
  */
 class OGRWriter {
 public:
 
     using datasets_type = std::vector<std::unique_ptr<gdalcpp::Dataset>>;
 
+    /// layer of an additional output
+    struct target_layer_type {
+        gdalcpp::Layer layer;
+
+        /// transformation of the geometries into the SRS of the output, nullptr if not needed
+        OGRCoordinateTransformation* transformation;
+
+        /// The output uses Web Mercator but the main output does not. Polar geometries have to be skipped.
+        bool mercator;
+    };
+
 private:
 
+    struct transformation_deleter {
+        void operator()(OGRCoordinateTransformation* transformation) const noexcept {
+            OGRCoordinateTransformation::DestroyCT(transformation);
+        }
+    };
+
+    /**
+     * An additional output with its own writer.
+     */
+    struct Target {
+        Options options;
+        std::unique_ptr<OGRWriter> writer;
+        std::unique_ptr<OGRCoordinateTransformation, transformation_deleter> transformation;
+    };
+
     /// reference to output manager for STDERR
     osmium::util::VerboseOutput& m_verbose_output;
 
@@ -35,8 +76,40 @@ private:
     // 'm_options' has a deleted copy constructor".
     datasets_type m_datasets;
 
+    /// names of the output files of the datasets (without suffix), they differ from the dataset names in bulk-load mode
+    std::vector<std::string> m_dataset_filenames;
+
+    /// all layers created by this writer
+    std::vector<gdalcpp::Layer> m_layers;
+
+    /// additional outputs
+    std::vector<std::unique_ptr<Target>> m_targets;
+
+    /// layers of the additional outputs by the layer of this writer they mirror
+    std::unordered_map<const OGRLayer*, std::vector<target_layer_type>> m_target_layers;
+
     const std::vector<std::string> GDAL_DEFAULT_OPTIONS;
 
+    /// features not handed over to the output thread yet
+    std::vector<OutputFeature> m_pending_features;
+
+    /// batches of features to be written by the output thread, an empty batch stops the thread
+    osmium::thread::Queue<std::vector<OutputFeature>> m_output_queue;
+
+    std::thread m_output_thread;
+
+    /// set by the output thread if writing failed
+    std::atomic<bool> m_output_failed;
+
+    /// exception thrown on the output thread, only accessed after the thread has been joined
+    std::exception_ptr m_output_error;
+
+    /// number of features handed over to the output thread at once
+    static constexpr size_t OUTPUT_BATCH_SIZE = 1000;
+
+    /// maximum number of batches in the queue
+    static constexpr size_t MAX_OUTPUT_QUEUE_SIZE = 64;
+
     /// maximum length of a string field
     static constexpr size_t MAX_FIELD_LENGTH = 254;
 
@@ -80,13 +153,60 @@ private:
      */
     static std::vector<std::string> get_gdal_default_layer_options(std::string& output_format);
 
+    void run_output_thread();
+
+    /**
+     * Create the layers mirroring the last layer of this writer in the additional outputs.
+     */
+    void create_target_layers(const char* layer_name, OGRwkbGeometryType type);
+
+    /**
+     * Create the spatial indexes of all datasets built in memory and copy them to their output files.
+     */
+    void write_bulk_loaded_datasets();
+
 public:
     OGRWriter() = delete;
 
     OGRWriter(Options& options, osmium::util::VerboseOutput& verbose_output);
 
+    ~OGRWriter();
+
+    /**
+     * Write a feature or queue it for the output thread.
+     *
+     * \throws gdalcpp::gdal_error if writing this or an earlier feature failed
+     */
+    void add_feature(OutputFeature&& feature);
+
+    /**
+     * Wait until all queued features have been written.
+     *
+     * \throws gdalcpp::gdal_error if writing a feature failed
+     */
+    void flush();
+
+    /**
+     * Rename the output files of this writer and the additional outputs.
+     */
     void rename_output_files(const std::string& view_name);
 
+    /**
+     * Get the layers of the additional outputs mirroring a layer of this writer. Fields added to
+     * the layer since the last call are added to them. This is called by OutputFeature.
+     */
+    std::vector<target_layer_type>& target_layers(gdalcpp::Layer& layer);
+
+    /**
+     * Get the number of features of all layers of all datasets.
+     */
+    std::vector<std::pair<std::string, int64_t>> feature_counts();
+
+    /**
+     * Get the datasets after all queued features have been written.
+     */
+    datasets_type& datasets();
+
     /**
      * Add a new dataset to the vector if the last one cannot be use for multiple layers
      */
@@ -97,6 +217,52 @@ public:
 
     //TODO check if it is better to keep a vector of layers and return a pointer on stack only
     std::unique_ptr<gdalcpp::Layer> create_layer_ptr(const char* layer_name, OGRwkbGeometryType type);
+
+    /**
+     * Copy all features of a set of layers into one layer.
+     *
+     * All layers must have the same schema and the first field has to contain the ID of the
+     * OSM object. If each source layer is ordered by this ID, the destination layer will be ordered by
+     * it as well.
+     *
+     * \param destination layer to write to
+     * \param sources layers to read from
+     */
+    static void merge_layers(gdalcpp::Layer& destination, std::vector<OGRLayer*>& sources);
+
+    /**
+     * Copy all features of a set of layers into one layer ordered by the ID in the first field.
+     *
+     * Unlike merge_layers(), the source layers do not have to be ordered. Features with the same ID
+     * are ordered by source layer and feature ID. The features are read by feature ID. This is fast
+     * for drivers supporting random access (e.g. Memory, SQLite, GPKG) only.
+     *
+     * \param destination layer to write to
+     * \param sources layers to read from
+     */
+    static void merge_layers_by_id(gdalcpp::Layer& destination, std::vector<OGRLayer*>& sources);
+
+    /**
+     * Open all datasets in a directory read-only. Hidden files are skipped.
+     *
+     * The datasets have to be closed using GDALClose().
+     *
+     * \throws std::runtime_error if the directory cannot be read or a file is no dataset
+     */
+    static std::vector<GDALDataset*> open_datasets(const std::string& directory);
+
+    /**
+     * Copy the layers of several sets of datasets into the layers of this writer ordered by the ID in
+     * the first field using merge_layers_by_id().
+     *
+     * The layers of the first set define the order and the schema of the layers. Layers which have been
+     * created by this writer already are reused.
+     *
+     * \param sources sets of datasets, e.g. the outputs of several processes
+     * \param sort_by_id Sort the features by ID. If false, the layers are merged using merge_layers().
+     *        A single set of datasets is copied in its original order then.
+     */
+    void merge_datasets(const std::vector<std::vector<GDALDataset*>>& sources, bool sort_by_id = true);
 };
 
 #endif /* SRC_OGR_WRITER_HPP_ */
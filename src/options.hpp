@@ -8,12 +8,75 @@
 #ifndef SRC_OPTIONS_HPP_
 #define SRC_OPTIONS_HPP_
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * An additional output written from the same geometries as the main output.
+ */
+struct OutputTarget {
+    std::string format;
+    int srs;
+    std::string directory;
+};
+
 struct Options {
     std::string location_index_type = "sparse_mem_array";
     std::string output_format = "SQlite";
+    /// format of the input file, empty if it should be detected from the file name suffix
+    std::string input_format = "";
     std::string output_directory = "";
     int srs = 3857;
+    /// outputs written in addition to the main output
+    std::vector<OutputTarget> output_targets;
     bool verbose = false;
+    /// bounding box (MINLON,MINLAT,MAXLON,MAXLAT) the output is clipped to, empty if there is none
+    std::string bbox = "";
+    /// polygon file the output is clipped to, empty if there is none
+    std::string polygon_file = "";
+    /// path of the JSON file to write statistics to, empty if no statistics should be written
+    std::string stats_file = "";
+    /// Build SQLite datasets in memory, copy them to disk at the end and create spatial indexes.
+    bool bulk_load = false;
+    /// Write the features on a separate output thread.
+    bool async_output = true;
+    /// Run the checks of the third pass (points, nodes not on a track) during the second pass.
+    bool fused = false;
+    /// number of threads running RailwayHandlerPass1 in pass 2
+    int threads = 1;
+    /// number of threads validating the routes, 1 if they are validated on the reading thread
+    int route_threads = 1;
+    /// number of worker processes in sharded mode, 1 if the conversion runs in this process
+    int shards = 1;
+    /// index of the shard a worker process is responsible for
+    int shard_index = 0;
+    /// directory of the checkpoints written after pass 2 and 3, empty if no checkpoints should be written
+    std::string checkpoint_directory = "";
+    /// Continue after the last pass saved in the checkpoint directory.
+    bool resume = false;
+    /// directory of the state store used by --update, empty if no state should be kept
+    std::string state_directory = "";
+    /// change file to apply to the state store and the output, empty for a full run
+    std::string update_file = "";
+    /// port of the local HTTP server answering validation requests, 0 if no server should be run
+    int serve_port = 0;
+    /// directory of the change files the server may apply, empty if the server must not apply changes
+    std::string serve_changes_directory = "";
+    /// path of the blob index sidecar file, empty if no blob index should be used
+    std::string blob_index = "";
+    /// memory budget in MB used to choose the location index type `auto`, 0 means physical memory
+    uint64_t max_memory = 0;
+    /// Store only the locations of nodes which are referenced by ways needing a geometry.
+    bool filter_locations = false;
+    /// directory of location indexes reused by later runs on the same input, empty if not used
+    std::string location_cache = "";
+    /// route snapshot written by a full run, empty if no snapshot should be written
+    std::string snapshot = "";
+    /// route snapshot to validate again instead of reading an OSM file, empty for a normal run
+    std::string revalidate = "";
+    /// file with the rules which ways the routes may use, empty for the built-in rules
+    std::string way_rules = "";
     bool crossings = true;
     bool platforms = true;
     bool points = true;
@@ -7,25 +7,46 @@
 
 #include <string>
 #include <iostream>
+#include <stdexcept>
 #include <getopt.h>
+#include <strings.h>
+#include <unistd.h>
 
 #include <osmium/area/assembler.hpp>
 #include <osmium/area/multipolygon_collector.hpp>
 // the indexes themselves have to be included first
+#include <osmium/index/map/dense_file_array.hpp>
 #include <osmium/index/map/dense_mmap_array.hpp>
+#include <osmium/index/map/sparse_file_array.hpp>
 #include <osmium/index/map/sparse_mmap_array.hpp>
 #include <osmium/index/map/dense_mem_array.hpp>
 #include <osmium/index/map/sparse_mem_array.hpp>
 #include <osmium/handler/node_locations_for_ways.hpp>
 #include <osmium/io/any_input.hpp>
-#include <osmium/relations/manager_util.hpp>
 #include <osmium/visitor.hpp>
 
+#include "blob_index.hpp"
+#include "candidate_filter.hpp"
+#include "checkpoint.hpp"
+#include "file_range_stream.hpp"
+#include "input_spool.hpp"
+#include "location_cache.hpp"
+#include "location_filter.hpp"
+#include "location_index_selector.hpp"
 #include "ogr_writer.hpp"
 #include "railway_handler_pass1.hpp"
 #include "railway_handler_pass2.hpp"
+#include "railway_handler_pool.hpp"
+#include "region.hpp"
 #include "route_manager.hpp"
+#include "route_server.hpp"
+#include "route_snapshot.hpp"
+#include "route_updater.hpp"
+#include "shard.hpp"
+#include "state_store.hpp"
+#include "statistics.hpp"
 #include "turn_restriction_handler.hpp"
+#include "way_rules.hpp"
 
 using index_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
 using location_handler_type = osmium::handler::NodeLocationsForWays<index_type>;
@@ -34,12 +55,66 @@ void print_help(char* arg0) {
     std::cerr << "Usage: " << arg0 << " [OPTIONS] INFILE OUTPUT_DIRECTORY\n" \
               << "General Options:\n" \
               << "  -h, --help           This help message.\n" \
+              << "  --add-output=FORMAT,EPSG,DIR\n" \
+              << "                       Write the same layers in format FORMAT and projection EPSG to the\n" \
+              << "                       directory DIR in addition to the main output. Can be repeated.\n" \
+              << "  --bbox=MINLON,MINLAT,MAXLON,MAXLAT\n" \
+              << "                       Write only objects inside this bounding box and routes with at\n" \
+              << "                       least one member inside it.\n" \
+              << "  --blob-index=FILE    Use (and create if necessary) an index of the blobs of the PBF input\n" \
+              << "                       file to skip blobs which are not needed by a pass.\n" \
+              << "                       Other formats and PBF files with LZMA, LZ4 or Zstandard compressed\n" \
+              << "                       blobs are read without it.\n" \
+              << "  --bulk-load          Build the SQLite output in memory, write it to disk at the end and\n" \
+              << "                       create spatial indexes. The output has to fit into memory.\n" \
+              << "  --checkpoint=DIR     Save the state after pass 2 and pass 3 in DIR.\n" \
               << "  -f, --format         Output format (default: SQlite)\n" \
-              << "  -i, --index          Set index type for location index (default: sparse_mem_array)\n";
+              << "  --fused              Do the checks of the third pass during the second pass.\n" \
+              << "                       The input file has to be sorted by type and ID.\n" \
+              << "  --input-format=FMT   Format of the input file (default: detected from the file name,\n" \
+              << "                       pbf if reading from STDIN)\n" \
+              << "  -i, --index          Set index type for location index (default: sparse_mem_array)\n" \
+              << "                       Use 'auto' to choose the index type by the input size and --max-memory.\n" \
+              << "  --location-cache=DIR Reuse the location index written to DIR by an earlier run on the same\n" \
+              << "                       input file (same size and replication timestamp) or write it there.\n" \
+              << "                       Not used with --filter-locations, --bbox, --polygon and --shards.\n" \
+              << "  --polygon=FILE       Like --bbox but use the polygon in FILE (Osmosis .poly format).\n" \
+              << "  --revalidate=FILE    Validate the routes in the snapshot FILE again and write the route\n" \
+              << "                       layers. Usage: --revalidate=FILE OUTPUT_DIRECTORY\n" \
+              << "  --route-threads=NUM  Number of threads validating the routes and writing the route layers\n" \
+              << "                       (default: 1). The routes are ordered by relation ID if NUM > 1.\n" \
+              << "  --resume=DIR         Like --checkpoint but continue after the last pass saved in DIR if the\n" \
+              << "                       input file and the options affecting the output have not changed.\n" \
+              << "  --max-memory=MB      Memory budget used by '-i auto' (default: physical memory)\n" \
+              << "  --filter-locations   Store only locations of nodes which are needed for the output.\n" \
+              << "                       This requires an additional pass reading the ways.\n";
 #ifndef ONLYMERCATOROUTPUT
     std::cerr << "  -s EPSG, --srs=ESPG  Output projection (EPSG code) (default: 3857)\n";
 #endif
-    std::cerr << "  -v, --verbose        Verbose output\n" \
+    std::cerr << "  --serve=PORT         Answer validation requests for single routes on http://localhost:PORT/\n" \
+              << "                       using the objects in --state (GET /route/ID).\n" \
+              << "                       Usage: --state=DIR --serve=PORT [--serve-changes=DIR OUTPUT_DIRECTORY]\n" \
+              << "  --serve-changes=DIR  Let the server apply change files in DIR to the state and the output\n" \
+              << "                       in OUTPUT_DIRECTORY like --update (POST /update?file=NAME).\n" \
+              << "  --shards=NUM         Split the work between NUM worker processes. Each worker reads the\n" \
+              << "                       whole input and converts the routes and nodes whose ID modulo NUM\n" \
+              << "                       is its number. It stores only the node locations needed for them\n" \
+              << "                       (implies --filter-locations). The outputs of the workers are merged\n" \
+              << "                       at the end.\n" \
+              << "  --state=DIR          Keep the objects needed by --update and the locations of all nodes\n" \
+              << "                       in DIR. The location index is a dense_file_array in DIR.\n" \
+              << "  --snapshot=FILE      Write the routes and their members to the snapshot FILE which can be\n" \
+              << "                       validated again with --revalidate without reading the input.\n" \
+              << "  --stats=FILE         Write timings, throughput and memory usage as JSON to FILE.\n" \
+              << "                       With --shards, the numbers of all workers are added up.\n" \
+              << "  -t, --threads=NUM    Number of threads creating the stops, platforms, stations\n" \
+              << "                       and crossings layers in pass 2 (default: 1)\n" \
+              << "  --update=OSC         Apply a change file to the state in --state and update the route\n" \
+              << "                       layers of the output in OUTPUT_DIRECTORY. Usage:\n" \
+              << "                       --state=DIR --update=OSC OUTPUT_DIRECTORY\n" \
+              << "  -v, --verbose        Verbose output\n" \
+              << "  --way-rules=FILE     Check the member ways of the routes with the rules in FILE instead of\n" \
+              << "                       the built-in rules. Snapshots keep only the keys of the built-in rules.\n" \
               << "\n" \
               << "Content Related Options:\n" \
               << "--no-crossings        Don't write the crossings layer.\n" \
@@ -51,6 +126,327 @@ void print_help(char* arg0) {
               << "                      are mapped on the way which represents the track.\n";
 }
 
+/**
+ * Get the input file for a pass which reads only some types of objects.
+ *
+ * If a blob index is available, only the blobs containing these types are read.
+ *
+ * \param input_filename name of the input file
+ * \param input_format format of the input file, empty if it should be detected from the file name
+ * \param blob_index blob index, may be empty
+ * \param types types of objects read by the pass
+ * \param stream stream of the selected blobs. It has to outlive the reader of the returned file.
+ */
+osmium::io::File open_input(const std::string& input_filename, const std::string& input_format,
+        const BlobIndex& blob_index, osmium::osm_entity_bits::type types, std::unique_ptr<FileRangeStream>& stream) {
+    if (blob_index.entries().empty()) {
+        return osmium::io::File(input_filename, input_format);
+    }
+    stream.reset(new FileRangeStream(input_filename, blob_index.ranges(types)));
+    return osmium::io::File(stream->path(), "pbf");
+}
+
+/**
+ * Load the blob index or build it if it does not exist or belongs to another version of the input file.
+ *
+ * If the input file is no PBF file or contains blobs which cannot be indexed, a warning is printed
+ * and the index stays empty. The input is read without an index then.
+ */
+void load_or_build_blob_index(BlobIndex& blob_index, const std::string& index_filename, const std::string& input_filename,
+        const std::string& input_format, osmium::util::VerboseOutput& verbose_output) {
+    if (osmium::io::File(input_filename, input_format).format() != osmium::io::file_format::pbf) {
+        std::cerr << "WARNING: A blob index is supported for PBF files only. Reading " << input_filename
+                << " without a blob index.\n";
+        return;
+    }
+    if (blob_index.load(index_filename, input_filename)) {
+        return;
+    }
+    verbose_output << "Building blob index " << index_filename << " ...";
+    try {
+        blob_index.build(input_filename);
+    } catch (BlobIndexUnsupportedError& err) {
+        verbose_output << " failed\n";
+        std::cerr << "WARNING: " << err.what() << ". Reading " << input_filename << " without a blob index.\n";
+        return;
+    }
+    blob_index.save(index_filename, input_filename);
+    verbose_output << " done\n";
+}
+
+/**
+ * Convert the input file.
+ *
+ * In sharded mode, this function runs in a worker process and converts the part of the input
+ * owned by the shard only. The output files are not renamed because they are merged later.
+ */
+void convert(Options& options, std::string input_filename) {
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+
+    osmium::util::VerboseOutput verbose_output(options.verbose);
+    OGRWriter writer {options, verbose_output};
+    RouteManager route_manager(writer, options, verbose_output);
+
+    std::unique_ptr<Region> region;
+    if (!options.bbox.empty()) {
+        region.reset(new Region(Region::from_bbox(options.bbox)));
+    } else if (!options.polygon_file.empty()) {
+        region.reset(new Region(Region::from_poly_file(options.polygon_file)));
+    }
+    if (region) {
+        route_manager.set_region(region.get());
+        // Routes crossing the boundary are completed from the full input. Only the locations of
+        // the nodes of their ways are needed outside the region.
+        options.filter_locations = true;
+    }
+
+    std::unique_ptr<RouteSnapshotWriter> snapshot;
+    if (!options.snapshot.empty()) {
+        snapshot.reset(new RouteSnapshotWriter(options.snapshot));
+        route_manager.set_snapshot(snapshot.get());
+    }
+
+    // Nodes and ways not owned by this shard are skipped by the railway handlers.
+    const Shard shard {options};
+    if (options.shards > 1) {
+        // Each worker stores only the locations needed for the routes and ways it owns.
+        options.filter_locations = true;
+    }
+
+    // The objects needed for later updates and the locations of all nodes are kept in the state store.
+    std::unique_ptr<StateStore> state;
+    if (!options.state_directory.empty()) {
+        state.reset(new StateStore(options.state_directory, true));
+        options.location_index_type = "dense_file_array," + state->locations_filename();
+    }
+    StateStoreHandler state_handler(state.get(), route_manager);
+
+    BlobIndex blob_index;
+    if (!options.blob_index.empty()) {
+        load_or_build_blob_index(blob_index, options.blob_index, input_filename, options.input_format, verbose_output);
+    }
+
+    // Inputs which can be read only once are copied to a temporary file while pass 1 reads them.
+    std::unique_ptr<InputSpool> spool;
+    if (InputSpool::needed(input_filename)) {
+        verbose_output << "Spooling input to a temporary file in " << options.output_directory << '\n';
+        spool.reset(new InputSpool(input_filename, options.output_directory));
+    }
+
+    Statistics statistics;
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> point_node_members;
+    LocationFilter location_filter(route_manager, options);
+
+    // last pass restored from a checkpoint, the passes up to it are skipped
+    std::unique_ptr<Checkpoint> checkpoint;
+    int resume_pass = 0;
+    if (!options.checkpoint_directory.empty()) {
+        checkpoint.reset(new Checkpoint(options.checkpoint_directory, verbose_output));
+        if (options.resume) {
+            try {
+                resume_pass = checkpoint->completed_pass(input_filename, options);
+            } catch (const std::runtime_error& e) {
+                std::cerr << "ERROR: " << e.what() << '\n';
+                exit(1);
+            }
+        }
+    }
+
+    if (resume_pass < 2) {
+        verbose_output << "Pass 1 (reading route relations) ...";
+        statistics.start_pass("pass1");
+        std::unique_ptr<FileRangeStream> stream;
+        osmium::io::File input_file = spool
+                ? osmium::io::File(spool->stream_path(), options.input_format.empty() ? spool->format() : options.input_format)
+                : open_input(input_filename, options.input_format, blob_index, osmium::osm_entity_bits::relation, stream);
+        // The points are written in pass 2 if running in fused mode. Therefore, the via nodes of
+        // turn restrictions have to be known before pass 2.
+        const bool read_via_nodes = options.fused && options.points;
+        TurnRestrictionHandler tr_handler(point_node_members);
+        osmium::io::Reader reader(input_file, osmium::osm_entity_bits::relation);
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            for (const osmium::Relation& relation : buffer.select<osmium::Relation>()) {
+                statistics.relation(relation);
+                route_manager.relation(relation);
+                if (read_via_nodes) {
+                    tr_handler.relation(relation);
+                }
+                if (location_filter.enabled()) {
+                    location_filter.relation(relation);
+                }
+            }
+        }
+        reader.close();
+        route_manager.prepare_for_lookup();
+        if (spool) {
+            spool->finish();
+            input_filename = spool->filename();
+        }
+        statistics.end_pass();
+        verbose_output << " done\n";
+    }
+
+    if (resume_pass < 2 && location_filter.enabled()) {
+        verbose_output << "Pass 1b (collecting nodes of ways which need a geometry) ...";
+        std::unique_ptr<FileRangeStream> stream;
+        osmium::io::File input_file = open_input(input_filename, options.input_format, blob_index, osmium::osm_entity_bits::way, stream);
+        statistics.start_pass("pass1b");
+        osmium::io::Reader reader(input_file, osmium::osm_entity_bits::way);
+        osmium::apply(reader, statistics, location_filter);
+        reader.close();
+        location_filter.after_ways();
+        statistics.end_pass();
+        verbose_output << " done\n";
+    }
+
+    // This ItemStash collects the IDs of all nodes which are expected to be reference by a way because their tags require it.
+    // Examples: points, signals, stop positions
+    osmium::ItemStash must_on_track;
+    std::unordered_map<osmium::object_id_type, osmium::ItemStash::handle_type> must_on_track_handles;
+    if (resume_pass >= 2) {
+        checkpoint->restore(resume_pass, writer, must_on_track, must_on_track_handles, point_node_members);
+    } else {
+        std::string location_index_type = options.location_index_type;
+        // only used if a file-backed index is chosen automatically
+        std::string location_index_filename = options.output_directory + "/.location_index.tmp";
+        // A complete index written by an earlier run on the same input is reused. Filtered indexes are incomplete.
+        std::unique_ptr<LocationCache> location_cache;
+        std::string cached_index_filename;
+        if (!options.location_cache.empty() && !location_filter.enabled()) {
+            location_cache.reset(new LocationCache(options.location_cache, osmium::io::File(input_filename, options.input_format)));
+            cached_index_filename = location_cache->find();
+        }
+        std::unique_ptr<index_type> location_index;
+        if (!cached_index_filename.empty()) {
+            verbose_output << "Using cached node locations " << cached_index_filename << '\n';
+            location_index_type = "cached";
+            location_index.reset(new CachedLocationMap(cached_index_filename));
+        } else {
+            if (location_index_type == "auto") {
+                LocationIndexSelector selector(options, verbose_output);
+                location_index_type = selector.select(osmium::io::File(input_filename, options.input_format), blob_index, location_index_filename);
+            }
+            if (location_cache) {
+                location_index_type = location_cache->writable_index_type(location_index_type);
+            }
+            location_index = map_factory.create_map(location_index_type);
+            // Only the file of a file-backed index chosen automatically is removed. It is kept open by the
+            // index and not needed by anyone else.
+            const std::string::size_type comma = location_index_type.find(',');
+            if (options.location_index_type == "auto" && comma != std::string::npos
+                    && location_index_type.compare(comma + 1, std::string::npos, location_index_filename) == 0) {
+                unlink(location_index_filename.c_str());
+            }
+        }
+        location_handler_type location_handler(*location_index);
+        location_handler.ignore_errors();
+        FilteredLocationHandler<location_handler_type> locations(location_handler, location_filter);
+        RailwayHandlerPass1 railway_handler1(writer, options, verbose_output, must_on_track, must_on_track_handles);
+        RegionFilter<RailwayHandlerPass1> region_railway_handler1(railway_handler1, region.get(), shard);
+        // The location handler needs all nodes, the railway handlers only the tagged ones they are interested in.
+        CandidateFilter<RegionFilter<RailwayHandlerPass1>> candidate_railway_handler1(region_railway_handler1,
+                RailwayHandlerPass1::node_keys(), &RailwayHandlerPass1::way_keys());
+
+        if (options.route_threads > 1) {
+            route_manager.start_workers(options, verbose_output);
+        }
+        verbose_output << "Pass 2 ...";
+        statistics.start_pass("pass2");
+        osmium::io::Reader reader1(osmium::io::File(input_filename, options.input_format));
+        if (options.threads > 1) {
+            RailwayHandlerPool pool(railway_handler1, must_on_track, must_on_track_handles, options, verbose_output, region.get());
+            TurnRestrictionHandler tr_handler(point_node_members);
+            while (osmium::memory::Buffer buffer = reader1.read()) {
+                if (options.points) {
+                    osmium::apply(buffer, statistics, locations, state_handler, tr_handler, route_manager.handler());
+                } else {
+                    osmium::apply(buffer, statistics, locations, state_handler, route_manager.handler());
+                }
+                pool.add_buffer(std::move(buffer));
+            }
+            pool.finish();
+        } else if (options.fused) {
+            // RailwayHandlerPass2 has to be constructed after RailwayHandlerPass1 to keep the order of the layers.
+            RailwayHandlerPass2 railway_handler2(writer, point_node_members, must_on_track_handles, must_on_track, options, verbose_output);
+            RegionFilter<RailwayHandlerPass2> region_railway_handler2(railway_handler2, region.get(), shard, false);
+            CandidateFilter<RegionFilter<RailwayHandlerPass2>> candidate_railway_handler2(region_railway_handler2,
+                    RailwayHandlerPass2::node_keys(), nullptr);
+            osmium::apply(reader1, statistics, locations, state_handler, candidate_railway_handler1, candidate_railway_handler2, route_manager.handler());
+            railway_handler2.after_ways();
+        } else if (options.points) {
+            TurnRestrictionHandler tr_handler(point_node_members);
+            osmium::apply(reader1, statistics, locations, state_handler, candidate_railway_handler1, tr_handler, route_manager.handler());
+        } else {
+            osmium::apply(reader1, statistics, locations, state_handler, candidate_railway_handler1, route_manager.handler());
+        }
+        route_manager.for_each_incomplete_relation([&](const osmium::relations::RelationHandle& handle){
+            route_manager.process_route(*handle);
+        });
+        route_manager.finish_workers();
+        reader1.close();
+        statistics.end_pass();
+        verbose_output << " done\n";
+        statistics.set_location_index(location_index_type, location_index->used_memory());
+        if (location_cache) {
+            location_index->sort();
+            location_cache->commit();
+        }
+        if (checkpoint) {
+            checkpoint->save(2, input_filename, options, writer, must_on_track, must_on_track_handles, point_node_members);
+        }
+        statistics.set_item_stash_memory(must_on_track.used_memory());
+        const auto relations_memory = route_manager.used_memory();
+        statistics.set_relations_manager_memory(relations_memory.relations_db, relations_memory.members_db,
+                relations_memory.stash);
+    }
+
+    if (!options.fused && resume_pass < 3) {
+        RailwayHandlerPass2 railway_handler2(writer, point_node_members, must_on_track_handles, must_on_track, options, verbose_output);
+        verbose_output << "Pass 3 ...";
+        statistics.start_pass("pass3");
+        const osmium::osm_entity_bits::type pass3_types = osmium::osm_entity_bits::node | osmium::osm_entity_bits::way;
+        std::unique_ptr<FileRangeStream> stream;
+        osmium::io::File input_file = open_input(input_filename, options.input_format, blob_index, pass3_types, stream);
+        osmium::io::Reader reader2(input_file, pass3_types);
+        // The ways have no locations in this pass, they are passed by the region filter. All shards
+        // need all ways to find the nodes which are not on a track.
+        RegionFilter<RailwayHandlerPass2> region_railway_handler2(railway_handler2, region.get(), shard, false);
+        CandidateFilter<RegionFilter<RailwayHandlerPass2>> candidate_railway_handler2(region_railway_handler2,
+                RailwayHandlerPass2::node_keys(), nullptr);
+        osmium::apply(reader2, statistics, candidate_railway_handler2);
+        reader2.close();
+        railway_handler2.after_ways();
+        statistics.end_pass();
+        verbose_output << " done\n";
+        if (checkpoint) {
+            checkpoint->save(3, input_filename, options, writer, must_on_track, must_on_track_handles, point_node_members);
+        }
+    }
+    must_on_track.clear();
+    must_on_track.garbage_collect();
+    if (state) {
+        state->save();
+    }
+    if (snapshot) {
+        snapshot->close();
+    }
+    if (!options.stats_file.empty()) {
+        statistics.set_routes(route_manager.statistics());
+        if (options.shards > 1) {
+            // The main process adds up the statistics of all workers.
+            statistics.save(options.stats_file);
+        } else {
+            statistics.set_layer_features(writer.feature_counts());
+            statistics.write(options.stats_file);
+        }
+    }
+    // The output of the workers in sharded mode is merged by the main process.
+    if (options.shards <= 1) {
+        writer.rename_output_files("pubtrans");
+        verbose_output << "wrote output to " << options.output_directory << "\n";
+    }
+}
+
 int main(int argc, char* argv[]) {
 
     const int NO_CROSSINGS = 1000;
@@ -59,26 +455,71 @@ int main(int argc, char* argv[]) {
     const int NO_RAILWAY_DETAILS = 1003;
     const int NO_STOPS = 1004;
     const int NO_STATIONS = 1005;
+    const int FUSED = 1006;
+    const int BLOB_INDEX = 1007;
+    const int MAX_MEMORY = 1008;
+    const int FILTER_LOCATIONS = 1009;
+    const int INPUT_FORMAT = 1010;
+    const int BULK_LOAD = 1011;
+    const int STATS = 1012;
+    const int BBOX = 1014;
+    const int POLYGON = 1015;
+    const int SHARDS = 1016;
+    const int STATE = 1017;
+    const int UPDATE = 1018;
+    const int LOCATION_CACHE = 1019;
+    const int CHECKPOINT = 1020;
+    const int RESUME = 1021;
+    const int SNAPSHOT = 1022;
+    const int REVALIDATE = 1023;
+    const int SERVE = 1024;
+    const int ADD_OUTPUT = 1025;
+    const int WAY_RULES = 1026;
+    const int ROUTE_THREADS = 1027;
+    const int SERVE_CHANGES = 1028;
 
     static struct option long_options[] = {
+        {"add-output", required_argument, 0, ADD_OUTPUT},
+        {"bbox", required_argument, 0, BBOX},
+        {"blob-index", required_argument, 0, BLOB_INDEX},
+        {"bulk-load",   no_argument, 0, BULK_LOAD},
+        {"checkpoint", required_argument, 0, CHECKPOINT},
         {"no-crossings",   no_argument, 0, NO_CROSSINGS},
         {"help",   no_argument, 0, 'h'},
+        {"filter-locations",   no_argument, 0, FILTER_LOCATIONS},
         {"format", required_argument, 0, 'f'},
+        {"fused",   no_argument, 0, FUSED},
         {"index", required_argument, 0, 'i'},
+        {"input-format", required_argument, 0, INPUT_FORMAT},
+        {"location-cache", required_argument, 0, LOCATION_CACHE},
+        {"max-memory", required_argument, 0, MAX_MEMORY},
         {"no-platforms",   no_argument, 0, NO_PLATFORMS},
         {"no-points",   no_argument, 0, NO_POINTS},
         {"no-railway-details",   no_argument, 0, NO_RAILWAY_DETAILS},
         {"no-stations",   no_argument, 0, NO_STATIONS},
         {"no-stops",   no_argument, 0, NO_STOPS},
+        {"polygon", required_argument, 0, POLYGON},
+        {"resume", required_argument, 0, RESUME},
+        {"revalidate", required_argument, 0, REVALIDATE},
+        {"route-threads", required_argument, 0, ROUTE_THREADS},
+        {"serve", required_argument, 0, SERVE},
+        {"serve-changes", required_argument, 0, SERVE_CHANGES},
+        {"shards", required_argument, 0, SHARDS},
+        {"snapshot", required_argument, 0, SNAPSHOT},
         {"srs", required_argument, 0, 's'},
+        {"state", required_argument, 0, STATE},
+        {"stats", required_argument, 0, STATS},
+        {"threads", required_argument, 0, 't'},
+        {"update", required_argument, 0, UPDATE},
         {"verbose",   no_argument, 0, 'v'},
+        {"way-rules", required_argument, 0, WAY_RULES},
         {0, 0, 0, 0}
     };
 
     Options options;
 
     while (true) {
-        int c = getopt_long(argc, argv, "hf:i:s:v", long_options, 0);
+        int c = getopt_long(argc, argv, "hf:i:s:t:v", long_options, 0);
         if (c == -1) {
             break;
         }
@@ -118,6 +559,105 @@ int main(int argc, char* argv[]) {
                 }
 #endif
                 break;
+            case 't':
+                if (optarg && atoi(optarg) > 0) {
+                    options.threads = atoi(optarg);
+                } else {
+                    print_help(argv[0]);
+                    exit(1);
+                }
+                break;
+            case SHARDS:
+                if (optarg && atoi(optarg) > 0) {
+                    options.shards = atoi(optarg);
+                } else {
+                    print_help(argv[0]);
+                    exit(1);
+                }
+                break;
+            case ADD_OUTPUT: {
+                const std::string target {optarg};
+                const size_t first_comma = target.find(',');
+                const size_t second_comma = first_comma == std::string::npos ? first_comma : target.find(',', first_comma + 1);
+                if (second_comma == std::string::npos || atoi(target.c_str() + first_comma + 1) <= 0) {
+                    print_help(argv[0]);
+                    exit(1);
+                }
+                options.output_targets.push_back(OutputTarget{target.substr(0, first_comma),
+                        atoi(target.c_str() + first_comma + 1), target.substr(second_comma + 1)});
+                break;
+            }
+            case SERVE:
+                if (optarg && atoi(optarg) > 0 && atoi(optarg) < 65536) {
+                    options.serve_port = atoi(optarg);
+                } else {
+                    print_help(argv[0]);
+                    exit(1);
+                }
+                break;
+            case SERVE_CHANGES:
+                options.serve_changes_directory = optarg;
+                break;
+            case CHECKPOINT:
+                options.checkpoint_directory = optarg;
+                break;
+            case RESUME:
+                options.checkpoint_directory = optarg;
+                options.resume = true;
+                break;
+            case SNAPSHOT:
+                options.snapshot = optarg;
+                break;
+            case REVALIDATE:
+                options.revalidate = optarg;
+                break;
+            case WAY_RULES:
+                options.way_rules = optarg;
+                break;
+            case ROUTE_THREADS:
+                options.route_threads = atoi(optarg);
+                break;
+            case LOCATION_CACHE:
+                options.location_cache = optarg;
+                break;
+            case STATE:
+                options.state_directory = optarg;
+                break;
+            case UPDATE:
+                options.update_file = optarg;
+                break;
+            case BBOX:
+                options.bbox = optarg;
+                break;
+            case POLYGON:
+                options.polygon_file = optarg;
+                break;
+            case STATS:
+                options.stats_file = optarg;
+                break;
+            case BULK_LOAD:
+                options.bulk_load = true;
+                break;
+            case BLOB_INDEX:
+                options.blob_index = optarg;
+                break;
+            case MAX_MEMORY:
+                if (optarg && atoll(optarg) > 0) {
+                    options.max_memory = static_cast<uint64_t>(atoll(optarg));
+                } else {
+                    print_help(argv[0]);
+                    exit(1);
+                }
+                break;
+            case INPUT_FORMAT:
+                options.input_format = optarg;
+                break;
+            case FILTER_LOCATIONS:
+                options.filter_locations = true;
+                break;
+            case FUSED:
+                options.fused = true;
+                break;
             case NO_CROSSINGS:
                 options.crossings = false;
                 break;
@@ -145,6 +685,116 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (options.bulk_load && strcasecmp(options.output_format.c_str(), "sqlite")) {
+        std::cerr << "ERROR: --bulk-load can only be used with the SQlite output format.\n";
+        exit(1);
+    }
+    if (!options.bbox.empty() && !options.polygon_file.empty()) {
+        std::cerr << "ERROR: --bbox and --polygon cannot be used together.\n";
+        exit(1);
+    }
+    if (!options.way_rules.empty()) {
+        // Report errors in the rules before any output is written.
+        try {
+            WayRules::from_file(options.way_rules);
+        } catch (const std::runtime_error& e) {
+            std::cerr << "ERROR: " << e.what() << '\n';
+            exit(1);
+        }
+    }
+    if (options.fused && options.threads > 1) {
+        std::cerr << "ERROR: --fused cannot be used with multiple threads.\n";
+        exit(1);
+    }
+    if (options.route_threads < 1) {
+        std::cerr << "ERROR: --route-threads has to be at least 1.\n";
+        exit(1);
+    }
+    // Features merged from the in-memory datasets of worker threads are not written to the additional outputs.
+    if (!options.output_targets.empty() && (options.shards > 1 || !options.checkpoint_directory.empty()
+            || !options.state_directory.empty() || !options.update_file.empty() || options.serve_port
+            || options.threads > 1 || options.route_threads > 1)) {
+        std::cerr << "ERROR: --add-output cannot be used with --shards, checkpoints, --state, --update, --serve,\n"
+                  << "--threads or --route-threads.\n";
+        exit(1);
+    }
+
+    if (!options.update_file.empty()) {
+        if (options.state_directory.empty() || argc - optind != 1) {
+            std::cerr << "ERROR: --update requires --state and the output directory as the only argument.\n";
+            exit(1);
+        }
+        options.output_directory = argv[optind];
+        osmium::util::VerboseOutput verbose_output(options.verbose);
+        StateStore state(options.state_directory, false);
+        RouteUpdater updater(state, options, verbose_output);
+        updater.apply(options.update_file);
+        state.save();
+        verbose_output << "updated output in " << options.output_directory << "\n";
+        return 0;
+    }
+    if (!options.serve_changes_directory.empty() && !options.serve_port) {
+        std::cerr << "ERROR: --serve-changes requires --serve.\n";
+        exit(1);
+    }
+    if (options.serve_port) {
+        if (options.state_directory.empty() || argc - optind != (options.serve_changes_directory.empty() ? 0 : 1)) {
+            std::cerr << "ERROR: --serve requires --state and the output directory as the only argument if\n"
+                      << "--serve-changes is given, no arguments otherwise.\n";
+            exit(1);
+        }
+        if (!options.serve_changes_directory.empty()) {
+            options.output_directory = argv[optind];
+        }
+        osmium::util::VerboseOutput verbose_output(options.verbose);
+        StateStore state(options.state_directory, false);
+        RouteServer server(state, options, verbose_output);
+        server.run(options.serve_port);
+        return 0;
+    }
+    if (!options.revalidate.empty()) {
+        if (argc - optind != 1) {
+            std::cerr << "ERROR: --revalidate requires the output directory as the only argument.\n";
+            exit(1);
+        }
+        if (!options.way_rules.empty()) {
+            // The snapshot contains only the tags read by the built-in checks.
+            for (const std::string& key : WayRules::from_file(options.way_rules).keys()) {
+                if (!RouteSnapshotWriter::keep_key(key.c_str())) {
+                    std::cerr << "ERROR: The way rules use the key " << key << " which is not stored in route snapshots.\n"
+                              << "They cannot be used with --revalidate.\n";
+                    exit(1);
+                }
+            }
+        }
+        options.output_directory = argv[optind];
+        osmium::util::VerboseOutput verbose_output(options.verbose);
+        OGRWriter writer {options, verbose_output};
+        RouteManager route_manager(writer, options, verbose_output);
+        if (options.route_threads > 1) {
+            route_manager.start_workers(options, verbose_output);
+        }
+        verbose_output << "Validating routes of snapshot " << options.revalidate << " ...";
+        RouteSnapshotReader reader {options.revalidate};
+        const size_t count = reader.read(route_manager);
+        route_manager.finish_workers();
+        verbose_output << " done (" << count << " routes)\n";
+        writer.rename_output_files("pubtrans");
+        verbose_output << "wrote output to " << options.output_directory << "\n";
+        return 0;
+    }
+    if (!options.snapshot.empty() && (options.shards > 1 || options.resume)) {
+        std::cerr << "ERROR: --snapshot cannot be used with --shards or --resume.\n";
+        exit(1);
+    }
+    if (!options.state_directory.empty() && (options.shards > 1 || options.filter_locations
+            || !options.bbox.empty() || !options.polygon_file.empty() || !options.location_cache.empty()
+            || !options.checkpoint_directory.empty())) {
+        std::cerr << "ERROR: --state cannot be used with --shards, --filter-locations, --bbox, --polygon, --location-cache\n"
+                  << "or checkpoints.\n";
+        exit(1);
+    }
+
     std::string input_filename;
     int remaining_args = argc - optind;
     if (remaining_args == 2) {
@@ -156,55 +806,41 @@ int main(int argc, char* argv[]) {
         input_filename = "-";
     }
 
-    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
-
-    osmium::util::VerboseOutput verbose_output(options.verbose);
-    OGRWriter writer {options, verbose_output};
-    RouteManager route_manager(writer, options, verbose_output);
-
-    {
-        verbose_output << "Pass 1 (reading route relations) ...";
-        osmium::io::File input_file(input_filename);
-        osmium::relations::read_relations(input_file, route_manager);
-        verbose_output << " done\n";
+    if (input_filename == "-" && options.input_format.empty()) {
+        options.input_format = "pbf";
+    }
+    if (!options.blob_index.empty() && InputSpool::needed(input_filename)) {
+        std::cerr << "ERROR: A blob index cannot be used when reading from STDIN or a pipe.\n";
+        exit(1);
+    }
+    if (!options.checkpoint_directory.empty() && (InputSpool::needed(input_filename) || options.shards > 1)) {
+        std::cerr << "ERROR: Checkpoints cannot be used when reading from STDIN or a pipe or with --shards.\n";
+        exit(1);
     }
 
-    osmium::index::IdSetDense<osmium::unsigned_object_id_type> point_node_members;
-
-    // This ItemStash collects the IDs of all nodes which are expected to be reference by a way because their tags require it.
-    // Examples: points, signals, stop positions
-    osmium::ItemStash must_on_track;
-    std::unordered_map<osmium::object_id_type, osmium::ItemStash::handle_type> must_on_track_handles;
-    {
-        auto location_index = map_factory.create_map(options.location_index_type);
-        location_handler_type location_handler(*location_index);
-        location_handler.ignore_errors();
-        RailwayHandlerPass1 railway_handler1(writer, options, verbose_output, must_on_track, must_on_track_handles);
-
-        verbose_output << "Pass 2 ...";
-        osmium::io::Reader reader1(input_filename);
-        if (options.points) {
-            TurnRestrictionHandler tr_handler(point_node_members);
-            osmium::apply(reader1, location_handler, railway_handler1, tr_handler, route_manager.handler());
-        } else {
-            osmium::apply(reader1, location_handler, railway_handler1, route_manager.handler());
+    if (options.shards > 1) {
+        if (InputSpool::needed(input_filename)) {
+            std::cerr << "ERROR: --shards cannot be used when reading from STDIN or a pipe.\n";
+            exit(1);
         }
-        route_manager.for_each_incomplete_relation([&](const osmium::relations::RelationHandle& handle){
-            route_manager.process_route(*handle);
-        });
-        verbose_output << " done\n";
-
-        reader1.close();
+        osmium::util::VerboseOutput verbose_output(options.verbose);
+        if (!options.blob_index.empty()) {
+            // Build the blob index once before the workers load it.
+            BlobIndex blob_index;
+            load_or_build_blob_index(blob_index, options.blob_index, input_filename, options.input_format, verbose_output);
+            if (blob_index.entries().empty()) {
+                // The workers should not try again.
+                options.blob_index.clear();
+            }
+        }
+        ShardRunner runner(options, verbose_output);
+        if (!runner.run([&input_filename](Options& shard_options) { convert(shard_options, input_filename); })) {
+            std::cerr << "ERROR: At least one worker process failed.\n";
+            exit(1);
+        }
+        runner.merge();
+        verbose_output << "wrote output to " << options.output_directory << "\n";
+    } else {
+        convert(options, input_filename);
     }
-
-    RailwayHandlerPass2 railway_handler2(writer, point_node_members, must_on_track_handles, must_on_track, options, verbose_output);
-    verbose_output << "Pass 3 ...";
-    osmium::io::Reader reader2(input_filename, osmium::osm_entity_bits::node | osmium::osm_entity_bits::way);
-    osmium::apply(reader2, railway_handler2);
-    railway_handler2.after_ways();
-    must_on_track.clear();
-    must_on_track.garbage_collect();
-    writer.rename_output_files("pubtrans");
-    verbose_output << " done\n";
-    verbose_output << "wrote output to " << options.output_directory << "\n";
 }
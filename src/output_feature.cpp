@@ -0,0 +1,59 @@
+/*
+ * output_feature.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <cmath>
+
+#include "output_feature.hpp"
+#include "ogr_writer.hpp"
+
+OutputFeature::OutputFeature(OGRWriter& writer, gdalcpp::Layer& layer, std::unique_ptr<OGRGeometry>&& geometry) :
+        m_writer(&writer),
+        m_layer(layer),
+        m_geometry(std::move(geometry)),
+        m_fields() {
+}
+
+OutputFeature& OutputFeature::set_field(const int index, const char* value) {
+    m_fields.push_back(Field{index, value == nullptr, value ? value : ""});
+    return *this;
+}
+
+void OutputFeature::add_to_layer() {
+    m_writer->add_feature(std::move(*this));
+}
+
+/*static*/ bool OutputFeature::finite_y(const OGRGeometry& geometry) {
+    OGREnvelope envelope;
+    geometry.getEnvelope(&envelope);
+    return std::isfinite(envelope.MinY) && std::isfinite(envelope.MaxY);
+}
+
+void OutputFeature::write_to(gdalcpp::Layer& layer, std::unique_ptr<OGRGeometry>&& geometry) {
+    gdalcpp::Feature feature(layer, std::move(geometry));
+    for (const Field& field : m_fields) {
+        feature.set_field(field.index, field.null ? nullptr : field.value.c_str());
+    }
+    feature.add_to_layer();
+}
+
+void OutputFeature::write() {
+    // The geometry is transformed for each additional output. The main output gets the original.
+    for (auto& target_layer : m_writer->target_layers(m_layer)) {
+        std::unique_ptr<OGRGeometry> geometry {m_geometry ? m_geometry->clone() : nullptr};
+        if (geometry && target_layer.transformation) {
+            const OGRErr result = geometry->transform(target_layer.transformation);
+            if (target_layer.mercator && (result != OGRERR_NONE || !finite_y(*geometry))) {
+                // The poles cannot be projected to Web Mercator. The feature is skipped in this output only.
+                continue;
+            }
+            if (result != OGRERR_NONE) {
+                throw gdalcpp::gdal_error{"Transforming geometry failed", OGRERR_FAILURE};
+            }
+        }
+        write_to(target_layer.layer, std::move(geometry));
+    }
+    write_to(m_layer, std::move(m_geometry));
+}
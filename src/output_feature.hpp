@@ -0,0 +1,70 @@
+/*
+ * output_feature.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_OUTPUT_FEATURE_HPP_
+#define SRC_OUTPUT_FEATURE_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <gdalcpp.hpp>
+
+class OGRWriter;
+
+/**
+ * A feature which is built by a handler and written to its layer by OGRWriter.
+ *
+ * It provides the same interface as gdalcpp::Feature but does not touch the dataset until it is
+ * written. Therefore, it can be handed over to the output thread of OGRWriter. The field values
+ * are copied because the strings passed to set_field() are usually short-lived.
+ */
+class OutputFeature {
+
+    struct Field {
+        int index;
+        /// true if nullptr was passed as value
+        bool null;
+        std::string value;
+    };
+
+    OGRWriter* m_writer;
+
+    /// copy of the layer, it is valid as long as the dataset exists
+    gdalcpp::Layer m_layer;
+
+    std::unique_ptr<OGRGeometry> m_geometry;
+
+    std::vector<Field> m_fields;
+
+    void write_to(gdalcpp::Layer& layer, std::unique_ptr<OGRGeometry>&& geometry);
+
+    /**
+     * Are the y coordinates of the geometry finite? Latitudes of ±90° become infinite in Web Mercator.
+     */
+    static bool finite_y(const OGRGeometry& geometry);
+
+public:
+    OutputFeature() = delete;
+
+    OutputFeature(OGRWriter& writer, gdalcpp::Layer& layer, std::unique_ptr<OGRGeometry>&& geometry);
+
+    OutputFeature& set_field(const int index, const char* value);
+
+    /**
+     * Hand the feature over to the writer. The feature must not be used afterwards.
+     */
+    void add_to_layer();
+
+    /**
+     * Write the feature to its layer and the layers mirroring it in the additional outputs of the
+     * writer. This is called by OGRWriter.
+     *
+     * \throws gdalcpp::gdal_error
+     */
+    void write();
+};
+
+#endif /* SRC_OUTPUT_FEATURE_HPP_ */
@@ -6,110 +6,95 @@
  */
 
 #include "ptv2_checker.hpp"
+#include "tag_value.hpp"
 
 #include <assert.h>
 
 
-PTv2Checker::PTv2Checker(RouteWriter& writer) :
-    m_writer(writer) {}
+/// keys of stops and platforms read by the tag checks, in ascending order
+static constexpr const char* STOP_KEYS[] = {
+    "aerialway", "amenity", "bus", "ferry", "highway", "public_transport", "railway", "subway", "train",
+    "tram", "trolleybus"
+};
+static_assert(tag_keys_sorted(STOP_KEYS), "STOP_KEYS has to be sorted");
+static_assert(sizeof(STOP_KEYS) / sizeof(STOP_KEYS[0]) == PTv2Checker::STOP_KEYS_COUNT, "STOP_KEYS_COUNT is wrong");
+
+/// indexes of STOP_KEYS
+struct StopKeys {
+    static constexpr size_t aerialway = 0;
+    static constexpr size_t amenity = 1;
+    static constexpr size_t bus = 2;
+    static constexpr size_t ferry = 3;
+    static constexpr size_t highway = 4;
+    static constexpr size_t public_transport = 5;
+    static constexpr size_t railway = 6;
+    static constexpr size_t subway = 7;
+    static constexpr size_t train = 8;
+    static constexpr size_t tram = 9;
+    static constexpr size_t trolleybus = 10;
+};
+
+PTv2Checker::PTv2Checker(RouteWriter& writer, const WayRules& way_rules /* = WayRules::defaults() */) :
+    m_writer(writer),
+    m_way_rules(way_rules) {}
 
 RouteType PTv2Checker::get_route_type(const char* route) {
     assert(route);
-    if (!strcmp(route, "train")) {
+    switch (classify_tag_value(route)) {
+    case TagValue::TRAIN:
         return RouteType::TRAIN;
-    } else if (!strcmp(route, "subway")) {
+    case TagValue::SUBWAY:
         return RouteType::SUBWAY;
-    } else if (!strcmp(route, "tram")) {
+    case TagValue::TRAM:
         return RouteType::TRAM;
-    } else if (!strcmp(route, "bus")) {
+    case TagValue::BUS:
         return RouteType::BUS;
-    } else if (!strcmp(route, "trolleybus")) {
+    case TagValue::TROLLEYBUS:
         return RouteType::TROLLEYBUS;
-    } else if (!strcmp(route, "ferry")) {
+    case TagValue::FERRY:
         return RouteType::FERRY;
-    } else if (!strcmp(route, "aerialway")) {
+    case TagValue::AERIALWAY:
         return RouteType::AERIALWAY;
+    default:
+        return RouteType::NONE;
     }
-    return RouteType::NONE;
 }
 
 bool PTv2Checker::is_stop(const char* role) {
-    return !strcmp(role, "stop") || !strcmp(role, "stop_entry_only") || !strcmp(role, "stop_exit_only");
+    const TagValue value = classify_tag_value(role);
+    return value == TagValue::STOP || value == TagValue::STOP_ENTRY_ONLY || value == TagValue::STOP_EXIT_ONLY;
 }
 
 bool PTv2Checker::is_platform(const char* role) {
-    return !strcmp(role, "platform") || !strcmp(role, "platform_entry_only") || !strcmp(role, "platform_exit_only");
+    const TagValue value = classify_tag_value(role);
+    return value == TagValue::PLATFORM || value == TagValue::PLATFORM_ENTRY_ONLY || value == TagValue::PLATFORM_EXIT_ONLY;
 }
 
 bool PTv2Checker::vehicle_tags_matches_route_type(const osmium::TagList& tags, RouteType type) {
+    return vehicle_tags_matches_route_type(stop_tags_type{STOP_KEYS, tags}, type);
+}
+
+bool PTv2Checker::vehicle_tags_matches_route_type(const stop_tags_type& tags, RouteType type) {
     switch (type) {
     case RouteType::BUS:
-        return tags.has_tag("bus", "yes");
+        return tags.has(StopKeys::bus, "yes");
     case RouteType::TROLLEYBUS:
-        return tags.has_tag("trolleybus", "yes");
+        return tags.has(StopKeys::trolleybus, "yes");
     case RouteType::TRAIN:
-        return tags.has_tag("train", "yes");
+        return tags.has(StopKeys::train, "yes");
     case RouteType::TRAM:
-        return tags.has_tag("tram", "yes");
+        return tags.has(StopKeys::tram, "yes");
     case RouteType::SUBWAY:
-        return tags.has_tag("subway", "yes");
+        return tags.has(StopKeys::subway, "yes");
     case RouteType::FERRY:
-        return tags.has_tag("ferry", "yes");
+        return tags.has(StopKeys::ferry, "yes");
     case RouteType::AERIALWAY:
-        return tags.has_tag("aerialway", "yes");
+        return tags.has(StopKeys::aerialway, "yes");
     default:
         return false;
     }
 }
 
-bool PTv2Checker::check_valid_railway_track(RouteType type, const osmium::TagList& member_tags) {
-    const char* railway = member_tags.get_value_by_key("railway");
-    if (!railway) {
-        return is_ferry(member_tags);
-    }
-    if (type == RouteType::TRAIN || type == RouteType::TRAM) {
-        if (!strcmp(railway, "rail") || !strcmp(railway, "light_rail") || !strcmp(railway, "tram") || !strcmp(railway, "subway")
-                || !strcmp(railway, "funicular") || !strcmp(railway, "preserved") || !strcmp(railway, "miniature") || !strcmp(railway, "narrow_gauge")) {
-            return true;
-        }
-    }
-    if (type == RouteType::SUBWAY) {
-            return true;
-    }
-    return is_ferry(member_tags);
-}
-
-bool PTv2Checker::check_valid_road_way(const osmium::TagList& member_tags) {
-    const char* highway = member_tags.get_value_by_key("highway");
-    if (!highway) {
-        return is_ferry(member_tags);
-    }
-    return (!strcmp(highway, "motorway") || !strcmp(highway, "motorway_link") || !strcmp(highway, "trunk")
-        || !strcmp(highway, "trunk_link") || !strcmp(highway, "primary") || !strcmp(highway, "primary_link")
-        || !strcmp(highway, "secondary") || !strcmp(highway, "secondary_link") || !strcmp(highway, "tertiary")
-        || !strcmp(highway, "tertiary_link") || !strcmp(highway, "unclassified") || !strcmp(highway, "residential")
-        || !strcmp(highway, "service") || !strcmp(highway, "track") || !strcmp(highway, "pedestrian")
-        || !strcmp(highway, "living_street") || !strcmp(highway, "bus_guideway")
-       );
-}
-
-bool PTv2Checker::check_valid_trolleybus_way(const osmium::TagList& member_tags) {
-    if (member_tags.has_tag("trolley_wire", "yes")) {
-        return check_valid_road_way(member_tags);
-    }
-    //TODO check direction (forward wire but using the way in opposite direction might cause problems ;-)
-    if (member_tags.has_tag("trolley_wire:forward", "yes") || member_tags.has_tag("trolley_wire", "forward")) {
-        return check_valid_road_way(member_tags);
-    }
-    return (member_tags.has_tag("trolley_wire:backward", "yes") || member_tags.has_tag("trolley_wire", "backward"))
-            && check_valid_road_way(member_tags);
-}
-
-bool PTv2Checker::is_ferry(const osmium::TagList& member_tags, bool permit_untagged_ways /* = false */) {
-    const char* route = member_tags.get_value_by_key("route");
-    return (route && !strcmp(route, "ferry")) || (permit_untagged_ways && !route);
-}
-
 bool PTv2Checker::roundabout_connected_to_previous_way(const BackOrFront previous_way_end, const osmium::Way* previous_way, const osmium::Way* way) {
     for (const osmium::NodeRef& nd_ref : way->nodes()) {
         if ((previous_way_end == BackOrFront::FRONT && previous_way->nodes().front().ref() == nd_ref.ref())
@@ -146,26 +131,26 @@ RouteError PTv2Checker::is_way_usable(const osmium::Relation& relation, RouteTyp
     case RouteType::TRAIN:
     case RouteType::TRAM:
     case RouteType::SUBWAY:
-        if (!check_valid_railway_track(type, way->tags())) {
+        if (!m_way_rules.allows(type, way->tags())) {
             m_writer.write_error_way(relation, 0, "rail-guided route over non-rail", way);
             return RouteError::OVER_NON_RAIL;
         }
         break;
 
     case RouteType::BUS:
-        if (!check_valid_road_way(way->tags())) {
+        if (!m_way_rules.allows(type, way->tags())) {
             m_writer.write_error_way(relation, 0, "road vehicle route over non-road", way);
             return RouteError::OVER_NON_ROAD;
         }
         break;
     case RouteType::TROLLEYBUS:
-        if (!check_valid_trolleybus_way(way->tags())) {
+        if (!m_way_rules.allows(type, way->tags())) {
             m_writer.write_error_way(relation, 0, "trolley bus without trolley wire", way);
             return RouteError::NO_TROLLEY_WIRE;
         }
         break;
     case RouteType::FERRY:
-        if (!is_ferry(way->tags(), true)) {
+        if (!m_way_rules.allows(type, way->tags())) {
             m_writer.write_error_way(relation, 0, "ferry over ways other than route=ferry", way);
             return RouteError::NO_FERRY;
         }
@@ -177,27 +162,28 @@ RouteError PTv2Checker::is_way_usable(const osmium::Relation& relation, RouteTyp
 }
 
 RouteError PTv2Checker::check_stop_tags(const osmium::Relation& relation, const osmium::Node* node, RouteType type) {
-    if (node->tags().has_tag("public_transport", "stop_position") && vehicle_tags_matches_route_type(node->tags(), type)) {
+    const stop_tags_type tags {STOP_KEYS, node->tags()};
+    if (tags.has(StopKeys::public_transport, "stop_position") && vehicle_tags_matches_route_type(tags, type)) {
         return RouteError::CLEAN;
     }
-    if ((type == RouteType::BUS || type == RouteType::TROLLEYBUS) && !node->tags().has_tag("highway", "bus_stop")) {
+    const TagValue railway = classify_tag_value(tags.get(StopKeys::railway));
+    if ((type == RouteType::BUS || type == RouteType::TROLLEYBUS) && !tags.has(StopKeys::highway, "bus_stop")) {
         m_writer.write_error_point(relation, node->id(), node->location(), "stop without proper tags", 0);
         return RouteError::STOP_TAG_MISSING;
     }
-    if (type == RouteType::TRAIN && !node->tags().has_tag("railway", "station")
-            && !node->tags().has_tag("railway", "halt") && !node->tags().has_tag("railway", "tram_stop")) {
+    if (type == RouteType::TRAIN && railway != TagValue::STATION && railway != TagValue::HALT && railway != TagValue::TRAM_STOP) {
         m_writer.write_error_point(relation, node->id(), node->location(), "stop without proper tags", 0);
         return RouteError::STOP_TAG_MISSING;
     }
-    if (type == RouteType::SUBWAY && !node->tags().has_tag("railway", "station")) {
+    if (type == RouteType::SUBWAY && railway != TagValue::STATION) {
         m_writer.write_error_point(relation, node->id(), node->location(), "stop without proper tags", 0);
         return RouteError::STOP_TAG_MISSING;
     }
-    if (type == RouteType::FERRY && !node->tags().has_tag("amenity", "ferry_terminal")) {
+    if (type == RouteType::FERRY && !tags.has(StopKeys::amenity, "ferry_terminal")) {
         m_writer.write_error_point(relation, node->id(), node->location(), "stop without proper tags", 0);
         return RouteError::STOP_TAG_MISSING;
     }
-    if (type == RouteType::AERIALWAY && !node->tags().has_tag("aerialway", "station")) {
+    if (type == RouteType::AERIALWAY && !tags.has(StopKeys::aerialway, "station")) {
         m_writer.write_error_point(relation, node->id(), node->location(), "stop without proper tags", 0);
         return RouteError::STOP_TAG_MISSING;
     }
@@ -205,13 +191,14 @@ RouteError PTv2Checker::check_stop_tags(const osmium::Relation& relation, const
 }
 
 RouteError PTv2Checker::check_platform_tags(const osmium::Relation& relation, const RouteType type, const osmium::OSMObject* object) {
-    if (object->tags().has_tag("public_transport", "platform")) {
+    const stop_tags_type tags {STOP_KEYS, object->tags()};
+    if (tags.has(StopKeys::public_transport, "platform")) {
         return RouteError::CLEAN;
     }
     if (((type == RouteType::BUS || type == RouteType::TROLLEYBUS)
-            && !object->tags().has_tag("highway", "bus_stop") && !object->tags().has_tag("highway", "platform"))
+            && !tags.has(StopKeys::highway, "bus_stop") && !tags.has(StopKeys::highway, "platform"))
             || ((type == RouteType::TRAIN || type == RouteType::TRAM || type == RouteType::SUBWAY)
-            && !object->tags().has_tag("railway", "platform"))) {
+            && !tags.has(StopKeys::railway, "platform"))) {
         if (object->type() == osmium::item_type::node) {
             const osmium::Node* node = static_cast<const osmium::Node*>(object);
             m_writer.write_error_point(relation, node->id(), node->location(), "platform without proper tags", 0);
@@ -9,6 +9,8 @@
 #define SRC_PTV2_CHECKER_HPP_
 
 #include "route_writer.hpp"
+#include "tag_projection.hpp"
+#include "way_rules.hpp"
 
 /**
  * This classed enum tracks the status of the current and the previous member processed by the gap checker.
@@ -46,8 +48,20 @@ enum class BackOrFront : char {
  * This class provides methods to check the validity of a route relation.
  */
 class PTv2Checker {
+public:
+    /// number of keys of stops and platforms read by the tag checks
+    static constexpr size_t STOP_KEYS_COUNT = 11;
+
+private:
+    using stop_tags_type = TagProjection<STOP_KEYS_COUNT>;
+
     RouteWriter& m_writer;
 
+    /// rules which ways the routes may use
+    const WayRules& m_way_rules;
+
+    bool vehicle_tags_matches_route_type(const stop_tags_type& tags, RouteType type);
+
     RouteError role_check_handle_road_member(const osmium::Relation& relation, const RouteType type,
             const osmium::OSMObject* object, const bool seen_stop_platform);
 
@@ -65,7 +79,10 @@ class PTv2Checker {
 public:
     PTv2Checker() = delete;
 
-    PTv2Checker(RouteWriter& writer);
+    /**
+     * \param way_rules rules which ways the routes may use, have to live as long as the checker
+     */
+    PTv2Checker(RouteWriter& writer, const WayRules& way_rules = WayRules::defaults());
 
     /**
      * Determine the type of the route.
@@ -101,42 +118,6 @@ public:
      */
     bool vehicle_tags_matches_route_type(const osmium::TagList& tags, RouteType type);
 
-    /**
-     * Check if the way is a valid member for of a train, subway or tram route relation.
-     *
-     * \param type type of the route
-     *
-     * \param member_tags tag list of the member to be checked
-     */
-    bool check_valid_railway_track(RouteType type, const osmium::TagList& member_tags);
-
-    /**
-     * Check if the way is a valid member for of a bus route relation.
-     *
-     * \param member_tags tag list of the member to be checked
-     */
-    bool check_valid_road_way(const osmium::TagList& member_tags);
-
-    /**
-     * Check if the way is a valid member for of a trolleybus route relation.
-     *
-     * \todo This method does only check if `trolley_wire:forward/backward=*` exists but not if it leads into the right direction.
-     *
-     * \param member_tags tag list of the member to be checked
-     */
-    bool check_valid_trolleybus_way(const osmium::TagList& member_tags);
-
-    /**
-     * Check if the way is a valid member for of a ferry route relation.
-     *
-     * This method is also useable for train routes over train ferries and bus routes over ferries.
-     *
-     * \param member_tags tag list of the member to be checked
-     *
-     * \param permit_untagged_ways Set to true if you check the members of a ferry route, false otherwise.
-     */
-    bool is_ferry(const osmium::TagList& member_tags, bool permit_untagged_ways = false);
-
     /**
      * Check if a roundabout (closed way) is connected to the front or back node of the previous way.
      *
@@ -182,7 +163,7 @@ public:
 
     /**
      * Check if a way which is neither a stop nor platform is a useable highway/railway/ferry segment for the
-     * given route.
+     * given route according to the way rules.
      *
      * \param relation route relation
      *
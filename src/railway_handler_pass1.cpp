@@ -6,8 +6,29 @@
  */
 
 #include "railway_handler_pass1.hpp"
+#include "tag_projection.hpp"
 #include <iostream>
 
+/// keys written to the stops, platforms and stations layers, in ascending order
+static constexpr size_t STOP_KEYS_COUNT = 9;
+static constexpr const char* STOP_KEYS[STOP_KEYS_COUNT] = {
+    "amenity", "highway", "local_ref", "name", "network", "operator", "public_transport", "railway", "ref"
+};
+static_assert(tag_keys_sorted(STOP_KEYS), "STOP_KEYS has to be sorted");
+
+/// indexes of STOP_KEYS
+struct StopLayerKeys {
+    static constexpr size_t amenity = 0;
+    static constexpr size_t highway = 1;
+    static constexpr size_t local_ref = 2;
+    static constexpr size_t name = 3;
+    static constexpr size_t network = 4;
+    static constexpr size_t _operator = 5;
+    static constexpr size_t public_transport = 6;
+    static constexpr size_t railway = 7;
+    static constexpr size_t ref = 8;
+};
+
 /// indexes of fields – all layers
 struct FieldIndexes {
     static constexpr int node_id = 0;
@@ -136,20 +157,31 @@ void RailwayHandlerPass1::node(const osmium::Node& node) {
     if (!node.location().valid()) {
         return;
     }
-    const char* railway = node.get_value_by_key("railway");
-    const char* public_transport = node.get_value_by_key("public_transport");
-    if (m_output.options().railway_details && railway &&
-            (!strcmp(railway, "signal") || !strcmp(railway, "stop")
-             || !strcmp(railway, "buffer_stop") || !strcmp(railway, "level_crossing")
-             || !strcmp(railway, "milestone") || !strcmp(railway, "derail")
-             || !strcmp(railway, "isolated_track_section") || !strcmp(railway, "switch")
-             || !strcmp(railway, "railway_crossing"))) {
-        m_must_on_track_handles.emplace(node.id(), m_must_on_track.add_item(node));
-    } else if (public_transport && !strcmp(public_transport, "stop_position")) {
+    const TagValue railway = classify_tag_value(node.get_value_by_key("railway"));
+    const TagValue public_transport = classify_tag_value(node.get_value_by_key("public_transport"));
+    bool must_on_track = false;
+    if (m_output.options().railway_details) {
+        switch (railway) {
+        case TagValue::SIGNAL:
+        case TagValue::STOP:
+        case TagValue::BUFFER_STOP:
+        case TagValue::LEVEL_CROSSING:
+        case TagValue::MILESTONE:
+        case TagValue::DERAIL:
+        case TagValue::ISOLATED_TRACK_SECTION:
+        case TagValue::SWITCH:
+        case TagValue::RAILWAY_CROSSING:
+            must_on_track = true;
+            break;
+        default:
+            break;
+        }
+    }
+    if (must_on_track || public_transport == TagValue::STOP_POSITION) {
         m_must_on_track_handles.emplace(node.id(), m_must_on_track.add_item(node));
     }
     handle_stop(node, public_transport, railway);
-    if (railway && m_output.options().crossings && (!strcmp(railway, "level_crossing") || !strcmp(railway, "crossing"))) {
+    if (m_output.options().crossings && (railway == TagValue::LEVEL_CROSSING || railway == TagValue::CROSSING)) {
         handle_crossing(node);
     }
 }
@@ -162,16 +194,24 @@ void RailwayHandlerPass1::handle_crossing(const osmium::Node& node) {
     std::string lights_value;
     if (!barrier) {
         barrier_value = "NONE";
-    } else if (barrier && strcmp(barrier, "no") && strcmp(barrier, "yes")
-            && strcmp(barrier, "half") && strcmp(barrier, "double_half")
-            && strcmp(barrier, "full") && strcmp(barrier, "gates")) {
-        barrier_value = "UNKNOWN";
     } else {
-        barrier_value = barrier;
+        switch (classify_tag_value(barrier)) {
+        case TagValue::NO:
+        case TagValue::YES:
+        case TagValue::HALF:
+        case TagValue::DOUBLE_HALF:
+        case TagValue::FULL:
+        case TagValue::GATES:
+            barrier_value = barrier;
+            break;
+        default:
+            barrier_value = "UNKNOWN";
+        }
     }
+    const TagValue lights_class = classify_tag_value(lights);
     if (!lights) {
         lights_value = "NONE";
-    } else if (lights && strcmp(lights, "yes") && strcmp(lights, "no")) {
+    } else if (lights_class != TagValue::YES && lights_class != TagValue::NO) {
         lights_value = "UNKNOWN";
     } else {
         lights_value = lights;
@@ -179,11 +219,37 @@ void RailwayHandlerPass1::handle_crossing(const osmium::Node& node) {
     add_crossing_node(node, CrossingIndexes::barrier, barrier_value.c_str(), CrossingIndexes::lights, lights_value.c_str());
 }
 
-void RailwayHandlerPass1::handle_stop(const osmium::OSMObject& object, const char* public_transport, const char* railway) {
+/*static*/ bool RailwayHandlerPass1::is_station(const osmium::OSMObject& object, TagValue public_transport, TagValue railway) {
+    return public_transport == TagValue::STATION || railway == TagValue::STATION || railway == TagValue::HALT
+            || railway == TagValue::TRAM_STOP
+            || (object.tags().has_key("railway") && object.tags().has_tag("amenity", "bus_station"));
+}
+
+/*static*/ bool RailwayHandlerPass1::is_platform(TagValue public_transport, TagValue railway) {
+    return public_transport == TagValue::PLATFORM || railway == TagValue::PLATFORM;
+}
+
+/*static*/ bool RailwayHandlerPass1::needs_way_geometry(const osmium::Way& way, const Options& options) {
+    const TagValue railway = classify_tag_value(way.get_value_by_key("railway"));
+    const TagValue public_transport = classify_tag_value(way.get_value_by_key("public_transport"));
+    return (options.stations && is_station(way, public_transport, railway))
+            || (options.platforms && is_platform(public_transport, railway));
+}
+
+/*static*/ const CandidateKeys& RailwayHandlerPass1::node_keys() {
+    // highway=bus_stop without public_transport=* is written to its own layer.
+    static const CandidateKeys keys {"highway", "public_transport", "railway"};
+    return keys;
+}
+
+/*static*/ const CandidateKeys& RailwayHandlerPass1::way_keys() {
+    static const CandidateKeys keys {"public_transport", "railway"};
+    return keys;
+}
+
+void RailwayHandlerPass1::handle_stop(const osmium::OSMObject& object, TagValue public_transport, TagValue railway) {
     if (m_output.options().stations) {
-        if ((public_transport && !strcmp(public_transport, "station"))
-                || (railway && (!strcmp(railway, "station") || !strcmp(railway, "halt")
-                        || !strcmp(railway, "tram_stop") || object.tags().has_tag("amenity", "bus_station")))) {
+        if (is_station(object, public_transport, railway)) {
             switch (object.type()) {
             case osmium::item_type::node :
                 add_stop_pltf_node(*m_stations, static_cast<const osmium::Node&>(object), false, true);
@@ -198,7 +264,7 @@ void RailwayHandlerPass1::handle_stop(const osmium::OSMObject& object, const cha
         }
     }
     if (m_output.options().platforms) {
-        if ((public_transport && !strcmp(public_transport, "platform")) || (railway && !strcmp(railway, "platform"))) {
+        if (is_platform(public_transport, railway)) {
             switch (object.type()) {
             case osmium::item_type::node :
                 add_stop_pltf_node(*m_platforms, static_cast<const osmium::Node&>(object), true, false);
@@ -215,7 +281,7 @@ void RailwayHandlerPass1::handle_stop(const osmium::OSMObject& object, const cha
     if (object.type() != osmium::item_type::node) {
         return;
     }
-    if (m_output.options().stops && public_transport && !strcmp(public_transport, "stop_position")) {
+    if (m_output.options().stops && public_transport == TagValue::STOP_POSITION) {
         add_stop_pltf_node(*m_stops, static_cast<const osmium::Node&>(object), true, false);
         return;
     }
@@ -227,8 +293,8 @@ void RailwayHandlerPass1::handle_stop(const osmium::OSMObject& object, const cha
 void RailwayHandlerPass1::way(const osmium::Way& way) {
     try {
         if (m_output.options().stops || m_output.options().stations || m_output.options().platforms) {
-            const char* railway = way.get_value_by_key("railway");
-            const char* public_transport = way.get_value_by_key("public_transport");
+            const TagValue railway = classify_tag_value(way.get_value_by_key("railway"));
+            const TagValue public_transport = classify_tag_value(way.get_value_by_key("public_transport"));
             handle_stop(way, public_transport, railway);
         }
     } catch (osmium::invalid_location& err) {
@@ -241,7 +307,7 @@ void RailwayHandlerPass1::add_crossing_node(const osmium::Node& node, const int
     if (!m_output.coordinates_valid(node)) {
         return;
     }
-    gdalcpp::Feature feature(*m_crossings, m_output.factory().create_point(node));
+    OutputFeature feature(m_output.writer(), *m_crossings, m_output.factory().create_point(node));
     set_node_id(feature, node);
     std::string the_timestamp (node.timestamp().to_iso());
     feature.set_field(FieldIndexes::lastchange, the_timestamp.c_str());
@@ -258,7 +324,7 @@ void RailwayHandlerPass1::add_stop_pltf_node(gdalcpp::Layer& layer, const osmium
     if (!m_output.coordinates_valid(node)) {
         return;
     }
-    gdalcpp::Feature feature(layer, m_output.factory().create_point(node));
+    OutputFeature feature(m_output.writer(), layer, m_output.factory().create_point(node));
     set_node_id(feature, node);
     set_fields(feature, node, refs, amenity);
     feature.add_to_layer();
@@ -269,7 +335,7 @@ void RailwayHandlerPass1::add_stop_pltf_way(gdalcpp::Layer& layer, const osmium:
         return;
     }
     try {
-        gdalcpp::Feature feature(layer, m_output.factory().create_linestring(way));
+        OutputFeature feature(m_output.writer(), layer, m_output.factory().create_linestring(way));
         set_way_id(feature, way);
         set_fields(feature, way, refs, amenity);
         feature.add_to_layer();
@@ -278,35 +344,61 @@ void RailwayHandlerPass1::add_stop_pltf_way(gdalcpp::Layer& layer, const osmium:
     }
 }
 
-/*static*/ void RailwayHandlerPass1::set_fields(gdalcpp::Feature& feature, const osmium::OSMObject& object,
+/*static*/ void RailwayHandlerPass1::set_fields(OutputFeature& feature, const osmium::OSMObject& object,
         bool refs, bool amenity) {
     std::string the_timestamp (object.timestamp().to_iso());
+    const TagProjection<STOP_KEYS_COUNT> tags {STOP_KEYS, object.tags()};
     feature.set_field(FieldIndexes::lastchange, the_timestamp.c_str());
-    feature.set_field(StopsPlatformsStationIndexes::railway, object.get_value_by_key("railway", ""));
-    feature.set_field(StopsPlatformsStationIndexes::public_transport, object.get_value_by_key("public_transport", ""));
-    feature.set_field(StopsPlatformsStationIndexes::highway, object.get_value_by_key("highway", ""));
-    feature.set_field(StopsPlatformsStationIndexes::name, object.get_value_by_key("name", ""));
-    feature.set_field(StopsPlatformsStationIndexes::network, object.get_value_by_key("network", ""));
-    feature.set_field(StopsPlatformsStationIndexes::_operator, object.get_value_by_key("operator", ""));
+    feature.set_field(StopsPlatformsStationIndexes::railway, tags.get(StopLayerKeys::railway, ""));
+    feature.set_field(StopsPlatformsStationIndexes::public_transport, tags.get(StopLayerKeys::public_transport, ""));
+    feature.set_field(StopsPlatformsStationIndexes::highway, tags.get(StopLayerKeys::highway, ""));
+    feature.set_field(StopsPlatformsStationIndexes::name, tags.get(StopLayerKeys::name, ""));
+    feature.set_field(StopsPlatformsStationIndexes::network, tags.get(StopLayerKeys::network, ""));
+    feature.set_field(StopsPlatformsStationIndexes::_operator, tags.get(StopLayerKeys::_operator, ""));
     if (refs) {
-        feature.set_field(StopsPlatformsIndexes::ref, object.get_value_by_key("ref", ""));
-        feature.set_field(StopsPlatformsIndexes::local_ref, object.get_value_by_key("local_ref", ""));
+        feature.set_field(StopsPlatformsIndexes::ref, tags.get(StopLayerKeys::ref, ""));
+        feature.set_field(StopsPlatformsIndexes::local_ref, tags.get(StopLayerKeys::local_ref, ""));
     }
     if (amenity) {
-        feature.set_field(StationsIndexes::amenity, object.get_value_by_key("amenity", ""));
+        feature.set_field(StationsIndexes::amenity, tags.get(StopLayerKeys::amenity, ""));
     }
 }
 
-/*static*/ void RailwayHandlerPass1::set_node_id(gdalcpp::Feature& feature, const osmium::Node& node) {
-    static char idbuffer[20];
+/*static*/ void RailwayHandlerPass1::set_node_id(OutputFeature& feature, const osmium::Node& node) {
+    // not static because multiple instances of this handler might run in parallel
+    char idbuffer[20];
     sprintf(idbuffer, "%ld", node.id());
     feature.set_field(FieldIndexes::node_id, idbuffer);
 }
 
-/*static*/ void RailwayHandlerPass1::set_way_id(gdalcpp::Feature& feature, const osmium::Way& way) {
-    static char idbuffer[20];
+/*static*/ void RailwayHandlerPass1::set_way_id(OutputFeature& feature, const osmium::Way& way) {
+    char idbuffer[20];
     sprintf(idbuffer, "%ld", way.id());
     feature.set_field(FieldIndexes::way_id, idbuffer);
 }
 
 void RailwayHandlerPass1::relation(const osmium::Relation&) {}
+
+void RailwayHandlerPass1::merge(std::vector<RailwayHandlerPass1*>& others) {
+    // The destination layers must not be written by the output thread at the same time.
+    m_output.writer().flush();
+    merge_layer(&RailwayHandlerPass1::m_crossings, others);
+    merge_layer(&RailwayHandlerPass1::m_stops, others);
+    merge_layer(&RailwayHandlerPass1::m_platforms, others);
+    merge_layer(&RailwayHandlerPass1::m_platforms_l, others);
+    merge_layer(&RailwayHandlerPass1::m_stations, others);
+    merge_layer(&RailwayHandlerPass1::m_stations_l, others);
+    merge_layer(&RailwayHandlerPass1::m_stops_only_highway, others);
+}
+
+void RailwayHandlerPass1::merge_layer(std::unique_ptr<gdalcpp::Layer> RailwayHandlerPass1::* layer,
+        std::vector<RailwayHandlerPass1*>& others) {
+    if (!(this->*layer)) {
+        return;
+    }
+    std::vector<OGRLayer*> sources;
+    for (RailwayHandlerPass1* other : others) {
+        sources.push_back(&(other->*layer)->get());
+    }
+    OGRWriter::merge_layers(*(this->*layer), sources);
+}
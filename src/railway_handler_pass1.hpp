@@ -10,11 +10,14 @@
 
 #include <unordered_map>
 #include <memory>
+#include <vector>
 
 #include <osmium/handler.hpp>
 #include <osmium/storage/item_stash.hpp>
 
+#include "candidate_filter.hpp"
 #include "ogr_output_base.hpp"
+#include "tag_value.hpp"
 
 /**
  * This handler class creates the level crossings layer and populates the map of nodes which have
@@ -51,18 +54,21 @@ class RailwayHandlerPass1 : public osmium::handler::Handler {
     void add_crossing_node(const osmium::Node& node, const int third_field_index,
             const char* third_field_value, const int fourth_field_index, const char* fourth_field_value);
 
-    void handle_stop(const osmium::OSMObject& object, const char* public_transport, const char* railway);
+    void handle_stop(const osmium::OSMObject& object, TagValue public_transport, TagValue railway);
 
     void add_stop_pltf_node(gdalcpp::Layer& layer, const osmium::Node& node, bool refs, bool amenity);
 
     void add_stop_pltf_way(gdalcpp::Layer& layer, const osmium::Way& way, bool refs, bool amenity);
 
-    static void set_fields(gdalcpp::Feature& feature, const osmium::OSMObject& object,
+    static void set_fields(OutputFeature& feature, const osmium::OSMObject& object,
             bool refs, bool amenity);
 
-    static void set_node_id(gdalcpp::Feature& feature, const osmium::Node& node);
+    static void set_node_id(OutputFeature& feature, const osmium::Node& node);
 
-    static void set_way_id(gdalcpp::Feature& feature, const osmium::Way& way);
+    static void set_way_id(OutputFeature& feature, const osmium::Way& way);
+
+    void merge_layer(std::unique_ptr<gdalcpp::Layer> RailwayHandlerPass1::* layer,
+            std::vector<RailwayHandlerPass1*>& others);
 
 public:
 
@@ -72,11 +78,46 @@ public:
             osmium::ItemStash& signals, std::unordered_map<osmium::object_id_type,
             osmium::ItemStash::handle_type>& must_on_track_handles);
 
+    /**
+     * Is the object written to one of the stations layers?
+     */
+    static bool is_station(const osmium::OSMObject& object, TagValue public_transport, TagValue railway);
+
+    /**
+     * Is the object written to one of the platforms layers?
+     */
+    static bool is_platform(TagValue public_transport, TagValue railway);
+
+    /**
+     * Does this handler need the locations of the nodes of this way?
+     */
+    static bool needs_way_geometry(const osmium::Way& way, const Options& options);
+
+    /**
+     * Keys of the nodes this handler reads. Nodes without any of them are ignored by node().
+     */
+    static const CandidateKeys& node_keys();
+
+    /**
+     * Keys of the ways this handler reads. Ways without any of them are ignored by way().
+     */
+    static const CandidateKeys& way_keys();
+
     void node(const osmium::Node& node);
 
     void way(const osmium::Way&);
 
     void relation(const osmium::Relation&);
+
+    /**
+     * Copy the features written by other instances of this handler into the layers of this handler.
+     *
+     * The other handlers must have been constructed with the same options. The features of each
+     * layer are ordered by the ID of the OSM object.
+     *
+     * \param others handlers to read the features from
+     */
+    void merge(std::vector<RailwayHandlerPass1*>& others);
 };
 
 
@@ -39,6 +39,11 @@ RailwayHandlerPass2::RailwayHandlerPass2(OGRWriter& writer, osmium::index::IdSet
     m_on_track.add_field("error", OFTString, 21);
 }
 
+/*static*/ const CandidateKeys& RailwayHandlerPass2::node_keys() {
+    static const CandidateKeys keys {"railway"};
+    return keys;
+}
+
 void RailwayHandlerPass2::node(const osmium::Node& node) {
     if (!m_options.points) {
         return;
@@ -53,7 +58,7 @@ void RailwayHandlerPass2::handle_point(const osmium::Node& node) {
     if (!m_output.coordinates_valid(node)) {
         return;
     }
-    gdalcpp::Feature feature(*m_points, m_output.factory().create_point(node));
+    OutputFeature feature(m_output.writer(), *m_points, m_output.factory().create_point(node));
     static char idbuffer[20];
     sprintf(idbuffer, "%ld", node.id());
     feature.set_field(FieldIndexes::node_id, idbuffer);
@@ -107,7 +112,7 @@ void RailwayHandlerPass2::after_ways() {
         if (!m_output.coordinates_valid(node)) {
             continue;
         }
-        gdalcpp::Feature feature(m_on_track, m_output.factory().create_point(node));
+        OutputFeature feature(m_output.writer(), m_on_track, m_output.factory().create_point(node));
         static char idbuffer[20];
         sprintf(idbuffer, "%ld", node.id());
         feature.set_field(FieldIndexes::node_id, idbuffer);
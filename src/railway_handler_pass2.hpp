@@ -15,6 +15,7 @@
 #include <osmium/index/id_set.hpp>
 #include <osmium/storage/item_stash.hpp>
 
+#include "candidate_filter.hpp"
 #include "ogr_output_base.hpp"
 
 /**
@@ -51,6 +52,12 @@ public:
             std::unordered_map<osmium::object_id_type, osmium::ItemStash::handle_type>& must_on_track_handles,
             osmium::ItemStash& must_on_track, Options& options, osmium::util::VerboseOutput& verbose_output);
 
+    /**
+     * Keys of the nodes this handler reads. Nodes without any of them are ignored by node().
+     * All ways are read because a node may be referenced by any way.
+     */
+    static const CandidateKeys& node_keys();
+
     void node(const osmium::Node& node);
 
     void way(const osmium::Way& way);
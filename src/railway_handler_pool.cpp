@@ -0,0 +1,132 @@
+/*
+ * railway_handler_pool.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <algorithm>
+#include <tuple>
+
+#include <osmium/visitor.hpp>
+
+#include "railway_handler_pool.hpp"
+
+/// maximum number of buffers waiting in the queue of a worker
+static constexpr size_t MAX_WORKER_QUEUE_SIZE = 20;
+
+/**
+ * Copy the options but write to in-memory datasets. Writing to memory is fast, therefore no output
+ * thread is used.
+ */
+static Options in_memory_options(const Options& options) {
+    Options result = options;
+    result.output_format = "Memory";
+    result.async_output = false;
+    result.bulk_load = false;
+    return result;
+}
+
+RailwayHandlerWorker::RailwayHandlerWorker(const Options& main_options, osmium::util::VerboseOutput& verbose_output,
+        const Region* region) :
+        options(in_memory_options(main_options)),
+        writer(options, verbose_output),
+        must_on_track(),
+        must_on_track_handles(),
+        handler(writer, options, verbose_output, must_on_track, must_on_track_handles),
+        region_filter(handler, region, Shard{options}),
+        candidate_filter(region_filter, RailwayHandlerPass1::node_keys(), &RailwayHandlerPass1::way_keys()),
+        queue(MAX_WORKER_QUEUE_SIZE, "railway_handler_worker"),
+        error(),
+        thread() {
+}
+
+void RailwayHandlerWorker::run() {
+    while (true) {
+        osmium::memory::Buffer buffer;
+        queue.wait_and_pop(buffer);
+        if (!buffer) {
+            return;
+        }
+        // After an error, the remaining buffers are dropped to let the reading thread continue.
+        if (error) {
+            continue;
+        }
+        try {
+            osmium::apply(buffer, candidate_filter);
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+}
+
+RailwayHandlerPool::RailwayHandlerPool(RailwayHandlerPass1& main_handler, osmium::ItemStash& must_on_track,
+        std::unordered_map<osmium::object_id_type, osmium::ItemStash::handle_type>& must_on_track_handles,
+        Options& options, osmium::util::VerboseOutput& verbose_output, const Region* region) :
+        m_main_handler(main_handler),
+        m_must_on_track(must_on_track),
+        m_must_on_track_handles(must_on_track_handles),
+        m_workers() {
+    for (int i = 0; i < options.threads; ++i) {
+        m_workers.emplace_back(new RailwayHandlerWorker(options, verbose_output, region));
+    }
+    for (auto& worker : m_workers) {
+        worker->thread = std::thread(&RailwayHandlerWorker::run, worker.get());
+    }
+}
+
+RailwayHandlerPool::~RailwayHandlerPool() {
+    stop_workers();
+}
+
+void RailwayHandlerPool::add_buffer(osmium::memory::Buffer&& buffer) {
+    m_workers.at(m_next_worker)->queue.push(std::move(buffer));
+    m_next_worker = (m_next_worker + 1) % m_workers.size();
+}
+
+void RailwayHandlerPool::stop_workers() {
+    for (auto& worker : m_workers) {
+        if (worker->thread.joinable()) {
+            worker->queue.push(osmium::memory::Buffer{});
+        }
+    }
+    for (auto& worker : m_workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void RailwayHandlerPool::finish() {
+    stop_workers();
+    for (auto& worker : m_workers) {
+        if (worker->error) {
+            std::rethrow_exception(worker->error);
+        }
+    }
+    std::vector<RailwayHandlerPass1*> handlers;
+    for (auto& worker : m_workers) {
+        handlers.push_back(&(worker->handler));
+    }
+    m_main_handler.merge(handlers);
+    merge_must_on_track();
+    m_workers.clear();
+}
+
+void RailwayHandlerPool::merge_must_on_track() {
+    // (OSM ID, worker index, handle) – sorted to make the insertion order into the main map independent
+    // from the distribution of the buffers to the workers
+    std::vector<std::tuple<osmium::object_id_type, size_t, osmium::ItemStash::handle_type>> items;
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        for (const auto& id_handle : m_workers[i]->must_on_track_handles) {
+            items.emplace_back(id_handle.first, i, id_handle.second);
+        }
+    }
+    std::sort(items.begin(), items.end(), [](const std::tuple<osmium::object_id_type, size_t, osmium::ItemStash::handle_type>& a,
+            const std::tuple<osmium::object_id_type, size_t, osmium::ItemStash::handle_type>& b) {
+        return std::get<0>(a) < std::get<0>(b);
+    });
+    for (const auto& item : items) {
+        const osmium::memory::Item& node = m_workers[std::get<1>(item)]->must_on_track.get_item(std::get<2>(item));
+        m_must_on_track_handles.emplace(std::get<0>(item), m_must_on_track.add_item(node));
+    }
+}
@@ -0,0 +1,121 @@
+/*
+ * railway_handler_pool.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_RAILWAY_HANDLER_POOL_HPP_
+#define SRC_RAILWAY_HANDLER_POOL_HPP_
+
+#include <exception>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/storage/item_stash.hpp>
+#include <osmium/thread/queue.hpp>
+
+#include "candidate_filter.hpp"
+#include "railway_handler_pass1.hpp"
+#include "region.hpp"
+
+/**
+ * A worker thread with its own RailwayHandlerPass1.
+ *
+ * The handler of the worker writes into in-memory datasets and collects the nodes which have to be
+ * on a track in its own ItemStash.
+ */
+struct RailwayHandlerWorker {
+    Options options;
+
+    OGRWriter writer;
+
+    osmium::ItemStash must_on_track;
+
+    std::unordered_map<osmium::object_id_type, osmium::ItemStash::handle_type> must_on_track_handles;
+
+    RailwayHandlerPass1 handler;
+
+    /// passes only nodes and ways inside the region and owned by the shard to the handler
+    RegionFilter<RailwayHandlerPass1> region_filter;
+
+    /// passes only nodes and ways with keys read by the handler to the region filter
+    CandidateFilter<RegionFilter<RailwayHandlerPass1>> candidate_filter;
+
+    /// Buffers to be processed by this worker. An invalid buffer signals the end of the input.
+    osmium::thread::Queue<osmium::memory::Buffer> queue;
+
+    /// exception thrown by the thread, rethrown by RailwayHandlerPool::finish()
+    std::exception_ptr error;
+
+    std::thread thread;
+
+    RailwayHandlerWorker(const Options& main_options, osmium::util::VerboseOutput& verbose_output, const Region* region);
+
+    void run();
+};
+
+/**
+ * This class runs RailwayHandlerPass1 on multiple threads.
+ *
+ * Buffers are handed to the workers in round-robin order after the location handler has been applied
+ * on the reading thread. After the last buffer, the features of all workers are merged into the layers
+ * of the main handler (ordered by OSM ID) and the nodes which have to be on a track are moved into
+ * the main ItemStash (ordered by OSM ID, too). Therefore, the output does not depend on the scheduling
+ * of the threads.
+ */
+class RailwayHandlerPool {
+    RailwayHandlerPass1& m_main_handler;
+
+    osmium::ItemStash& m_must_on_track;
+
+    std::unordered_map<osmium::object_id_type, osmium::ItemStash::handle_type>& m_must_on_track_handles;
+
+    std::vector<std::unique_ptr<RailwayHandlerWorker>> m_workers;
+
+    /// index of the worker which gets the next buffer
+    size_t m_next_worker = 0;
+
+    void merge_must_on_track();
+
+    /**
+     * Signal the end of the input to the workers and wait for them.
+     */
+    void stop_workers();
+
+public:
+    RailwayHandlerPool() = delete;
+
+    /**
+     * \param main_handler handler whose layers receive the merged features. It does not get any buffers.
+     * \param must_on_track ItemStash of the main handler
+     * \param must_on_track_handles handle map of the main handler
+     * \param options options, the number of workers is read from them
+     * \param verbose_output verbose output
+     * \param region region the handlers are restricted to, nullptr if there is no restriction
+     */
+    RailwayHandlerPool(RailwayHandlerPass1& main_handler, osmium::ItemStash& must_on_track,
+            std::unordered_map<osmium::object_id_type, osmium::ItemStash::handle_type>& must_on_track_handles,
+            Options& options, osmium::util::VerboseOutput& verbose_output, const Region* region);
+
+    /**
+     * Stop the workers if finish() has not been called, e.g. because reading the input failed.
+     */
+    ~RailwayHandlerPool();
+
+    /**
+     * Hand a buffer to the next worker. Blocks if the queue of the worker is full.
+     */
+    void add_buffer(osmium::memory::Buffer&& buffer);
+
+    /**
+     * Wait for all workers to finish and merge their results.
+     *
+     * \throws any exception thrown by a worker
+     */
+    void finish();
+};
+
+#endif /* SRC_RAILWAY_HANDLER_POOL_HPP_ */
@@ -0,0 +1,114 @@
+/*
+ * region.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "region.hpp"
+
+/*static*/ Region Region::from_bbox(const std::string& bbox) {
+    double coordinates[4];
+    std::istringstream in(bbox);
+    for (int i = 0; i < 4; ++i) {
+        char separator = ',';
+        if ((i > 0 && !(in >> separator)) || separator != ',' || !(in >> coordinates[i])) {
+            throw std::invalid_argument{"Invalid bounding box: " + bbox};
+        }
+    }
+    Region region;
+    region.m_box.extend(osmium::Location{coordinates[0], coordinates[1]});
+    region.m_box.extend(osmium::Location{coordinates[2], coordinates[3]});
+    if (!region.m_box.valid() || coordinates[0] > coordinates[2] || coordinates[1] > coordinates[3]) {
+        throw std::invalid_argument{"Invalid bounding box: " + bbox};
+    }
+    return region;
+}
+
+/*static*/ Region Region::from_poly_file(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file) {
+        throw std::runtime_error{"Cannot open polygon file " + filename};
+    }
+    Region region;
+    std::string line;
+    // first line: name of the polygon
+    std::getline(file, line);
+    bool in_ring = false;
+    while (std::getline(file, line)) {
+        std::istringstream in(line);
+        std::string first;
+        if (!(in >> first)) {
+            continue;
+        }
+        if (first == "END") {
+            if (!in_ring) {
+                // end of the file
+                break;
+            }
+            in_ring = false;
+        } else if (!in_ring) {
+            // name of a ring, `!` marks holes
+            region.m_rings.emplace_back();
+            in_ring = true;
+        } else {
+            std::istringstream coordinates(line);
+            double lon;
+            double lat;
+            if (!(coordinates >> lon >> lat)) {
+                throw std::runtime_error{"Invalid line in polygon file " + filename + ": " + line};
+            }
+            const osmium::Location location {lon, lat};
+            region.m_rings.back().push_back(location);
+            region.m_box.extend(location);
+        }
+    }
+    if (region.m_rings.empty() || !region.m_box.valid()) {
+        throw std::runtime_error{"Polygon file " + filename + " does not contain any ring"};
+    }
+    return region;
+}
+
+const osmium::Box& Region::box() const noexcept {
+    return m_box;
+}
+
+bool Region::polygon_contains(const osmium::Location& location) const {
+    bool inside = false;
+    const int32_t x = location.x();
+    const int32_t y = location.y();
+    for (const auto& ring : m_rings) {
+        for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+            const osmium::Location& a = ring[i];
+            const osmium::Location& b = ring[j];
+            if ((a.y() > y) != (b.y() > y)) {
+                const double intersection_x = a.x() + static_cast<double>(b.x() - a.x()) * (y - a.y()) / (b.y() - a.y());
+                if (x < intersection_x) {
+                    inside = !inside;
+                }
+            }
+        }
+    }
+    return inside;
+}
+
+bool Region::contains(const osmium::Location& location) const {
+    if (!location.valid() || !m_box.contains(location)) {
+        return false;
+    }
+    return m_rings.empty() || polygon_contains(location);
+}
+
+bool Region::contains(const osmium::Way& way) const {
+    bool any_valid = false;
+    for (const osmium::NodeRef& node_ref : way.nodes()) {
+        if (contains(node_ref.location())) {
+            return true;
+        }
+        any_valid = any_valid || node_ref.location().valid();
+    }
+    return !any_valid;
+}
@@ -0,0 +1,114 @@
+/*
+ * region.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_REGION_HPP_
+#define SRC_REGION_HPP_
+
+#include <string>
+#include <vector>
+
+#include <osmium/handler.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+
+#include "shard.hpp"
+
+/**
+ * A region the output is clipped to. It is either a bounding box or a polygon read from a file in
+ * the Osmosis polygon filter format (.poly).
+ */
+class Region {
+
+    /// bounding box of the region
+    osmium::Box m_box;
+
+    /// rings of the polygon, empty if the region is a bounding box
+    std::vector<std::vector<osmium::Location>> m_rings;
+
+    Region() = default;
+
+    /**
+     * Point-in-polygon test using the even-odd rule. Holes are rings like all others.
+     */
+    bool polygon_contains(const osmium::Location& location) const;
+
+public:
+    /**
+     * Create a region from a bounding box.
+     *
+     * \param bbox bounding box in the format `MINLON,MINLAT,MAXLON,MAXLAT`
+     *
+     * \throws std::invalid_argument if the bounding box cannot be parsed
+     */
+    static Region from_bbox(const std::string& bbox);
+
+    /**
+     * Create a region from a polygon file.
+     *
+     * \throws std::runtime_error if the file cannot be read or parsed
+     */
+    static Region from_poly_file(const std::string& filename);
+
+    const osmium::Box& box() const noexcept;
+
+    bool contains(const osmium::Location& location) const;
+
+    /**
+     * Is any node of the way inside the region? Ways without any valid location are considered
+     * inside because they cannot be decided.
+     */
+    bool contains(const osmium::Way& way) const;
+};
+
+/**
+ * This handler passes only nodes and ways inside a region and owned by a shard to another handler.
+ * Relations are always passed.
+ *
+ * It has to be called after the location handler because it uses the locations of the way nodes.
+ */
+template <typename THandler>
+class RegionFilter : public osmium::handler::Handler {
+
+    THandler& m_handler;
+
+    /// region, nullptr if everything should be passed
+    const Region* m_region;
+
+    Shard m_shard;
+
+    /// Pass only ways owned by the shard. Handlers checking nodes against all ways need every way.
+    bool m_shard_ways;
+
+public:
+    RegionFilter() = delete;
+
+    RegionFilter(THandler& handler, const Region* region, const Shard& shard = Shard{}, const bool shard_ways = true) :
+        m_handler(handler),
+        m_region(region),
+        m_shard(shard),
+        m_shard_ways(shard_ways) {}
+
+    void node(const osmium::Node& node) {
+        if (m_shard.owns(node) && (!m_region || m_region->contains(node.location()))) {
+            m_handler.node(node);
+        }
+    }
+
+    void way(const osmium::Way& way) {
+        if ((!m_shard_ways || m_shard.owns(way)) && (!m_region || m_region->contains(way))) {
+            m_handler.way(way);
+        }
+    }
+
+    void relation(const osmium::Relation& relation) {
+        m_handler.relation(relation);
+    }
+};
+
+#endif /* SRC_REGION_HPP_ */
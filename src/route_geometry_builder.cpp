@@ -0,0 +1,180 @@
+/*
+ * route_geometry_builder.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <cstring>
+#include <utility>
+
+#include "route_geometry_builder.hpp"
+
+/*static*/ bool RouteGeometryBuilder::is_roundabout(const osmium::Way& way) {
+    // A roundabout needs three different nodes.
+    return way.nodes().size() >= 4 && way.nodes().ends_have_same_id() && way.tags().has_tag("junction", "roundabout");
+}
+
+/*static*/ int RouteGeometryBuilder::roundabout_position(const osmium::Way& roundabout, osmium::object_id_type node,
+        int start /* = 0 */) {
+    // The last node is the same as the first one.
+    const int count = static_cast<int>(roundabout.nodes().size()) - 1;
+    for (int i = 0; i < count; ++i) {
+        const int position = (start + i) % count;
+        if (roundabout.nodes()[position].ref() == node) {
+            return position;
+        }
+    }
+    return -1;
+}
+
+void RouteGeometryBuilder::append_way(const osmium::Way& way) {
+    const osmium::WayNodeList& nodes = way.nodes();
+    if (nodes.front().ref() == m_current.back().ref()) {
+        m_current.insert(m_current.end(), nodes.begin() + 1, nodes.end());
+    } else {
+        m_current.insert(m_current.end(), nodes.rbegin() + 1, nodes.rend());
+    }
+}
+
+void RouteGeometryBuilder::append_arc(const osmium::Way& roundabout, int from, int to) {
+    const int count = static_cast<int>(roundabout.nodes().size()) - 1;
+    int position = from;
+    do {
+        position = (position + 1) % count;
+        m_current.push_back(roundabout.nodes()[position]);
+    } while (position != to);
+}
+
+void RouteGeometryBuilder::start_section(const osmium::Way& way, bool reverse /* = false */) {
+    if (reverse) {
+        m_current.assign(way.nodes().rbegin(), way.nodes().rend());
+    } else {
+        m_current.assign(way.nodes().begin(), way.nodes().end());
+    }
+}
+
+void RouteGeometryBuilder::finish_section() {
+    if (m_roundabout && m_roundabout_entry >= 0) {
+        append_arc(*m_roundabout, m_roundabout_entry, m_roundabout_entry);
+    } else if (m_roundabout) {
+        start_section(*m_roundabout);
+    } else if (m_first_way) {
+        start_section(*m_first_way);
+    }
+    m_roundabout = nullptr;
+    m_roundabout_entry = -1;
+    m_first_way = nullptr;
+    if (m_current.size() >= 2) {
+        m_sections.push_back(std::move(m_current));
+    }
+    m_current.clear();
+}
+
+void RouteGeometryBuilder::add_roundabout(const osmium::Way& way) {
+    if (m_roundabout) {
+        // roundabout after roundabout, not a valid route
+        finish_section();
+    }
+    if (m_first_way) {
+        const osmium::Way& first = *m_first_way;
+        m_first_way = nullptr;
+        if (roundabout_position(way, first.nodes().back().ref()) >= 0) {
+            start_section(first);
+        } else if (roundabout_position(way, first.nodes().front().ref()) >= 0) {
+            start_section(first, true);
+        } else {
+            start_section(first);
+            finish_section();
+        }
+    }
+    int entry = -1;
+    if (!m_current.empty()) {
+        entry = roundabout_position(way, m_current.back().ref());
+        if (entry < 0) {
+            finish_section();
+        }
+    }
+    m_roundabout = &way;
+    m_roundabout_entry = entry;
+}
+
+void RouteGeometryBuilder::add_way(const osmium::Way& way, const char* role) {
+    if (strcmp(role, "")) {
+        finish_section();
+        start_section(way, !strcmp(role, "backward"));
+        finish_section();
+        return;
+    }
+    if (is_roundabout(way)) {
+        add_roundabout(way);
+        return;
+    }
+    const osmium::object_id_type front = way.nodes().front().ref();
+    const osmium::object_id_type back = way.nodes().back().ref();
+    if (m_roundabout) {
+        // The route leaves the roundabout at the first node connected to this way.
+        const osmium::Way& roundabout = *m_roundabout;
+        const int count = static_cast<int>(roundabout.nodes().size()) - 1;
+        const int start = m_roundabout_entry < 0 ? 0 : (m_roundabout_entry + 1) % count;
+        int exit = -1;
+        int distance = count;
+        for (const osmium::object_id_type end : {front, back}) {
+            const int position = roundabout_position(roundabout, end, start);
+            if (position >= 0 && (position - start + count) % count < distance) {
+                exit = position;
+                distance = (position - start + count) % count;
+            }
+        }
+        if (exit < 0) {
+            finish_section();
+            m_first_way = &way;
+            return;
+        }
+        if (m_roundabout_entry < 0) {
+            m_current.push_back(roundabout.nodes()[exit]);
+        }
+        append_arc(roundabout, m_roundabout_entry < 0 ? exit : m_roundabout_entry, exit);
+        m_roundabout = nullptr;
+        m_roundabout_entry = -1;
+        append_way(way);
+        return;
+    }
+    if (m_first_way) {
+        const osmium::Way& first = *m_first_way;
+        const osmium::object_id_type first_back = first.nodes().back().ref();
+        const osmium::object_id_type first_front = first.nodes().front().ref();
+        if (first_back == front || first_back == back) {
+            start_section(first);
+        } else if (first_front == front || first_front == back) {
+            start_section(first, true);
+        } else {
+            finish_section();
+            m_first_way = &way;
+            return;
+        }
+        m_first_way = nullptr;
+        append_way(way);
+        return;
+    }
+    if (m_current.empty()) {
+        m_first_way = &way;
+        return;
+    }
+    if (front == m_current.back().ref() || back == m_current.back().ref()) {
+        append_way(way);
+    } else {
+        finish_section();
+        m_first_way = &way;
+    }
+}
+
+void RouteGeometryBuilder::add_gap() {
+    finish_section();
+}
+
+std::vector<RouteGeometryBuilder::section_type> RouteGeometryBuilder::finish() {
+    finish_section();
+    std::vector<section_type> sections;
+    sections.swap(m_sections);
+    return sections;
+}
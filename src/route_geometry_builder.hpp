@@ -0,0 +1,101 @@
+/*
+ * route_geometry_builder.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_ROUTE_GEOMETRY_BUILDER_HPP_
+#define SRC_ROUTE_GEOMETRY_BUILDER_HPP_
+
+#include <vector>
+
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/way.hpp>
+
+/**
+ * Merge the member ways of a route into continuous sections.
+ *
+ * The ways are added in the order of the member list. Consecutive ways sharing an end node are
+ * joined into one section oriented in travel direction. The direction of the first way of a section
+ * is taken from its connection to the second one. Roundabouts (closed ways tagged with
+ * junction=roundabout) are cut to the arc from the entry to the exit node in the direction of the
+ * way. A roundabout at the beginning or end of a section, whose entry or exit is unknown, is
+ * added as a full loop ending at the exit or starting at the entry.
+ *
+ * A section ends at gaps, missing members and ways with the role `forward` or `backward`. The latter
+ * form sections of their own in the direction given by their role.
+ */
+class RouteGeometryBuilder {
+public:
+    using section_type = std::vector<osmium::NodeRef>;
+
+private:
+    std::vector<section_type> m_sections;
+
+    /// nodes of the current section in travel direction, empty if the section has not been started
+    section_type m_current;
+
+    /// first way of the current section, its direction is not known yet. nullptr if there is none.
+    const osmium::Way* m_first_way = nullptr;
+
+    /// roundabout whose exit is not known yet, nullptr if there is none
+    const osmium::Way* m_roundabout = nullptr;
+
+    /// position of the entry node in the roundabout, -1 if the roundabout starts the section
+    int m_roundabout_entry = -1;
+
+    static bool is_roundabout(const osmium::Way& way);
+
+    /**
+     * Position of a node in a roundabout, -1 if it is not a node of the roundabout.
+     *
+     * \param start position to start the search at, the nodes are searched in the direction of the way
+     */
+    static int roundabout_position(const osmium::Way& roundabout, osmium::object_id_type node, int start = 0);
+
+    /**
+     * Append the nodes of a way to the current section. The end of the section has to be one
+     * of the ends of the way.
+     */
+    void append_way(const osmium::Way& way);
+
+    /**
+     * Append the nodes of the roundabout from the node after \p from to the node \p to to the
+     * current section. If both are equal, the full loop is appended.
+     */
+    void append_arc(const osmium::Way& roundabout, int from, int to);
+
+    /**
+     * Start a new section with the nodes of a way in the direction of the way.
+     */
+    void start_section(const osmium::Way& way, bool reverse = false);
+
+    /**
+     * Finish the current section including the pending ways.
+     */
+    void finish_section();
+
+    void add_roundabout(const osmium::Way& way);
+
+public:
+    /**
+     * Add a member way. The way has to have at least two nodes.
+     *
+     * \param role role of the member, the empty string, `forward` or `backward`
+     */
+    void add_way(const osmium::Way& way, const char* role);
+
+    /**
+     * Interrupt the current section, e.g. because a member is missing.
+     */
+    void add_gap();
+
+    /**
+     * Finish the route.
+     *
+     * \returns sections of the route with at least two nodes each. The builder is empty afterwards.
+     */
+    std::vector<section_type> finish();
+};
+
+#endif /* SRC_ROUTE_GEOMETRY_BUILDER_HPP_ */
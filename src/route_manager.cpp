@@ -8,27 +8,39 @@
 #include <osmium/osm/item_type.hpp>
 
 #include "route_manager.hpp"
+#include "route_validation_pool.hpp"
+#include "tag_value.hpp"
 
 
 RouteManager::RouteManager(OGRWriter& ogr_writer, Options& options, osmium::util::VerboseOutput& verbose_output) :
         m_writer(ogr_writer, options, verbose_output),
-        m_checker(m_writer) { }
+        m_way_rules(options.way_rules.empty() ? WayRules::defaults() : WayRules::from_file(options.way_rules)),
+        m_checker(m_writer, m_way_rules),
+        m_statistics(),
+        m_shard(options) { }
+
+RouteManager::~RouteManager() = default;
 
 bool RouteManager::new_relation(const osmium::Relation& relation) const noexcept {
-    const char* type = relation.get_value_by_key("type");
-    if (!type || strcmp(type, "route")) {
+    if (!m_shard.owns(relation)) {
         return false;
     }
-    const char* route = relation.get_value_by_key("route");
-    if (!route) {
+    if (classify_tag_value(relation.get_value_by_key("type")) != TagValue::ROUTE) {
         return false;
     }
-    if (!strcmp(route, "train") || !strcmp(route, "light_rail") || !strcmp(route, "subway")
-            || !strcmp(route, "tram") || !strcmp(route, "bus") || !strcmp(route, "ferry")
-            || !strcmp(route, "trolleybus") || !strcmp(route, "share_taxi")) {
+    switch (classify_tag_value(relation.get_value_by_key("route"))) {
+    case TagValue::TRAIN:
+    case TagValue::LIGHT_RAIL:
+    case TagValue::SUBWAY:
+    case TagValue::TRAM:
+    case TagValue::BUS:
+    case TagValue::FERRY:
+    case TagValue::TROLLEYBUS:
+    case TagValue::SHARE_TAXI:
         return is_ptv2(relation);
+    default:
+        return false;
     }
-    return false;
 }
 
 void RouteManager::complete_relation(const osmium::Relation& relation) {
@@ -37,22 +49,91 @@ void RouteManager::complete_relation(const osmium::Relation& relation) {
 
 void RouteManager::process_route(const osmium::Relation& relation) {
     std::vector<const osmium::OSMObject*> member_objects;
-    std::vector<const char*> roles;
     member_objects.reserve(relation.members().size());
-    roles.reserve(relation.members().size());
     for (const osmium::RelationMember& member : relation.members()) {
-        const osmium::OSMObject* object = this->get_member_object(member);
-        member_objects.push_back(object);
-        roles.push_back(member.role());
+        member_objects.push_back(this->get_member_object(member));
+    }
+    process_route(relation, member_objects);
+}
+
+void RouteManager::process_route(const osmium::Relation& relation, std::vector<const osmium::OSMObject*>& member_objects) {
+    if (m_region && !in_region(member_objects)) {
+        return;
+    }
+    if (m_snapshot) {
+        m_snapshot->add(relation, member_objects);
+    }
+    if (!is_ptv2(relation)) {
+        return;
+    }
+    if (m_pool) {
+        m_pool->add(relation, member_objects);
+        return;
     }
-    if (is_ptv2(relation)) {
-        RouteError validation_result = is_valid(relation, member_objects);
-        if (validation_result == RouteError::CLEAN) {
-            m_writer.write_valid_route(relation, member_objects, roles);
-            return;
+    m_statistics.add(validate_route(m_checker, m_writer, relation, member_objects));
+}
+
+/*static*/ RouteError RouteManager::validate_route(PTv2Checker& checker, RouteWriter& writer,
+        const osmium::Relation& relation, std::vector<const osmium::OSMObject*>& member_objects) {
+    RouteError validation_result = checker.check_roles_order_and_type(relation, member_objects);
+    if (checker.find_gaps(relation, member_objects) > 0) {
+        validation_result |= RouteError::UNORDERED_GAP;
+    }
+    if (validation_result == RouteError::CLEAN) {
+        std::vector<const char*> roles;
+        roles.reserve(relation.members().size());
+        for (const osmium::RelationMember& member : relation.members()) {
+            roles.push_back(member.role());
         }
-        m_writer.write_invalid_route(relation, member_objects, validation_result);
+        writer.write_valid_route(relation, member_objects, roles);
+    } else {
+        writer.write_invalid_route(relation, member_objects, validation_result);
     }
+    return validation_result;
+}
+
+const RouteStatistics& RouteManager::statistics() const noexcept {
+    return m_statistics;
+}
+
+void RouteManager::set_region(const Region* region) noexcept {
+    m_region = region;
+}
+
+void RouteManager::set_snapshot(RouteSnapshotWriter* snapshot) noexcept {
+    m_snapshot = snapshot;
+}
+
+void RouteManager::start_workers(Options& options, osmium::util::VerboseOutput& verbose_output) {
+    m_pool.reset(new RouteValidationPool(m_writer, m_way_rules, options, verbose_output));
+}
+
+void RouteManager::finish_workers() {
+    if (m_pool) {
+        m_pool->finish(m_statistics);
+        m_pool.reset();
+    }
+}
+
+bool RouteManager::in_region(const std::vector<const osmium::OSMObject*>& member_objects) const {
+    for (const osmium::OSMObject* object : member_objects) {
+        if (!object) {
+            continue;
+        }
+        if (object->type() == osmium::item_type::node
+                && m_region->contains(static_cast<const osmium::Node*>(object)->location())) {
+            return true;
+        }
+        // Ways without locations cannot be decided, therefore contains() is not used for them.
+        if (object->type() == osmium::item_type::way) {
+            for (const osmium::NodeRef& node_ref : static_cast<const osmium::Way*>(object)->nodes()) {
+                if (m_region->contains(node_ref.location())) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
 }
 
 bool RouteManager::is_ptv2(const osmium::Relation& relation) const noexcept {
@@ -63,12 +144,3 @@ bool RouteManager::is_ptv2(const osmium::Relation& relation) const noexcept {
     }
     return true;
 }
-
-RouteError RouteManager::is_valid(const osmium::Relation& relation, std::vector<const osmium::OSMObject*>& member_objects) {
-    RouteError result = RouteError::CLEAN;
-    result |= m_checker.check_roles_order_and_type(relation, member_objects);
-    if (m_checker.find_gaps(relation, member_objects) > 0) {
-        result |= RouteError::UNORDERED_GAP;
-    }
-    return result;
-}
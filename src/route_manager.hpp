@@ -8,30 +8,95 @@
 #ifndef SRC_ROUTE_COLLECTOR_HPP_
 #define SRC_ROUTE_COLLECTOR_HPP_
 
+#include <memory>
+
 #include <osmium/relations/relations_manager.hpp>
 #include "ptv2_checker.hpp"
+#include "region.hpp"
+#include "route_snapshot.hpp"
+#include "statistics.hpp"
+
+class RouteValidationPool;
 
 /**
  * The RouteManager class assembles relations and their members we are interested in.
  */
 class RouteManager : public osmium::relations::RelationsManager<RouteManager, true, true, true, false> {
     RouteWriter m_writer;
+    WayRules m_way_rules;
     PTv2Checker m_checker;
+    RouteStatistics m_statistics;
+
+    /// Only routes with at least one member inside this region are written. nullptr if all routes are written.
+    const Region* m_region = nullptr;
+
+    /// Only route relations owned by this shard are assembled.
+    Shard m_shard;
+
+    /// Routes are added to this snapshot before they are validated. nullptr if no snapshot is written.
+    RouteSnapshotWriter* m_snapshot = nullptr;
+
+    /// Routes are validated by these worker threads. nullptr if they are validated on the calling thread.
+    std::unique_ptr<RouteValidationPool> m_pool;
 
     bool is_ptv2(const osmium::Relation& relation) const noexcept;
 
-    RouteError is_valid(const osmium::Relation& relation, std::vector<const osmium::OSMObject*>& member_objects);
+    bool in_region(const std::vector<const osmium::OSMObject*>& member_objects) const;
 
 public:
     RouteManager() = delete;
 
     RouteManager(OGRWriter& ogr_writer, Options& options, osmium::util::VerboseOutput& verbose_output);
 
+    ~RouteManager();
+
+    /**
+     * Validate a route and write it and its errors.
+     *
+     * \returns validation result
+     */
+    static RouteError validate_route(PTv2Checker& checker, RouteWriter& writer, const osmium::Relation& relation,
+            std::vector<const osmium::OSMObject*>& member_objects);
+
     bool new_relation(const osmium::Relation& relation) const noexcept;
 
     void complete_relation(const osmium::Relation& relation);
 
     void process_route(const osmium::Relation& relation);
+
+    /**
+     * Validate and write a route whose members have not been collected by this class.
+     *
+     * \param relation route relation
+     * \param member_objects members of the relation in the order of the member list, nullptr for
+     *        missing members. The nodes of ways must have locations.
+     */
+    void process_route(const osmium::Relation& relation, std::vector<const osmium::OSMObject*>& member_objects);
+
+    const RouteStatistics& statistics() const noexcept;
+
+    /**
+     * Write only routes with at least one member inside the region. Routes crossing the boundary are
+     * written completely.
+     */
+    void set_region(const Region* region) noexcept;
+
+    /**
+     * Add all routes written to the output to a snapshot which can be validated again with --revalidate.
+     */
+    void set_snapshot(RouteSnapshotWriter* snapshot) noexcept;
+
+    /**
+     * Validate the routes on options.route_threads worker threads instead of the calling thread.
+     * finish_workers() has to be called after the last route.
+     */
+    void start_workers(Options& options, osmium::util::VerboseOutput& verbose_output);
+
+    /**
+     * Wait for the worker threads and write their results ordered by relation ID. Does nothing if
+     * no workers have been started.
+     */
+    void finish_workers();
 };
 
 
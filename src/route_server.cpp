@@ -0,0 +1,336 @@
+/*
+ * route_server.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <gdal_priv.h>
+#include <osmium/memory/buffer.hpp>
+
+#include "ogr_writer.hpp"
+#include "route_manager.hpp"
+#include "route_server.hpp"
+
+/// maximum size of the request line and headers
+static constexpr size_t MAX_REQUEST_SIZE = 8192;
+
+/// seconds a client may take to send its request and to receive the response
+static constexpr int CLIENT_TIMEOUT = 10;
+
+/**
+ * Write a string as JSON string literal.
+ */
+static void write_json_string(std::ostream& out, const std::string& str) {
+    out << '"';
+    for (const char c : str) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+/**
+ * Decode the percent-encoded characters of a query parameter.
+ */
+static std::string url_decode(const std::string& str) {
+    std::string result;
+    for (size_t i = 0; i < str.size(); ++i) {
+        if (str[i] == '%' && i + 2 < str.size()) {
+            result += static_cast<char>(strtol(str.substr(i + 1, 2).c_str(), nullptr, 16));
+            i += 2;
+        } else if (str[i] == '+') {
+            result += ' ';
+        } else {
+            result += str[i];
+        }
+    }
+    return result;
+}
+
+/**
+ * Is the name a file name without any directory?
+ */
+static bool plain_file_name(const std::string& name) {
+    return !name.empty() && name.find('/') == std::string::npos && name != "." && name != "..";
+}
+
+/**
+ * Write a feature as JSON object.
+ */
+static void write_feature(std::ostream& out, const char* layer_name, OGRFeature& feature) {
+    out << "{\"layer\": ";
+    write_json_string(out, layer_name);
+    out << ", \"properties\": {";
+    bool first = true;
+    for (int i = 0; i < feature.GetFieldCount(); ++i) {
+        if (!feature.IsFieldSet(i)) {
+            continue;
+        }
+        OGRFieldDefn* field = feature.GetFieldDefnRef(i);
+        out << (first ? "" : ", ");
+        first = false;
+        write_json_string(out, field->GetNameRef());
+        out << ": ";
+        const OGRFieldType type = field->GetType();
+        if (type == OFTInteger || type == OFTInteger64 || type == OFTReal) {
+            out << feature.GetFieldAsString(i);
+        } else {
+            write_json_string(out, feature.GetFieldAsString(i));
+        }
+    }
+    out << "}, \"geometry\": ";
+    OGRGeometry* geometry = feature.GetGeometryRef();
+    char* json = geometry ? geometry->exportToJson() : nullptr;
+    if (json) {
+        out << json;
+        CPLFree(json);
+    } else {
+        out << "null";
+    }
+    out << '}';
+}
+
+RouteServer::RouteServer(StateStore& store, Options& options, osmium::util::VerboseOutput& verbose_output) :
+        m_store(store),
+        m_options(options),
+        m_verbose_output(verbose_output),
+        m_locations() {
+    open_locations();
+}
+
+RouteServer::~RouteServer() {
+    close_locations();
+}
+
+void RouteServer::open_locations() {
+    m_locations_fd = ::open(m_store.locations_filename().c_str(), O_RDWR);
+    if (m_locations_fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot open " + m_store.locations_filename());
+    }
+    m_locations.reset(new RouteUpdater::locations_type{m_locations_fd});
+}
+
+void RouteServer::close_locations() {
+    m_locations.reset();
+    if (m_locations_fd >= 0) {
+        ::close(m_locations_fd);
+        m_locations_fd = -1;
+    }
+}
+
+std::string RouteServer::validate(osmium::object_id_type id) {
+    const auto start = std::chrono::steady_clock::now();
+    osmium::memory::Buffer buffer {1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    std::vector<const osmium::OSMObject*> member_objects;
+    if (!RouteUpdater::load_route(m_store, *m_locations, id, buffer, member_objects)) {
+        return "";
+    }
+    // The features are written into memory and converted to JSON afterwards.
+    Options request_options = m_options;
+    request_options.output_format = "Memory";
+    request_options.async_output = false;
+    request_options.bulk_load = false;
+    OGRWriter writer {request_options, m_verbose_output};
+    RouteManager route_manager(writer, request_options, m_verbose_output);
+    route_manager.process_route(buffer.get<osmium::Relation>(0), member_objects);
+
+    std::ostringstream out;
+    out << "{\"relation\": " << id << ", \"features\": [";
+    bool first = true;
+    for (auto& dataset : writer.datasets()) {
+        for (int l = 0; l < dataset->get().GetLayerCount(); ++l) {
+            OGRLayer* layer = dataset->get().GetLayer(l);
+            layer->ResetReading();
+            while (OGRFeature* feature = layer->GetNextFeature()) {
+                out << (first ? "\n" : ",\n");
+                first = false;
+                write_feature(out, layer->GetName(), *feature);
+                OGRFeature::DestroyFeature(feature);
+            }
+        }
+    }
+    const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    out << "\n], \"milliseconds\": " << duration.count() / 1000.0 << "}\n";
+    return out.str();
+}
+
+std::string RouteServer::update(const std::string& change_filename) {
+    RouteUpdater updater(m_store, m_options, m_verbose_output);
+    close_locations();
+    std::set<osmium::object_id_type> routes;
+    try {
+        routes = updater.apply(change_filename);
+        m_store.save();
+    } catch (...) {
+        // The output has been rolled back. Applying the change file again updates the node locations
+        // which have been written already and the routes using them.
+        m_store.discard_changes();
+        open_locations();
+        throw;
+    }
+    open_locations();
+    std::ostringstream out;
+    out << "{\"routes\": [";
+    for (auto it = routes.begin(); it != routes.end(); ++it) {
+        out << (it == routes.begin() ? "" : ", ") << *it;
+    }
+    out << "]}\n";
+    return out.str();
+}
+
+std::string RouteServer::dispatch(const std::string& method, const std::string& path, int& status) {
+    static const std::string ROUTE_PREFIX = "/route/";
+    static const std::string UPDATE_PREFIX = "/update?file=";
+    if (method == "GET" && path.compare(0, ROUTE_PREFIX.size(), ROUTE_PREFIX) == 0) {
+        char* end = nullptr;
+        const osmium::object_id_type id = strtoll(path.c_str() + ROUTE_PREFIX.size(), &end, 10);
+        if (*end == '\0') {
+            std::string body = validate(id);
+            if (!body.empty()) {
+                status = 200;
+                return body;
+            }
+        }
+    } else if (method == "POST" && path.compare(0, UPDATE_PREFIX.size(), UPDATE_PREFIX) == 0) {
+        const std::string name = url_decode(path.substr(UPDATE_PREFIX.size()));
+        if (m_options.serve_changes_directory.empty()) {
+            status = 403;
+            return "{\"error\": \"updates are disabled\"}\n";
+        }
+        // Only files in the change directory may be applied.
+        if (!plain_file_name(name)) {
+            status = 403;
+            return "{\"error\": \"file has to be a name in the change directory\"}\n";
+        }
+        try {
+            std::string body = update(m_options.serve_changes_directory + '/' + name);
+            status = 200;
+            return body;
+        } catch (const std::exception& e) {
+            std::ostringstream out;
+            out << "{\"error\": ";
+            write_json_string(out, e.what());
+            out << "}\n";
+            status = 500;
+            return out.str();
+        }
+    }
+    status = 404;
+    return "{\"error\": \"not found\"}\n";
+}
+
+void RouteServer::handle(int client) {
+    // Clients sending or receiving slowly must not block the server either.
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(CLIENT_TIMEOUT);
+    std::string request;
+    char data[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_SIZE) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return;
+        }
+        const ssize_t length = recv(client, data, sizeof(data), 0);
+        if (length < 0 && errno == EINTR) {
+            continue;
+        }
+        // Timeouts of the socket end here, too.
+        if (length <= 0) {
+            return;
+        }
+        request.append(data, static_cast<size_t>(length));
+    }
+    std::istringstream request_line {request.substr(0, request.find("\r\n"))};
+    std::string method;
+    std::string path;
+    request_line >> method >> path;
+    int status = 400;
+    std::string body;
+    try {
+        body = dispatch(method, path, status);
+    } catch (const std::exception& e) {
+        status = 500;
+        body = "{\"error\": \"internal error\"}\n";
+        m_verbose_output << "Request " << path << " failed: " << e.what() << '\n';
+    }
+    const char* reason = status == 200 ? " OK" : status == 403 ? " Forbidden" : status == 404 ? " Not Found" : " Error";
+    std::ostringstream response;
+    response << "HTTP/1.0 " << status << reason << "\r\n"
+        << "Content-Type: application/json\r\n"
+        << "Content-Length: " << body.size() << "\r\n"
+        << "Connection: close\r\n\r\n" << body;
+    const std::string buffer = response.str();
+    size_t written = 0;
+    while (written < buffer.size()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return;
+        }
+        const ssize_t length = send(client, buffer.data() + written, buffer.size() - written, MSG_NOSIGNAL);
+        if (length < 0 && errno == EINTR) {
+            continue;
+        }
+        if (length <= 0) {
+            return;
+        }
+        written += static_cast<size_t>(length);
+    }
+}
+
+void RouteServer::run(int port) {
+    const int server = socket(AF_INET, SOCK_STREAM, 0);
+    if (server < 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot create socket");
+    }
+    const int reuse = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(server, 16) != 0) {
+        const int error = errno;
+        ::close(server);
+        throw std::system_error(error, std::system_category(), "Cannot listen on port " + std::to_string(port));
+    }
+    m_verbose_output << "Listening on http://localhost:" << port << "/\n";
+    while (true) {
+        const int client = accept(server, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            const int error = errno;
+            ::close(server);
+            throw std::system_error(error, std::system_category(), "accept failed");
+        }
+        // A client which neither sends nor receives anything is disconnected after the timeout.
+        const timeval timeout {CLIENT_TIMEOUT, 0};
+        if (setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0
+                || setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0) {
+            m_verbose_output << "Cannot set the timeout of a connection, closing it\n";
+            ::close(client);
+            continue;
+        }
+        handle(client);
+        ::close(client);
+    }
+}
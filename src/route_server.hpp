@@ -0,0 +1,99 @@
+/*
+ * route_server.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_ROUTE_SERVER_HPP_
+#define SRC_ROUTE_SERVER_HPP_
+
+#include <memory>
+#include <string>
+
+#include <osmium/osm/types.hpp>
+#include <osmium/util/verbose_output.hpp>
+
+#include "options.hpp"
+#include "route_updater.hpp"
+#include "state_store.hpp"
+
+/**
+ * HTTP server answering validation requests for single routes.
+ *
+ * The routes and their members are read from a state store written with --state. The server listens
+ * on localhost only and handles one request after another. Clients which do not send their request
+ * or receive the response within CLIENT_TIMEOUT seconds are disconnected.
+ *
+ * * `GET /route/ID` validates the route relation ID and returns the features RouteWriter writes
+ *   for it as JSON.
+ * * `POST /update?file=NAME` applies the change file NAME in the change directory to the state store
+ *   and the output like --update. It is only available if a change directory has been configured.
+ */
+class RouteServer {
+
+    StateStore& m_store;
+
+    Options& m_options;
+
+    osmium::util::VerboseOutput& m_verbose_output;
+
+    int m_locations_fd = -1;
+
+    /// node locations of the store, reopened after updates because the file may grow
+    std::unique_ptr<RouteUpdater::locations_type> m_locations;
+
+    void open_locations();
+
+    void close_locations();
+
+    /**
+     * Read a request from a client and send the response.
+     */
+    void handle(int client);
+
+    /**
+     * Answer a request.
+     *
+     * \param status HTTP status code of the response
+     * \returns response body
+     */
+    std::string dispatch(const std::string& method, const std::string& path, int& status);
+
+public:
+    RouteServer() = delete;
+
+    /**
+     * \throws std::system_error if the node locations cannot be opened
+     */
+    RouteServer(StateStore& store, Options& options, osmium::util::VerboseOutput& verbose_output);
+
+    ~RouteServer();
+
+    RouteServer(const RouteServer&) = delete;
+    RouteServer& operator=(const RouteServer&) = delete;
+
+    /**
+     * Validate a route.
+     *
+     * \returns JSON object with the features written for the route, an empty string if the
+     *          route is not in the store
+     */
+    std::string validate(osmium::object_id_type id);
+
+    /**
+     * Apply a change file to the store and the output and save the store. If the update fails, the
+     * changes of the store are discarded.
+     *
+     * \returns JSON object with the IDs of the affected routes
+     */
+    std::string update(const std::string& change_filename);
+
+    /**
+     * Listen on a port of localhost and answer requests until the process is terminated.
+     *
+     * \throws std::system_error if the socket cannot be opened
+     */
+    void run(int port);
+};
+
+#endif /* SRC_ROUTE_SERVER_HPP_ */
@@ -0,0 +1,166 @@
+/*
+ * route_snapshot.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <cstring>
+#include <map>
+#include <utility>
+
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/io/any_input.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+#include "route_manager.hpp"
+#include "route_snapshot.hpp"
+
+/**
+ * Keys read by RouteManager, PTv2Checker and RouteWriter. This list has to be extended if the
+ * checks read other keys.
+ */
+static const char* SNAPSHOT_KEYS[] = {
+    "aerialway", "amenity", "bus", "ferry", "from", "highway", "junction", "name", "operator",
+    "public_transport", "public_transport:version", "railway", "ref", "route", "subway", "to", "train",
+    "tram", "trolley_wire", "trolley_wire:backward", "trolley_wire:forward", "trolleybus", "type", "via"
+};
+
+/**
+ * Copy the tags which are kept in the snapshot.
+ */
+template <typename TBuilder>
+static void add_tags(TBuilder& parent, const osmium::TagList& tags) {
+    osmium::builder::TagListBuilder builder {parent};
+    for (const osmium::Tag& tag : tags) {
+        if (RouteSnapshotWriter::keep_tag(tag)) {
+            builder.add_tag(tag);
+        }
+    }
+}
+
+RouteSnapshotWriter::RouteSnapshotWriter(const std::string& filename) :
+        m_writer(),
+        m_buffer(BUFFER_SIZE, osmium::memory::Buffer::auto_grow::yes) {
+    osmium::io::File file {filename, "pbf,locations_on_ways=true"};
+    osmium::io::Header header;
+    header.set("generator", "osmi_pubtrans3");
+    m_writer.reset(new osmium::io::Writer{file, header, osmium::io::overwrite::allow});
+}
+
+/*static*/ bool RouteSnapshotWriter::keep_key(const char* key) {
+    for (const char* snapshot_key : SNAPSHOT_KEYS) {
+        if (!strcmp(key, snapshot_key)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*static*/ bool RouteSnapshotWriter::keep_tag(const osmium::Tag& tag) {
+    return keep_key(tag.key());
+}
+
+void RouteSnapshotWriter::add(const osmium::Relation& relation, const std::vector<const osmium::OSMObject*>& member_objects) {
+    {
+        osmium::builder::RelationBuilder builder {m_buffer};
+        builder.set_id(relation.id());
+        add_tags(builder, relation.tags());
+        osmium::builder::RelationMemberListBuilder members {builder};
+        for (const osmium::RelationMember& member : relation.members()) {
+            members.add_member(member.type(), member.ref(), member.role());
+        }
+    }
+    m_buffer.commit();
+    for (const osmium::OSMObject* object : member_objects) {
+        if (!object) {
+            continue;
+        }
+        if (object->type() == osmium::item_type::node) {
+            const osmium::Node& node = *static_cast<const osmium::Node*>(object);
+            {
+                osmium::builder::NodeBuilder builder {m_buffer};
+                builder.set_id(node.id());
+                builder.set_location(node.location());
+                add_tags(builder, node.tags());
+            }
+            m_buffer.commit();
+        } else if (object->type() == osmium::item_type::way) {
+            const osmium::Way& way = *static_cast<const osmium::Way*>(object);
+            {
+                osmium::builder::WayBuilder builder {m_buffer};
+                builder.set_id(way.id());
+                add_tags(builder, way.tags());
+                osmium::builder::WayNodeListBuilder nodes {builder};
+                for (const osmium::NodeRef& node_ref : way.nodes()) {
+                    nodes.add_node_ref(node_ref);
+                }
+            }
+            m_buffer.commit();
+        }
+        // Relations as members are not checked.
+    }
+    if (m_buffer.committed() > BUFFER_SIZE) {
+        (*m_writer)(std::move(m_buffer));
+        m_buffer = osmium::memory::Buffer{BUFFER_SIZE, osmium::memory::Buffer::auto_grow::yes};
+    }
+}
+
+void RouteSnapshotWriter::close() {
+    if (m_buffer.committed() > 0) {
+        (*m_writer)(std::move(m_buffer));
+        m_buffer = osmium::memory::Buffer{BUFFER_SIZE, osmium::memory::Buffer::auto_grow::yes};
+    }
+    m_writer->close();
+}
+
+RouteSnapshotReader::RouteSnapshotReader(const std::string& filename) :
+        m_filename(filename) {
+}
+
+/*static*/ void RouteSnapshotReader::process_route(osmium::memory::Buffer& route, RouteManager& route_manager) {
+    auto it = route.select<osmium::OSMObject>().begin();
+    const osmium::Relation& relation = static_cast<const osmium::Relation&>(*it);
+    std::map<std::pair<osmium::item_type, osmium::object_id_type>, const osmium::OSMObject*> members;
+    for (++it; it != route.select<osmium::OSMObject>().end(); ++it) {
+        members.emplace(std::make_pair(it->type(), it->id()), &*it);
+    }
+    std::vector<const osmium::OSMObject*> member_objects;
+    member_objects.reserve(relation.members().size());
+    for (const osmium::RelationMember& member : relation.members()) {
+        const auto found = members.find(std::make_pair(member.type(), member.ref()));
+        member_objects.push_back(found == members.end() ? nullptr : found->second);
+    }
+    route_manager.process_route(relation, member_objects);
+}
+
+size_t RouteSnapshotReader::read(RouteManager& route_manager) {
+    size_t count = 0;
+    // The members of a route may be split across buffers of the reader. Therefore, each route is
+    // copied into its own buffer.
+    osmium::memory::Buffer route {BUFFER_SIZE, osmium::memory::Buffer::auto_grow::yes};
+    osmium::io::Reader reader {m_filename};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const osmium::OSMObject& object : buffer.select<osmium::OSMObject>()) {
+            if (object.type() == osmium::item_type::relation && route.committed() > 0) {
+                process_route(route, route_manager);
+                ++count;
+                route.clear();
+            }
+            if (object.type() != osmium::item_type::relation && route.committed() == 0) {
+                // member without relation, cannot happen in files written by RouteSnapshotWriter
+                continue;
+            }
+            route.add_item(object);
+            route.commit();
+        }
+    }
+    reader.close();
+    if (route.committed() > 0) {
+        process_route(route, route_manager);
+        ++count;
+    }
+    return count;
+}
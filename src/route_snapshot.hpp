@@ -0,0 +1,95 @@
+/*
+ * route_snapshot.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_ROUTE_SNAPSHOT_HPP_
+#define SRC_ROUTE_SNAPSHOT_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+
+class RouteManager;
+
+/**
+ * Write the routes and their members into a snapshot file.
+ *
+ * The snapshot is a PBF file with locations on ways. Each route relation is followed by its members
+ * (in the order of the member list, missing members are skipped). Members of several routes are
+ * written multiple times. Only the tags read by RouteManager, PTv2Checker and RouteWriter are kept.
+ */
+class RouteSnapshotWriter {
+
+    std::unique_ptr<osmium::io::Writer> m_writer;
+
+    osmium::memory::Buffer m_buffer;
+
+    /// flush the buffer to the writer if it is larger than this
+    static constexpr size_t BUFFER_SIZE = 1024 * 1024;
+
+public:
+    RouteSnapshotWriter() = delete;
+
+    /**
+     * \param filename name of the snapshot file, an existing file is overwritten
+     */
+    explicit RouteSnapshotWriter(const std::string& filename);
+
+    /**
+     * Are tags with this key read by the checks or written to the output?
+     */
+    static bool keep_key(const char* key);
+
+    /**
+     * Is the tag read by the checks or written to the output?
+     */
+    static bool keep_tag(const osmium::Tag& tag);
+
+    /**
+     * Add a route.
+     *
+     * \param relation route relation
+     * \param member_objects members of the relation in the order of the member list, nullptr for missing members
+     */
+    void add(const osmium::Relation& relation, const std::vector<const osmium::OSMObject*>& member_objects);
+
+    /**
+     * Write the remaining routes and close the file.
+     */
+    void close();
+};
+
+/**
+ * Read a snapshot and hand the routes to RouteManager::process_route().
+ */
+class RouteSnapshotReader {
+
+    std::string m_filename;
+
+    /**
+     * Process the route at the beginning of the buffer. The other items are its members.
+     */
+    static void process_route(osmium::memory::Buffer& route, RouteManager& route_manager);
+
+public:
+    RouteSnapshotReader() = delete;
+
+    explicit RouteSnapshotReader(const std::string& filename);
+
+    /**
+     * Validate and write all routes of the snapshot.
+     *
+     * \returns number of routes
+     */
+    size_t read(RouteManager& route_manager);
+};
+
+#endif /* SRC_ROUTE_SNAPSHOT_HPP_ */
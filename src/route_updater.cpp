@@ -0,0 +1,346 @@
+/*
+ * route_updater.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <gdal_priv.h>
+#include <osmium/io/any_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object_comparisons.hpp>
+
+#include "directory.hpp"
+#include "route_updater.hpp"
+
+/// maximum number of IDs in one attribute filter
+static constexpr size_t MAX_IDS_PER_FILTER = 500;
+
+/**
+ * Output datasets which are updated in a transaction.
+ *
+ * The transactions of all datasets which have not been committed are rolled back when the instance
+ * is destroyed, e.g. because an error occurred. The datasets are closed in any case.
+ */
+class OutputUpdateTransaction {
+
+    std::vector<GDALDataset*> m_datasets;
+
+public:
+    OutputUpdateTransaction() = default;
+
+    OutputUpdateTransaction(const OutputUpdateTransaction&) = delete;
+
+    OutputUpdateTransaction& operator=(const OutputUpdateTransaction&) = delete;
+
+    ~OutputUpdateTransaction() {
+        for (GDALDataset* dataset : m_datasets) {
+            dataset->RollbackTransaction();
+            GDALClose(dataset);
+        }
+    }
+
+    /**
+     * Start a transaction on a dataset and take the ownership of it.
+     *
+     * \throws std::runtime_error if the transaction cannot be started. The dataset is closed.
+     */
+    void add(GDALDataset* dataset) {
+        m_datasets.reserve(m_datasets.size() + 1);
+        if (dataset->StartTransaction(TRUE) != OGRERR_NONE) {
+            const std::string description = dataset->GetDescription();
+            GDALClose(dataset);
+            throw std::runtime_error{"Cannot start a transaction on output dataset " + description};
+        }
+        m_datasets.push_back(dataset);
+    }
+
+    /**
+     * Get a layer of any of the datasets.
+     *
+     * \returns nullptr if no dataset has a layer with this name
+     */
+    OGRLayer* layer(const char* name) {
+        for (GDALDataset* dataset : m_datasets) {
+            OGRLayer* layer = dataset->GetLayerByName(name);
+            if (layer) {
+                return layer;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Commit the transactions and close the datasets.
+     *
+     * \throws std::runtime_error if a transaction cannot be committed. The transactions of the
+     *         remaining datasets are rolled back.
+     */
+    void commit() {
+        while (!m_datasets.empty()) {
+            GDALDataset* dataset = m_datasets.back();
+            if (dataset->CommitTransaction() != OGRERR_NONE) {
+                throw std::runtime_error{std::string{"Committing the update of output dataset "}
+                    + dataset->GetDescription() + " failed"};
+            }
+            m_datasets.pop_back();
+            GDALClose(dataset);
+        }
+    }
+};
+
+RouteUpdater::RouteUpdater(StateStore& store, Options& options, osmium::util::VerboseOutput& verbose_output) :
+        m_store(store),
+        m_options(options),
+        m_verbose_output(verbose_output),
+        m_changed_nodes(),
+        m_changed_ways(),
+        m_changed_relations() {
+}
+
+void RouteUpdater::apply_changes(const std::vector<const osmium::OSMObject*>& objects, const RouteManager& route_manager,
+        locations_type& locations) {
+    for (size_t i = 0; i < objects.size(); ++i) {
+        const osmium::OSMObject& object = *objects[i];
+        // Only the latest version of an object is applied.
+        if (i + 1 < objects.size() && objects[i + 1]->type() == object.type() && objects[i + 1]->id() == object.id()) {
+            continue;
+        }
+        bool keep = false;
+        switch (object.type()) {
+        case osmium::item_type::node: {
+            const osmium::Node& node = static_cast<const osmium::Node&>(object);
+            locations.set(node.positive_id(), node.visible() ? node.location() : osmium::Location{});
+            keep = node.visible() && StateStore::relevant(node);
+            m_changed_nodes.insert(node.id());
+            break;
+        }
+        case osmium::item_type::way:
+            keep = object.visible() && StateStore::relevant(static_cast<const osmium::Way&>(object));
+            m_changed_ways.insert(object.id());
+            break;
+        case osmium::item_type::relation:
+            keep = object.visible() && route_manager.new_relation(static_cast<const osmium::Relation&>(object));
+            m_changed_relations.insert(object.id());
+            break;
+        default:
+            continue;
+        }
+        if (keep) {
+            m_store.put(object);
+        } else {
+            m_store.erase(object.type(), object.id());
+        }
+    }
+}
+
+std::set<osmium::object_id_type> RouteUpdater::affected_routes() {
+    // Deleted routes are affected, too. Their features have to be removed.
+    std::set<osmium::object_id_type> result {m_changed_relations.begin(), m_changed_relations.end()};
+    for (const osmium::object_id_type id : m_changed_ways) {
+        const std::vector<osmium::object_id_type> routes = m_store.relations_of(osmium::item_type::way, id);
+        result.insert(routes.begin(), routes.end());
+    }
+    for (const osmium::object_id_type id : m_changed_nodes) {
+        const std::vector<osmium::object_id_type> routes = m_store.relations_of(osmium::item_type::node, id);
+        result.insert(routes.begin(), routes.end());
+        // A route is affected by moved nodes of its ways as well.
+        for (const osmium::object_id_type way_id : m_store.member_ways_of(id)) {
+            const std::vector<osmium::object_id_type> way_routes = m_store.relations_of(osmium::item_type::way, way_id);
+            result.insert(way_routes.begin(), way_routes.end());
+        }
+    }
+    return result;
+}
+
+/*static*/ bool RouteUpdater::load_route(const StateStore& store, const locations_type& locations, osmium::object_id_type id,
+        osmium::memory::Buffer& buffer, std::vector<const osmium::OSMObject*>& member_objects) {
+    buffer.clear();
+    member_objects.clear();
+    if (!store.get(osmium::item_type::relation, id, buffer)) {
+        return false;
+    }
+    // The references into the buffer become invalid when it grows. Therefore, offsets are kept
+    // until all members have been read.
+    std::vector<std::pair<osmium::item_type, osmium::object_id_type>> members;
+    for (const osmium::RelationMember& member : buffer.get<osmium::Relation>(0).members()) {
+        members.emplace_back(member.type(), member.ref());
+    }
+    // The relation is at offset 0, therefore 0 marks missing members.
+    std::vector<size_t> member_offsets;
+    for (const auto& member : members) {
+        const size_t offset = buffer.committed();
+        member_offsets.push_back(store.get(member.first, member.second, buffer) ? offset : 0);
+    }
+    for (const size_t offset : member_offsets) {
+        if (offset == 0) {
+            member_objects.push_back(nullptr);
+            continue;
+        }
+        osmium::OSMObject& object = buffer.get<osmium::OSMObject>(offset);
+        if (object.type() == osmium::item_type::way) {
+            for (osmium::NodeRef& node_ref : static_cast<osmium::Way&>(object).nodes()) {
+                node_ref.set_location(locations.get_noexcept(node_ref.positive_ref()));
+            }
+        }
+        member_objects.push_back(&object);
+    }
+    return true;
+}
+
+void RouteUpdater::write_routes(const std::set<osmium::object_id_type>& routes, RouteManager& route_manager,
+        const locations_type& locations) {
+    osmium::memory::Buffer buffer {1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    std::vector<const osmium::OSMObject*> member_objects;
+    for (const osmium::object_id_type id : routes) {
+        if (load_route(m_store, locations, id, buffer, member_objects)) {
+            route_manager.process_route(buffer.get<osmium::Relation>(0), member_objects);
+        }
+    }
+}
+
+void RouteUpdater::update_output(OGRWriter& delta, const std::set<osmium::object_id_type>& routes) {
+    std::vector<std::string> layer_names;
+    for (auto& delta_dataset : delta.datasets()) {
+        for (int l = 0; l < delta_dataset->get().GetLayerCount(); ++l) {
+            layer_names.push_back(delta_dataset->get().GetLayer(l)->GetName());
+        }
+    }
+    OutputUpdateTransaction outputs;
+    for (const std::string& name : directory_entries(m_options.output_directory)) {
+        const std::string path = m_options.output_directory + '/' + name;
+        // Files which are no datasets (e.g. statistics) are skipped.
+        GDALDataset* dataset = static_cast<GDALDataset*>(GDALOpenEx(path.c_str(),
+                GDAL_OF_VECTOR | GDAL_OF_UPDATE, nullptr, nullptr, nullptr));
+        if (!dataset) {
+            continue;
+        }
+        const bool updated = std::any_of(layer_names.begin(), layer_names.end(), [dataset](const std::string& layer_name) {
+            return dataset->GetLayerByName(layer_name.c_str()) != nullptr;
+        });
+        if (updated) {
+            outputs.add(dataset);
+        } else {
+            GDALClose(dataset);
+        }
+    }
+    for (auto& delta_dataset : delta.datasets()) {
+        for (int l = 0; l < delta_dataset->get().GetLayerCount(); ++l) {
+            OGRLayer* source = delta_dataset->get().GetLayer(l);
+            OGRLayer* destination = outputs.layer(source->GetName());
+            if (!destination) {
+                throw std::runtime_error{std::string{"Layer "} + source->GetName() + " not found in the output"};
+            }
+            const std::string error_prefix = std::string{"Updating layer "} + destination->GetName() + " failed: ";
+            // The first field contains the ID of the relation.
+            const std::string id_field = destination->GetLayerDefn()->GetFieldDefn(0)->GetNameRef();
+            std::vector<GIntBig> fids;
+            auto it = routes.begin();
+            while (it != routes.end()) {
+                std::string filter = id_field + " IN (";
+                for (size_t n = 0; n < MAX_IDS_PER_FILTER && it != routes.end(); ++n, ++it) {
+                    filter += (n ? ",'" : "'") + std::to_string(*it) + "'";
+                }
+                filter += ')';
+                if (destination->SetAttributeFilter(filter.c_str()) != OGRERR_NONE) {
+                    throw std::runtime_error{error_prefix + "invalid attribute filter " + filter};
+                }
+                destination->ResetReading();
+                while (OGRFeature* feature = destination->GetNextFeature()) {
+                    fids.push_back(feature->GetFID());
+                    OGRFeature::DestroyFeature(feature);
+                }
+            }
+            if (destination->SetAttributeFilter(nullptr) != OGRERR_NONE) {
+                throw std::runtime_error{error_prefix + "cannot reset the attribute filter"};
+            }
+            for (const GIntBig fid : fids) {
+                if (destination->DeleteFeature(fid) != OGRERR_NONE) {
+                    throw std::runtime_error{error_prefix + "cannot delete feature " + std::to_string(fid)};
+                }
+            }
+            source->ResetReading();
+            while (OGRFeature* feature = source->GetNextFeature()) {
+                OGRFeature* copy = OGRFeature::CreateFeature(destination->GetLayerDefn());
+                copy->SetFrom(feature);
+                copy->SetFID(OGRNullFID);
+                const OGRErr result = destination->CreateFeature(copy);
+                OGRFeature::DestroyFeature(copy);
+                OGRFeature::DestroyFeature(feature);
+                if (result != OGRERR_NONE) {
+                    throw std::runtime_error{error_prefix + "cannot write feature"};
+                }
+            }
+        }
+    }
+    outputs.commit();
+}
+
+std::set<osmium::object_id_type> RouteUpdater::apply_to_store(const std::string& change_filename,
+        const RouteManager& route_manager) {
+    m_verbose_output << "Reading change file " << change_filename << " ...";
+    osmium::memory::Buffer changes {1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::io::Reader reader {change_filename};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        changes.add_buffer(buffer);
+        changes.commit();
+    }
+    reader.close();
+    std::vector<const osmium::OSMObject*> objects;
+    for (const osmium::OSMObject& object : changes.select<osmium::OSMObject>()) {
+        objects.push_back(&object);
+    }
+    std::sort(objects.begin(), objects.end(), osmium::object_order_type_id_version{});
+    m_verbose_output << " done\n";
+
+    const int locations_fd = ::open(m_store.locations_filename().c_str(), O_RDWR);
+    if (locations_fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot open " + m_store.locations_filename());
+    }
+    {
+        locations_type locations {locations_fd};
+        apply_changes(objects, route_manager, locations);
+    }
+    ::close(locations_fd);
+    std::set<osmium::object_id_type> routes = affected_routes();
+    m_changed_nodes.clear();
+    m_changed_ways.clear();
+    m_changed_relations.clear();
+    return routes;
+}
+
+std::set<osmium::object_id_type> RouteUpdater::apply(const std::string& change_filename) {
+    // The new features of the routes are written into memory first.
+    Options delta_options = m_options;
+    delta_options.output_format = "Memory";
+    delta_options.async_output = false;
+    delta_options.bulk_load = false;
+    OGRWriter delta {delta_options, m_verbose_output};
+    RouteManager route_manager(delta, delta_options, m_verbose_output);
+
+    const std::set<osmium::object_id_type> routes = apply_to_store(change_filename, route_manager);
+    const int locations_fd = ::open(m_store.locations_filename().c_str(), O_RDWR);
+    if (locations_fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot open " + m_store.locations_filename());
+    }
+    {
+        locations_type locations {locations_fd};
+        m_verbose_output << "Validating " << routes.size() << " changed routes ...";
+        write_routes(routes, route_manager, locations);
+        m_verbose_output << " done\n";
+    }
+    ::close(locations_fd);
+
+    m_verbose_output << "Updating output in " << m_options.output_directory << " ...";
+    update_output(delta, routes);
+    m_verbose_output << " done\n";
+    return routes;
+}
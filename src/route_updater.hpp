@@ -0,0 +1,111 @@
+/*
+ * route_updater.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_ROUTE_UPDATER_HPP_
+#define SRC_ROUTE_UPDATER_HPP_
+
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <osmium/index/map/dense_file_array.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/verbose_output.hpp>
+
+#include "ogr_writer.hpp"
+#include "options.hpp"
+#include "route_manager.hpp"
+#include "state_store.hpp"
+
+/**
+ * Apply a change file (.osc) to the state store and update the route layers of an existing output.
+ *
+ * Only routes whose relation, members or nodes of member ways have changed are validated again. Their
+ * features are deleted from the output datasets and replaced by the new ones. The other layers are
+ * not updated.
+ */
+class RouteUpdater {
+
+public:
+    using locations_type = osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+private:
+    StateStore& m_store;
+
+    Options& m_options;
+
+    osmium::util::VerboseOutput& m_verbose_output;
+
+    std::unordered_set<osmium::object_id_type> m_changed_nodes;
+
+    std::unordered_set<osmium::object_id_type> m_changed_ways;
+
+    std::unordered_set<osmium::object_id_type> m_changed_relations;
+
+    /**
+     * Write the latest version of each changed object into the store and the node locations.
+     *
+     * \param objects changed objects ordered by type, ID and version
+     */
+    void apply_changes(const std::vector<const osmium::OSMObject*>& objects, const RouteManager& route_manager,
+            locations_type& locations);
+
+    /**
+     * Get the IDs of the routes which have to be written again, including deleted routes.
+     */
+    std::set<osmium::object_id_type> affected_routes();
+
+    /**
+     * Validate the routes which are still in the store and write them to the writer of the route manager.
+     */
+    void write_routes(const std::set<osmium::object_id_type>& routes, RouteManager& route_manager,
+            const locations_type& locations);
+
+    /**
+     * Replace the features of the routes in the output datasets by the features written to the delta writer.
+     *
+     * The datasets are updated in transactions. They are rolled back if any layer cannot be updated.
+     *
+     * \throws std::runtime_error if a layer cannot be updated
+     */
+    void update_output(OGRWriter& delta, const std::set<osmium::object_id_type>& routes);
+
+public:
+    RouteUpdater() = delete;
+
+    RouteUpdater(StateStore& store, Options& options, osmium::util::VerboseOutput& verbose_output);
+
+    /**
+     * Copy a route and its members from the store into a buffer and set the locations of the nodes
+     * of the member ways.
+     *
+     * \param member_objects members of the relation in the order of the member list, nullptr for
+     *        missing members. The pointers are valid until the buffer is changed.
+     * \returns false if the relation is not in the store
+     */
+    static bool load_route(const StateStore& store, const locations_type& locations, osmium::object_id_type id,
+            osmium::memory::Buffer& buffer, std::vector<const osmium::OSMObject*>& member_objects);
+
+    /**
+     * Apply a change file to the store only. The store has to be saved afterwards.
+     *
+     * \param route_manager route manager deciding which relations are stored
+     * \returns IDs of the routes which have to be written again, including deleted routes
+     */
+    std::set<osmium::object_id_type> apply_to_store(const std::string& change_filename, const RouteManager& route_manager);
+
+    /**
+     * Apply a change file to the store and the output. The store has to be saved afterwards.
+     *
+     * \returns IDs of the routes which have been written again, including deleted routes
+     */
+    std::set<osmium::object_id_type> apply(const std::string& change_filename);
+};
+
+#endif /* SRC_ROUTE_UPDATER_HPP_ */
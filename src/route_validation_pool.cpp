@@ -0,0 +1,179 @@
+/*
+ * route_validation_pool.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "route_manager.hpp"
+#include "route_validation_pool.hpp"
+
+/// maximum number of batches waiting in the queue of a worker
+static constexpr size_t MAX_WORKER_QUEUE_SIZE = 20;
+
+/// A batch is handed to a worker if it is larger than this (in bytes).
+static constexpr size_t BATCH_SIZE = 1024 * 1024;
+
+/**
+ * Copy the options but write to in-memory datasets. Writing to memory is fast, therefore no output
+ * thread is used.
+ */
+static Options in_memory_options(const Options& options) {
+    Options result = options;
+    result.output_format = "Memory";
+    result.async_output = false;
+    result.bulk_load = false;
+    result.output_targets.clear();
+    return result;
+}
+
+/**
+ * Find the members of a route copied into a batch and validate it.
+ *
+ * \param first relation
+ * \param last end of the members of the relation
+ */
+template <typename TIterator>
+static RouteError validate_copied_route(TIterator first, TIterator last, PTv2Checker& checker, RouteWriter& writer) {
+    const osmium::Relation& relation = static_cast<const osmium::Relation&>(*first);
+    std::map<std::pair<osmium::item_type, osmium::object_id_type>, const osmium::OSMObject*> members;
+    for (++first; first != last; ++first) {
+        members.emplace(std::make_pair(first->type(), first->id()), &*first);
+    }
+    std::vector<const osmium::OSMObject*> member_objects;
+    member_objects.reserve(relation.members().size());
+    for (const osmium::RelationMember& member : relation.members()) {
+        const auto found = members.find(std::make_pair(member.type(), member.ref()));
+        member_objects.push_back(found == members.end() ? nullptr : found->second);
+    }
+    return RouteManager::validate_route(checker, writer, relation, member_objects);
+}
+
+RouteValidationWorker::RouteValidationWorker(const Options& main_options, osmium::util::VerboseOutput& verbose_output,
+        const WayRules& way_rules) :
+        options(in_memory_options(main_options)),
+        writer(options, verbose_output),
+        route_writer(writer, options, verbose_output),
+        checker(route_writer, way_rules),
+        statistics(),
+        queue(MAX_WORKER_QUEUE_SIZE, "route_validation_worker"),
+        error(),
+        thread() {
+    // The verbose output and STDERR are written by the main thread after the worker has finished.
+    route_writer.buffer_messages();
+}
+
+void RouteValidationWorker::run() {
+    while (true) {
+        osmium::memory::Buffer batch;
+        queue.wait_and_pop(batch);
+        if (!batch) {
+            return;
+        }
+        // After an error, the remaining batches are dropped to let the reading thread continue.
+        if (error) {
+            continue;
+        }
+        try {
+            validate(batch);
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+}
+
+void RouteValidationWorker::validate(const osmium::memory::Buffer& batch) {
+    auto objects = batch.select<osmium::OSMObject>();
+    auto route_begin = objects.begin();
+    for (auto it = objects.begin(); it != objects.end(); ++it) {
+        if (it->type() == osmium::item_type::relation && it != route_begin) {
+            statistics.add(validate_copied_route(route_begin, it, checker, route_writer));
+            route_begin = it;
+        }
+    }
+    if (route_begin != objects.end()) {
+        statistics.add(validate_copied_route(route_begin, objects.end(), checker, route_writer));
+    }
+}
+
+RouteValidationPool::RouteValidationPool(RouteWriter& main_writer, const WayRules& way_rules, Options& options,
+        osmium::util::VerboseOutput& verbose_output) :
+        m_main_writer(main_writer),
+        m_workers(),
+        m_batch(BATCH_SIZE * 2, osmium::memory::Buffer::auto_grow::yes) {
+    for (int i = 0; i < options.route_threads; ++i) {
+        m_workers.emplace_back(new RouteValidationWorker(options, verbose_output, way_rules));
+    }
+    for (auto& worker : m_workers) {
+        worker->thread = std::thread(&RouteValidationWorker::run, worker.get());
+    }
+}
+
+RouteValidationPool::~RouteValidationPool() {
+    stop_workers();
+}
+
+void RouteValidationPool::add(const osmium::Relation& relation, const std::vector<const osmium::OSMObject*>& member_objects) {
+    m_batch.add_item(relation);
+    m_batch.commit();
+    // Members used multiple times by the route are copied once.
+    std::vector<const osmium::OSMObject*> objects;
+    objects.reserve(member_objects.size());
+    for (const osmium::OSMObject* object : member_objects) {
+        // Relations as members are not checked.
+        if (object && object->type() != osmium::item_type::relation) {
+            objects.push_back(object);
+        }
+    }
+    std::sort(objects.begin(), objects.end());
+    objects.erase(std::unique(objects.begin(), objects.end()), objects.end());
+    for (const osmium::OSMObject* object : objects) {
+        m_batch.add_item(*object);
+        m_batch.commit();
+    }
+    if (m_batch.committed() > BATCH_SIZE) {
+        push_batch();
+    }
+}
+
+void RouteValidationPool::push_batch() {
+    m_workers.at(m_next_worker)->queue.push(std::move(m_batch));
+    m_next_worker = (m_next_worker + 1) % m_workers.size();
+    m_batch = osmium::memory::Buffer{BATCH_SIZE * 2, osmium::memory::Buffer::auto_grow::yes};
+}
+
+void RouteValidationPool::stop_workers() {
+    for (auto& worker : m_workers) {
+        if (worker->thread.joinable()) {
+            worker->queue.push(osmium::memory::Buffer{});
+        }
+    }
+    for (auto& worker : m_workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+            worker->route_writer.flush_messages();
+        }
+    }
+}
+
+void RouteValidationPool::finish(RouteStatistics& statistics) {
+    if (m_batch.committed() > 0) {
+        push_batch();
+    }
+    stop_workers();
+    for (auto& worker : m_workers) {
+        if (worker->error) {
+            std::rethrow_exception(worker->error);
+        }
+    }
+    std::vector<RouteWriter*> writers;
+    for (auto& worker : m_workers) {
+        writers.push_back(&(worker->route_writer));
+        statistics.add(worker->statistics);
+    }
+    m_main_writer.merge(writers);
+    m_workers.clear();
+}
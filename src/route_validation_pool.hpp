@@ -0,0 +1,124 @@
+/*
+ * route_validation_pool.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_ROUTE_VALIDATION_POOL_HPP_
+#define SRC_ROUTE_VALIDATION_POOL_HPP_
+
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/thread/queue.hpp>
+#include <osmium/util/verbose_output.hpp>
+
+#include "ogr_writer.hpp"
+#include "options.hpp"
+#include "ptv2_checker.hpp"
+#include "route_writer.hpp"
+#include "statistics.hpp"
+#include "way_rules.hpp"
+
+/**
+ * A worker thread with its own PTv2Checker and RouteWriter writing into in-memory datasets.
+ */
+struct RouteValidationWorker {
+    Options options;
+
+    OGRWriter writer;
+
+    RouteWriter route_writer;
+
+    PTv2Checker checker;
+
+    RouteStatistics statistics;
+
+    /// Batches of routes to be validated by this worker. An invalid buffer signals the end of the input.
+    osmium::thread::Queue<osmium::memory::Buffer> queue;
+
+    /// exception thrown by the thread, rethrown by RouteValidationPool::finish()
+    std::exception_ptr error;
+
+    std::thread thread;
+
+    RouteValidationWorker(const Options& main_options, osmium::util::VerboseOutput& verbose_output,
+            const WayRules& way_rules);
+
+    void run();
+
+    /**
+     * Validate and write the routes of a batch.
+     */
+    void validate(const osmium::memory::Buffer& batch);
+};
+
+/**
+ * Validate routes on a pool of worker threads.
+ *
+ * The routes are copied together with their members into batches which are handed to the workers
+ * in turn. The members are released by the RelationsManager after a route is complete, therefore
+ * the workers cannot use them. After the last route, the features of all workers are merged into
+ * the layers of the main RouteWriter ordered by relation ID. The features of one route keep the
+ * order they were written in. Therefore, the output does not depend on the scheduling of the threads.
+ */
+class RouteValidationPool {
+    RouteWriter& m_main_writer;
+
+    std::vector<std::unique_ptr<RouteValidationWorker>> m_workers;
+
+    /// batch of routes filled by add()
+    osmium::memory::Buffer m_batch;
+
+    /// index of the worker which gets the next batch
+    size_t m_next_worker = 0;
+
+    void push_batch();
+
+    /**
+     * Signal the end of the input to the workers and wait for them.
+     */
+    void stop_workers();
+
+public:
+    RouteValidationPool() = delete;
+
+    /**
+     * \param main_writer writer whose layers receive the merged features
+     * \param way_rules rules used by the checkers of the workers, have to live as long as the pool
+     * \param options options, the number of workers is read from them
+     * \param verbose_output verbose output
+     */
+    RouteValidationPool(RouteWriter& main_writer, const WayRules& way_rules, Options& options,
+            osmium::util::VerboseOutput& verbose_output);
+
+    /**
+     * Stop the workers if finish() has not been called, e.g. because reading the input failed.
+     */
+    ~RouteValidationPool();
+
+    /**
+     * Add a route to the current batch. If the batch is full, it is handed to the next worker.
+     * This blocks if the queue of the worker is full.
+     *
+     * \param member_objects members of the relation in the order of the member list, nullptr for
+     *        missing members
+     */
+    void add(const osmium::Relation& relation, const std::vector<const osmium::OSMObject*>& member_objects);
+
+    /**
+     * Wait for all workers to finish and merge their results.
+     *
+     * \param statistics counters the validation results of the workers are added to
+     *
+     * \throws any exception thrown by a worker
+     */
+    void finish(RouteStatistics& statistics);
+};
+
+#endif /* SRC_ROUTE_VALIDATION_POOL_HPP_ */
@@ -6,7 +6,27 @@
  */
 
 #include <ogr_core.h>
+#include "route_geometry_builder.hpp"
 #include "route_writer.hpp"
+#include "tag_projection.hpp"
+
+/// keys of the route relation written to all layers, in ascending order
+static constexpr size_t RELATION_KEYS_COUNT = 7;
+static constexpr const char* RELATION_KEYS[RELATION_KEYS_COUNT] = {
+    "from", "name", "operator", "ref", "route", "to", "via"
+};
+static_assert(tag_keys_sorted(RELATION_KEYS), "RELATION_KEYS has to be sorted");
+
+/// indexes of RELATION_KEYS
+struct RelationKeys {
+    static constexpr size_t from = 0;
+    static constexpr size_t name = 1;
+    static constexpr size_t _operator = 2;
+    static constexpr size_t ref = 3;
+    static constexpr size_t route = 4;
+    static constexpr size_t to = 5;
+    static constexpr size_t via = 6;
+};
 
 /// indexes of fields – all layers
 struct FieldIndexes {
@@ -48,6 +68,19 @@ struct ErrorFieldIndexes {
     static constexpr int error = 9;
 };
 
+/*static*/ void RouteWriter::set_relation_fields(OutputFeature& feature, const osmium::Relation& relation, bool with_operator) {
+    const TagProjection<RELATION_KEYS_COUNT> tags {RELATION_KEYS, relation.tags()};
+    feature.set_field(FieldIndexes::name, tags.get(RelationKeys::name));
+    feature.set_field(FieldIndexes::ref, tags.get(RelationKeys::ref));
+    feature.set_field(FieldIndexes::from, tags.get(RelationKeys::from));
+    feature.set_field(FieldIndexes::to, tags.get(RelationKeys::to));
+    feature.set_field(FieldIndexes::via, tags.get(RelationKeys::via));
+    feature.set_field(FieldIndexes::route, tags.get(RelationKeys::route));
+    if (with_operator) {
+        feature.set_field(ValidInvalidFieldIndexes::_operator, tags.get(RelationKeys::_operator));
+    }
+}
+
 RouteWriter::RouteWriter(OGRWriter& writer, Options& options,
     osmium::util::VerboseOutput& verbose_output) :
         OGROutputBase(writer, verbose_output, options),
@@ -108,12 +141,45 @@ RouteWriter::RouteWriter(OGRWriter& writer, Options& options,
 
 
 
+void RouteWriter::message(const bool error, const char* text) {
+    if (m_buffer_messages) {
+        m_messages.emplace_back(error, text);
+    } else if (error) {
+        std::cerr << text << std::endl;
+    } else {
+        m_verbose_output << text << '\n';
+    }
+}
+
+void RouteWriter::buffer_messages() {
+    m_buffer_messages = true;
+}
+
+void RouteWriter::flush_messages() {
+    for (const auto& buffered : m_messages) {
+        if (buffered.first) {
+            std::cerr << buffered.second << std::endl;
+        } else {
+            m_verbose_output << buffered.second << '\n';
+        }
+    }
+    m_messages.clear();
+}
+
 void RouteWriter::write_valid_route(const osmium::Relation& relation, std::vector<const osmium::OSMObject*>& member_objects,
         std::vector<const char*>& roles) {
-    OGRMultiLineString* ml = new OGRMultiLineString();
-    for (size_t i = 0; i < member_objects.size(); ++i) {
+    RouteGeometryBuilder builder;
+    auto member_it = relation.members().begin();
+    for (size_t i = 0; i < member_objects.size(); ++i, ++member_it) {
         const osmium::OSMObject* member = member_objects.at(i);
-        if (!member || member->type() != osmium::item_type::way) {
+        if (!member) {
+            // A missing way interrupts the route.
+            if (member_it->type() == osmium::item_type::way) {
+                builder.add_gap();
+            }
+            continue;
+        }
+        if (member->type() != osmium::item_type::way) {
             continue;
         }
         const char* role = roles.at(i);
@@ -121,28 +187,30 @@ void RouteWriter::write_valid_route(const osmium::Relation& relation, std::vecto
             continue;
         }
         const osmium::Way* way = static_cast<const osmium::Way*>(member);
-        if (!coordinates_valid(way->nodes())) {
+        if (way->nodes().size() < 2 || !coordinates_valid(way->nodes())) {
+            builder.add_gap();
             continue;
         }
+        builder.add_way(*way, role);
+    }
+    OGRMultiLineString* ml = new OGRMultiLineString();
+    for (const RouteGeometryBuilder::section_type& section : builder.finish()) {
         try {
-            std::unique_ptr<OGRLineString> geom = m_factory.create_linestring(*way);
-            ml->addGeometry(geom.get());
+            m_factory.linestring_start();
+            const size_t count = m_factory.fill_linestring_unique(section.begin(), section.end());
+            if (count >= 2) {
+                ml->addGeometry(m_factory.linestring_finish(count).get());
+            }
         }
         catch (osmium::geometry_error& e) {
-            m_verbose_output << e.what() << '\n';
+            message(false, e.what());
         }
     }
-    gdalcpp::Feature feature(m_ptv2_routes_valid, std::unique_ptr<OGRGeometry> (ml));
-    static char idbuffer[20];
+    OutputFeature feature(m_writer, m_ptv2_routes_valid, std::unique_ptr<OGRGeometry> (ml));
+    char idbuffer[20];
     sprintf(idbuffer, "%ld", relation.id());
     feature.set_field(FieldIndexes::rel_id, idbuffer);
-    feature.set_field(FieldIndexes::name, relation.get_value_by_key("name"));
-    feature.set_field(FieldIndexes::ref, relation.get_value_by_key("ref"));
-    feature.set_field(FieldIndexes::from, relation.get_value_by_key("from"));
-    feature.set_field(FieldIndexes::to, relation.get_value_by_key("to"));
-    feature.set_field(FieldIndexes::via, relation.get_value_by_key("via"));
-    feature.set_field(FieldIndexes::route, relation.get_value_by_key("route"));
-    feature.set_field(ValidInvalidFieldIndexes::_operator, relation.get_value_by_key("operator"));
+    set_relation_fields(feature, relation, true);
     feature.add_to_layer();
 }
 
@@ -165,20 +233,14 @@ void RouteWriter::write_invalid_route(const osmium::Relation& relation, std::vec
             ml->addGeometry(geom.get());
         }
         catch (osmium::geometry_error& e) {
-            std::cerr << e.what() << std::endl;
+            message(true, e.what());
         }
     }
-    gdalcpp::Feature feature(m_ptv2_routes_invalid, std::unique_ptr<OGRGeometry>(ml));
-    static char idbuffer[20];
+    OutputFeature feature(m_writer, m_ptv2_routes_invalid, std::unique_ptr<OGRGeometry>(ml));
+    char idbuffer[20];
     sprintf(idbuffer, "%ld", relation.id());
     feature.set_field(FieldIndexes::rel_id, idbuffer);
-    feature.set_field(FieldIndexes::name, relation.get_value_by_key("name"));
-    feature.set_field(FieldIndexes::ref, relation.get_value_by_key("ref"));
-    feature.set_field(FieldIndexes::from, relation.get_value_by_key("from"));
-    feature.set_field(FieldIndexes::to, relation.get_value_by_key("to"));
-    feature.set_field(FieldIndexes::via, relation.get_value_by_key("via"));
-    feature.set_field(FieldIndexes::route, relation.get_value_by_key("route"));
-    feature.set_field(ValidInvalidFieldIndexes::_operator, relation.get_value_by_key("operator"));
+    set_relation_fields(feature, relation, true);
     if ((validation_result & RouteError::OVER_NON_RAIL) == RouteError::OVER_NON_RAIL) {
         feature.set_field(InvalidFieldIndexes::error_over_non_rail, "T");
     }
@@ -231,27 +293,21 @@ void RouteWriter::write_error_way(const osmium::Relation& relation, const osmium
         return;
     }
     try {
-        gdalcpp::Feature feature(m_ptv2_error_lines, m_factory.create_linestring(*way));
-        static char way_idbuffer[20];
+        OutputFeature feature(m_writer, m_ptv2_error_lines, m_factory.create_linestring(*way));
+        char way_idbuffer[20];
         sprintf(way_idbuffer, "%ld", way->id());
         feature.set_field(ErrorFieldIndexes::way_id, way_idbuffer);
-        static char node_idbuffer[20];
+        char node_idbuffer[20];
         sprintf(node_idbuffer, "%ld", node_ref);
         feature.set_field(ErrorFieldIndexes::node_id, node_idbuffer);
-        static char rel_idbuffer[20];
+        char rel_idbuffer[20];
         sprintf(rel_idbuffer, "%ld", relation.id());
         feature.set_field(FieldIndexes::rel_id, rel_idbuffer);
-        feature.set_field(FieldIndexes::name, relation.get_value_by_key("name"));
-        feature.set_field(FieldIndexes::ref, relation.get_value_by_key("ref"));
-        feature.set_field(FieldIndexes::from, relation.get_value_by_key("from"));
-        feature.set_field(FieldIndexes::to, relation.get_value_by_key("to"));
-        feature.set_field(FieldIndexes::via, relation.get_value_by_key("via"));
-        feature.set_field(FieldIndexes::route, relation.get_value_by_key("route"));
-        feature.set_field(FieldIndexes::name, relation.get_value_by_key("name"));
+        set_relation_fields(feature, relation, false);
         feature.set_field(ErrorFieldIndexes::error, error_text);
         feature.add_to_layer();
     } catch (osmium::geometry_error& err) {
-        m_verbose_output << err.what() << '\n';
+        message(false, err.what());
     }
 }
 #endif
@@ -270,23 +326,17 @@ void RouteWriter::write_error_point(const osmium::Relation& relation, const osmi
     if (!coordinates_valid(location)) {
         return;
     }
-    gdalcpp::Feature feature(m_ptv2_error_points, m_factory.create_point(location));
-    static char way_idbuffer[20];
+    OutputFeature feature(m_writer, m_ptv2_error_points, m_factory.create_point(location));
+    char way_idbuffer[20];
     sprintf(way_idbuffer, "%ld", way_id);
     feature.set_field(ErrorFieldIndexes::way_id, way_idbuffer);
-    static char node_idbuffer[20];
+    char node_idbuffer[20];
     sprintf(node_idbuffer, "%ld", node_ref);
     feature.set_field(ErrorFieldIndexes::node_id, node_idbuffer);
-    static char rel_idbuffer[20];
+    char rel_idbuffer[20];
     sprintf(rel_idbuffer, "%ld", relation.id());
     feature.set_field(FieldIndexes::rel_id, rel_idbuffer);
-    feature.set_field(FieldIndexes::name, relation.get_value_by_key("name"));
-    feature.set_field(FieldIndexes::ref, relation.get_value_by_key("ref"));
-    feature.set_field(FieldIndexes::from, relation.get_value_by_key("from"));
-    feature.set_field(FieldIndexes::to, relation.get_value_by_key("to"));
-    feature.set_field(FieldIndexes::via, relation.get_value_by_key("via"));
-    feature.set_field(FieldIndexes::route, relation.get_value_by_key("route"));
-    feature.set_field(FieldIndexes::name, relation.get_value_by_key("name"));
+    set_relation_fields(feature, relation, false);
     feature.set_field(ErrorFieldIndexes::error, error_text);
     feature.add_to_layer();
 }
@@ -312,3 +362,20 @@ void RouteWriter::write_error_object(const osmium::Relation& relation, const osm
         break;
     }
 }
+
+void RouteWriter::merge(std::vector<RouteWriter*>& others) {
+    // The destination layers must not be written by the output thread at the same time.
+    writer().flush();
+    merge_layer(&RouteWriter::m_ptv2_routes_valid, others);
+    merge_layer(&RouteWriter::m_ptv2_routes_invalid, others);
+    merge_layer(&RouteWriter::m_ptv2_error_lines, others);
+    merge_layer(&RouteWriter::m_ptv2_error_points, others);
+}
+
+void RouteWriter::merge_layer(gdalcpp::Layer RouteWriter::* layer, std::vector<RouteWriter*>& others) {
+    std::vector<OGRLayer*> sources;
+    for (RouteWriter* other : others) {
+        sources.push_back(&(other->*layer).get());
+    }
+    OGRWriter::merge_layers_by_id(this->*layer, sources);
+}
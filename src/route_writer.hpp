@@ -8,6 +8,10 @@
 #ifndef SRC_ROUTE_WRITER_HPP_
 #define SRC_ROUTE_WRITER_HPP_
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include <osmium/osm/relation.hpp>
 
 #include "ogr_output_base.hpp"
@@ -83,6 +87,26 @@ class RouteWriter : public OGROutputBase {
     gdalcpp::Layer m_ptv2_error_lines;
     gdalcpp::Layer m_ptv2_error_points;
 
+    /**
+     * Set the fields taken from the tags of the route relation.
+     *
+     * \param with_operator set the operator field (only the route layers have it)
+     */
+    static void set_relation_fields(OutputFeature& feature, const osmium::Relation& relation, bool with_operator);
+
+    void merge_layer(gdalcpp::Layer RouteWriter::* layer, std::vector<RouteWriter*>& others);
+
+    /// Keep the messages in m_messages instead of writing them, see buffer_messages().
+    bool m_buffer_messages = false;
+
+    /// buffered messages, the flag is true for errors and false for messages shown in verbose mode only
+    std::vector<std::pair<bool, std::string>> m_messages;
+
+    /**
+     * Write a message to STDERR if it is an error or to the verbose output otherwise.
+     */
+    void message(const bool error, const char* text);
+
 public:
     RouteWriter() = delete;
 
@@ -105,6 +129,28 @@ public:
 
     void write_error_object(const osmium::Relation& relation, const osmium::OSMObject* object, const osmium::object_id_type node_id,
             const char* error_text);
+
+    /**
+     * Keep all messages until flush_messages() is called. Writers running on another thread than
+     * the one owning the verbose output must not write to it or to STDERR directly.
+     */
+    void buffer_messages();
+
+    /**
+     * Write the buffered messages. Call it on the thread owning the verbose output.
+     */
+    void flush_messages();
+
+    /**
+     * Copy the features written by other instances of this class into the layers of this writer.
+     *
+     * The other writers must have been constructed with the same options and write to datasets
+     * supporting random access (e.g. the Memory driver). The features of each layer are ordered by
+     * the ID of the relation.
+     *
+     * \param others writers to read the features from
+     */
+    void merge(std::vector<RouteWriter*>& others);
 };
 
 
@@ -0,0 +1,125 @@
+/*
+ * shard.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gdal_priv.h>
+
+#include "directory.hpp"
+#include "ogr_writer.hpp"
+#include "shard.hpp"
+#include "statistics.hpp"
+
+ShardRunner::ShardRunner(Options& options, osmium::util::VerboseOutput& verbose_output) :
+        m_options(options),
+        m_verbose_output(verbose_output),
+        m_directories() {
+    for (int i = 0; i < m_options.shards; ++i) {
+        m_directories.push_back(m_options.output_directory + "/.shard_" + std::to_string(i));
+    }
+}
+
+Options ShardRunner::shard_options(int index) const {
+    Options result = m_options;
+    result.shard_index = index;
+    result.output_directory = m_directories.at(index);
+    // The datasets of the workers are read again by the merge step only.
+    result.bulk_load = false;
+    result.verbose = false;
+    if (!result.stats_file.empty()) {
+        // hidden file, not opened as dataset by merge()
+        result.stats_file = m_directories.at(index) + "/.statistics";
+    }
+    return result;
+}
+
+bool ShardRunner::run(const std::function<void(Options&)>& convert) {
+    std::vector<pid_t> workers;
+    for (int i = 0; i < m_options.shards; ++i) {
+        if (mkdir(m_directories.at(i).c_str(), 0755) != 0 && errno != EEXIST) {
+            std::cerr << "ERROR: Cannot create directory " << m_directories.at(i) << ": " << strerror(errno) << '\n';
+            return false;
+        }
+    }
+    m_verbose_output << "Starting " << m_options.shards << " worker processes ...";
+    // Flush everything buffered before forking, it would be written by every worker otherwise.
+    std::cout.flush();
+    std::cerr.flush();
+    for (int i = 0; i < m_options.shards; ++i) {
+        const pid_t pid = fork();
+        if (pid == -1) {
+            std::cerr << "ERROR: Cannot start worker process: " << strerror(errno) << '\n';
+            break;
+        }
+        if (pid == 0) {
+            int exit_code = 0;
+            try {
+                Options options = shard_options(i);
+                convert(options);
+            } catch (std::exception& err) {
+                std::cerr << "ERROR in shard " << i << ": " << err.what() << '\n';
+                exit_code = 1;
+            }
+            std::cout.flush();
+            std::cerr.flush();
+            _exit(exit_code);
+        }
+        workers.push_back(pid);
+    }
+    bool success = workers.size() == static_cast<size_t>(m_options.shards);
+    for (const pid_t pid : workers) {
+        int status = 0;
+        if (waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            success = false;
+        }
+    }
+    m_verbose_output << (success ? " done\n" : " failed\n");
+    return success;
+}
+
+void ShardRunner::merge() {
+    m_verbose_output << "Merging the output of the shards ...";
+    Statistics statistics;
+    if (!m_options.stats_file.empty()) {
+        for (const std::string& directory : m_directories) {
+            statistics.add_saved(directory + "/.statistics");
+        }
+        statistics.start_pass("merge");
+    }
+    std::vector<std::vector<GDALDataset*>> datasets;
+    for (const std::string& directory : m_directories) {
+        datasets.push_back(OGRWriter::open_datasets(directory));
+    }
+    {
+        // All workers create the same layers in the same order.
+        OGRWriter writer {m_options, m_verbose_output};
+        writer.merge_datasets(datasets);
+        if (!m_options.stats_file.empty()) {
+            statistics.set_layer_features(writer.feature_counts());
+        }
+        writer.rename_output_files("pubtrans");
+    }
+    for (auto& shard_datasets : datasets) {
+        for (GDALDataset* dataset : shard_datasets) {
+            GDALClose(dataset);
+        }
+    }
+    for (const std::string& directory : m_directories) {
+        remove_directory(directory);
+    }
+    if (!m_options.stats_file.empty()) {
+        statistics.end_pass();
+        statistics.write(m_options.stats_file);
+    }
+    m_verbose_output << " done\n";
+}
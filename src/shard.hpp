@@ -0,0 +1,90 @@
+/*
+ * shard.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_SHARD_HPP_
+#define SRC_SHARD_HPP_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <osmium/osm/object.hpp>
+#include <osmium/util/verbose_output.hpp>
+
+#include "options.hpp"
+
+/**
+ * The part of the objects a worker process is responsible for in sharded mode.
+ *
+ * Objects are assigned by their ID. A route relation is owned by exactly one shard. Its members are
+ * read by this shard from the complete input. Therefore, routes crossing the boundaries of shards are
+ * assembled in one place.
+ */
+class Shard {
+
+    unsigned int m_count = 1;
+
+    unsigned int m_index = 0;
+
+public:
+    /// a shard owning all objects
+    Shard() = default;
+
+    explicit Shard(const Options& options) noexcept :
+        m_count(static_cast<unsigned int>(options.shards)),
+        m_index(static_cast<unsigned int>(options.shard_index)) {}
+
+    bool owns(const osmium::OSMObject& object) const noexcept {
+        return m_count <= 1 || object.positive_id() % m_count == m_index;
+    }
+};
+
+/**
+ * Run the conversion in one worker process per shard and merge their output.
+ *
+ * Each worker writes into its own subdirectory of the output directory. After all workers have
+ * succeeded, the layers of the workers are merged into the output datasets ordered by the OSM ID
+ * (first field) and the subdirectories are removed. The features are the same as in an unsharded
+ * run but their order differs because an unsharded run writes the routes in the order they are completed.
+ */
+class ShardRunner {
+
+    Options& m_options;
+
+    osmium::util::VerboseOutput& m_verbose_output;
+
+    /// output directories of the workers
+    std::vector<std::string> m_directories;
+
+    /**
+     * Options of a worker.
+     */
+    Options shard_options(int index) const;
+
+public:
+    ShardRunner() = delete;
+
+    ShardRunner(Options& options, osmium::util::VerboseOutput& verbose_output);
+
+    /**
+     * Fork the worker processes and wait for them.
+     *
+     * \param convert function doing the conversion, called in each worker with its options
+     *
+     * \returns true if all workers succeeded
+     */
+    bool run(const std::function<void(Options&)>& convert);
+
+    /**
+     * Merge the layers of the workers into the output datasets. If statistics were requested, the
+     * statistics of the workers are added up and written together with the timing of the merge.
+     *
+     * \throws std::runtime_error if the output of a worker cannot be read
+     */
+    void merge();
+};
+
+#endif /* SRC_SHARD_HPP_ */
@@ -0,0 +1,493 @@
+/*
+ * state_store.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <osmium/memory/item.hpp>
+
+#include "route_manager.hpp"
+#include "state_store.hpp"
+
+/// magic bytes at the beginning of an index file, the last character is the version of the format
+static constexpr const char* STATE_INDEX_MAGIC = "OSMISTX1";
+
+/// magic bytes at the beginning of a links file, the last character is the version of the format
+static constexpr const char* STATE_LINKS_MAGIC = "OSMISTL1";
+
+/**
+ * Write exactly size bytes at an offset.
+ */
+static void write_exactly(const int fd, const char* data, const size_t size, uint64_t offset, const std::string& filename) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t result = ::pwrite(fd, data + done, size - done, static_cast<off_t>(offset + done));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0) {
+            throw std::system_error(errno, std::system_category(), "Writing " + filename + " failed");
+        }
+        done += static_cast<size_t>(result);
+    }
+}
+
+/**
+ * Read exactly size bytes at an offset.
+ */
+static void read_exactly(const int fd, char* data, const size_t size, uint64_t offset, const std::string& filename) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t result = ::pread(fd, data + done, size - done, static_cast<off_t>(offset + done));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            throw std::system_error(result < 0 ? errno : EIO, std::system_category(), "Reading " + filename + " failed");
+        }
+        done += static_cast<size_t>(result);
+    }
+}
+
+/**
+ * Read a file consisting of magic bytes followed by an array of entries.
+ *
+ * \returns false if the file does not exist
+ */
+template <typename TEntry>
+static bool read_array_file(const std::string& filename, const char* magic, std::vector<TEntry>& entries) {
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0 && errno == ENOENT) {
+        return false;
+    }
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot open " + filename);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::system_error(errno, std::system_category(), "Cannot stat " + filename);
+    }
+    const size_t magic_length = strlen(magic);
+    const size_t file_size = static_cast<size_t>(st.st_size);
+    if (file_size < magic_length || (file_size - magic_length) % sizeof(TEntry) != 0) {
+        ::close(fd);
+        throw std::runtime_error{"State store: invalid index " + filename};
+    }
+    std::string file_magic(magic_length, '\0');
+    entries.resize((file_size - magic_length) / sizeof(TEntry));
+    try {
+        read_exactly(fd, &file_magic[0], magic_length, 0, filename);
+        read_exactly(fd, reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(TEntry), magic_length, filename);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    if (file_magic != magic) {
+        throw std::runtime_error{"State store: invalid index " + filename};
+    }
+    return true;
+}
+
+/**
+ * Replace a file consisting of magic bytes followed by an array of entries atomically. A crash
+ * leaves the previous version intact.
+ */
+template <typename TEntry>
+static void write_array_file(const std::string& filename, const char* magic, const std::vector<TEntry>& entries) {
+    const std::string tmp_filename = filename + ".tmp";
+    const int fd = ::open(tmp_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot open " + tmp_filename);
+    }
+    try {
+        write_exactly(fd, magic, strlen(magic), 0, tmp_filename);
+        write_exactly(fd, reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(TEntry),
+                strlen(magic), tmp_filename);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    if (::fsync(fd) != 0 || ::close(fd) != 0 || rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+        throw std::system_error(errno, std::system_category(), "Writing " + filename + " failed");
+    }
+}
+
+StateStore::StateStore(const std::string& directory, bool create) :
+        m_directory(directory),
+        m_index(),
+        m_changes(),
+        m_links(),
+        m_added_links(),
+        m_removed_links(),
+        m_create(create) {
+    if (m_create && mkdir(m_directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::system_error(errno, std::system_category(), "Cannot create " + m_directory);
+    }
+    const std::string data_filename = m_directory + "/objects.bin";
+    m_data_fd = ::open(data_filename.c_str(), m_create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+    if (m_data_fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot open " + data_filename);
+    }
+    if (m_create) {
+        return;
+    }
+    struct stat st;
+    if (::fstat(m_data_fd, &st) != 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot stat " + data_filename);
+    }
+    m_data_size = static_cast<uint64_t>(st.st_size);
+    if (!read_array_file(index_filename(), STATE_INDEX_MAGIC, m_index)) {
+        throw std::system_error(ENOENT, std::system_category(), "Cannot open " + index_filename());
+    }
+    // The links are missing if the store has been written by an older version or saving it has been aborted.
+    if (!read_array_file(links_filename(), STATE_LINKS_MAGIC, m_links)) {
+        rebuild_links();
+    }
+}
+
+StateStore::~StateStore() {
+    if (m_data_fd >= 0) {
+        ::close(m_data_fd);
+    }
+}
+
+/*static*/ uint64_t StateStore::key(osmium::item_type type, osmium::object_id_type id) noexcept {
+    // The type is stored in the highest two bits, there are far less than 2^62 objects of each type.
+    return (static_cast<uint64_t>(osmium::item_type_to_nwr_index(type)) << 62)
+            | static_cast<uint64_t>(id < 0 ? -id : id);
+}
+
+/*static*/ osmium::object_id_type StateStore::id_of_key(uint64_t key) noexcept {
+    return static_cast<osmium::object_id_type>(key & ((1ULL << 62) - 1));
+}
+
+uint64_t StateStore::offset(uint64_t key) const {
+    const auto change = m_changes.find(key);
+    if (change != m_changes.end()) {
+        return change->second;
+    }
+    const auto it = std::lower_bound(m_index.begin(), m_index.end(), entry{key, 0});
+    if (it == m_index.end() || it->key != key) {
+        return DELETED;
+    }
+    return it->offset;
+}
+
+std::string StateStore::index_filename() const {
+    return m_directory + "/objects.idx";
+}
+
+std::string StateStore::links_filename() const {
+    return m_directory + "/links.idx";
+}
+
+std::string StateStore::locations_filename() const {
+    return m_directory + "/locations.bin";
+}
+
+/*static*/ bool StateStore::relevant(const osmium::Node& node) {
+    // stops and platforms
+    return node.tags().has_key("public_transport") || node.tags().has_key("highway")
+            || node.tags().has_key("railway") || node.tags().has_key("amenity");
+}
+
+/*static*/ bool StateStore::relevant(const osmium::Way& way) {
+    return way.tags().has_key("highway") || way.tags().has_key("railway")
+            || way.tags().has_key("public_transport") || way.tags().has_key("route");
+}
+
+std::vector<uint64_t> StateStore::parents(uint64_t child) const {
+    std::vector<uint64_t> result;
+    const link first {child, 0};
+    for (auto it = std::lower_bound(m_links.begin(), m_links.end(), first); it != m_links.end() && it->child == child; ++it) {
+        if (!m_removed_links.count(*it)) {
+            result.push_back(it->parent);
+        }
+    }
+    for (auto it = m_added_links.lower_bound(first); it != m_added_links.end() && it->child == child; ++it) {
+        result.push_back(it->parent);
+    }
+    return result;
+}
+
+void StateStore::add_link(const link& l) {
+    if (m_removed_links.erase(l) == 0 && !std::binary_search(m_links.begin(), m_links.end(), l)) {
+        m_added_links.insert(l);
+    }
+}
+
+void StateStore::remove_link(const link& l) {
+    if (m_added_links.erase(l) == 0 && std::binary_search(m_links.begin(), m_links.end(), l)) {
+        m_removed_links.insert(l);
+    }
+}
+
+void StateStore::link_nodes(const osmium::Way& way, bool add) {
+    const uint64_t parent = key(osmium::item_type::way, way.id());
+    for (const osmium::NodeRef& node_ref : way.nodes()) {
+        const link l {key(osmium::item_type::node, node_ref.ref()), parent};
+        if (add) {
+            add_link(l);
+        } else {
+            remove_link(l);
+        }
+    }
+}
+
+void StateStore::link_members(const osmium::Relation& relation, bool add) {
+    const uint64_t parent = key(osmium::item_type::relation, relation.id());
+    osmium::memory::Buffer buffer {1024, osmium::memory::Buffer::auto_grow::yes};
+    for (const osmium::RelationMember& member : relation.members()) {
+        const link l {key(member.type(), member.ref()), parent};
+        const bool had_parents = !parents(l.child).empty();
+        if (add) {
+            add_link(l);
+        } else {
+            remove_link(l);
+        }
+        // Only the nodes of ways which are members of a relation are linked.
+        buffer.clear();
+        if (member.type() == osmium::item_type::way && had_parents == parents(l.child).empty()
+                && get(osmium::item_type::way, member.ref(), buffer)) {
+            link_nodes(buffer.get<osmium::Way>(0), add);
+        }
+    }
+}
+
+void StateStore::link_object(const osmium::OSMObject& object) {
+    if (object.type() == osmium::item_type::relation) {
+        link_members(static_cast<const osmium::Relation&>(object), true);
+    } else if (object.type() == osmium::item_type::way && !parents(key(object.type(), object.id())).empty()) {
+        link_nodes(static_cast<const osmium::Way&>(object), true);
+    }
+}
+
+void StateStore::unlink_object(osmium::item_type type, osmium::object_id_type id) {
+    if (type != osmium::item_type::relation && (type != osmium::item_type::way || parents(key(type, id)).empty())) {
+        return;
+    }
+    osmium::memory::Buffer buffer {1024, osmium::memory::Buffer::auto_grow::yes};
+    if (!get(type, id, buffer)) {
+        return;
+    }
+    if (type == osmium::item_type::relation) {
+        link_members(buffer.get<osmium::Relation>(0), false);
+    } else {
+        link_nodes(buffer.get<osmium::Way>(0), false);
+    }
+}
+
+void StateStore::rebuild_links() {
+    std::vector<link> links;
+    std::vector<osmium::object_id_type> member_ways;
+    osmium::memory::Buffer buffer {1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (const osmium::object_id_type id : relation_ids()) {
+        buffer.clear();
+        get(osmium::item_type::relation, id, buffer);
+        const uint64_t parent = key(osmium::item_type::relation, id);
+        for (const osmium::RelationMember& member : buffer.get<osmium::Relation>(0).members()) {
+            links.push_back(link{key(member.type(), member.ref()), parent});
+            if (member.type() == osmium::item_type::way) {
+                member_ways.push_back(member.ref());
+            }
+        }
+    }
+    std::sort(member_ways.begin(), member_ways.end());
+    member_ways.erase(std::unique(member_ways.begin(), member_ways.end()), member_ways.end());
+    for (const osmium::object_id_type id : member_ways) {
+        buffer.clear();
+        if (!get(osmium::item_type::way, id, buffer)) {
+            continue;
+        }
+        const uint64_t parent = key(osmium::item_type::way, id);
+        for (const osmium::NodeRef& node_ref : buffer.get<osmium::Way>(0).nodes()) {
+            links.push_back(link{key(osmium::item_type::node, node_ref.ref()), parent});
+        }
+    }
+    std::sort(links.begin(), links.end());
+    links.erase(std::unique(links.begin(), links.end(), [](const link& a, const link& b) {
+        return a.child == b.child && a.parent == b.parent;
+    }), links.end());
+    m_links.swap(links);
+    m_added_links.clear();
+    m_removed_links.clear();
+}
+
+void StateStore::put(const osmium::OSMObject& object) {
+    // The links of a new store are built by save() because its index is not sorted yet.
+    if (!m_create) {
+        unlink_object(object.type(), object.id());
+    }
+    const uint64_t offset = m_data_size;
+    write_exactly(m_data_fd, reinterpret_cast<const char*>(object.data()), object.padded_size(), offset,
+            m_directory + "/objects.bin");
+    m_data_size += object.padded_size();
+    if (m_create) {
+        m_index.push_back(entry{key(object.type(), object.id()), offset});
+    } else {
+        m_changes[key(object.type(), object.id())] = offset;
+        link_object(object);
+    }
+}
+
+void StateStore::erase(osmium::item_type type, osmium::object_id_type id) {
+    // A new store never contains an object twice, therefore it is not possible to erase from it.
+    if (!m_create) {
+        unlink_object(type, id);
+        m_changes[key(type, id)] = DELETED;
+    }
+}
+
+bool StateStore::get(osmium::item_type type, osmium::object_id_type id, osmium::memory::Buffer& buffer) const {
+    const uint64_t object_offset = offset(key(type, id));
+    if (object_offset == DELETED) {
+        return false;
+    }
+    // The size of an item is stored in its first bytes.
+    osmium::memory::item_size_type size = 0;
+    read_exactly(m_data_fd, reinterpret_cast<char*>(&size), sizeof(size), object_offset, m_directory + "/objects.bin");
+    const size_t padded_size = osmium::memory::padded_length(size);
+    unsigned char* destination = buffer.reserve_space(padded_size);
+    read_exactly(m_data_fd, reinterpret_cast<char*>(destination), padded_size, object_offset, m_directory + "/objects.bin");
+    buffer.commit();
+    return true;
+}
+
+std::vector<osmium::object_id_type> StateStore::relation_ids() const {
+    const uint64_t relation_key = key(osmium::item_type::relation, 0);
+    std::vector<osmium::object_id_type> result;
+    for (auto it = std::lower_bound(m_index.begin(), m_index.end(), entry{relation_key, 0}); it != m_index.end(); ++it) {
+        if (offset(it->key) != DELETED) {
+            result.push_back(static_cast<osmium::object_id_type>(it->key - relation_key));
+        }
+    }
+    for (auto it = m_changes.lower_bound(relation_key); it != m_changes.end(); ++it) {
+        if (it->second != DELETED && !std::binary_search(m_index.begin(), m_index.end(), entry{it->first, 0})) {
+            result.push_back(static_cast<osmium::object_id_type>(it->first - relation_key));
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::vector<osmium::object_id_type> StateStore::relations_of(osmium::item_type type, osmium::object_id_type id) const {
+    std::vector<osmium::object_id_type> result;
+    for (const uint64_t parent : parents(key(type, id))) {
+        if ((parent >> 62) == osmium::item_type_to_nwr_index(osmium::item_type::relation)) {
+            result.push_back(id_of_key(parent));
+        }
+    }
+    return result;
+}
+
+std::vector<osmium::object_id_type> StateStore::member_ways_of(osmium::object_id_type node_id) const {
+    std::vector<osmium::object_id_type> result;
+    for (const uint64_t parent : parents(key(osmium::item_type::node, node_id))) {
+        if ((parent >> 62) == osmium::item_type_to_nwr_index(osmium::item_type::way)) {
+            result.push_back(id_of_key(parent));
+        }
+    }
+    return result;
+}
+
+void StateStore::discard_changes() {
+    if (m_create) {
+        throw std::logic_error{"State store: changes of a new store cannot be discarded"};
+    }
+    m_changes.clear();
+    m_added_links.clear();
+    m_removed_links.clear();
+}
+
+void StateStore::save() {
+    if (m_create) {
+        std::sort(m_index.begin(), m_index.end());
+        rebuild_links();
+    } else {
+        // merge the changes into the index
+        std::vector<entry> index;
+        index.reserve(m_index.size() + m_changes.size());
+        auto change = m_changes.begin();
+        for (const entry& e : m_index) {
+            for (; change != m_changes.end() && change->first < e.key; ++change) {
+                if (change->second != DELETED) {
+                    index.push_back(entry{change->first, change->second});
+                }
+            }
+            if (change != m_changes.end() && change->first == e.key) {
+                if (change->second != DELETED) {
+                    index.push_back(entry{e.key, change->second});
+                }
+                ++change;
+            } else {
+                index.push_back(e);
+            }
+        }
+        for (; change != m_changes.end(); ++change) {
+            if (change->second != DELETED) {
+                index.push_back(entry{change->first, change->second});
+            }
+        }
+        m_index.swap(index);
+        m_changes.clear();
+
+        std::vector<link> kept_links;
+        kept_links.reserve(m_links.size() - m_removed_links.size());
+        std::set_difference(m_links.begin(), m_links.end(), m_removed_links.begin(), m_removed_links.end(),
+                std::back_inserter(kept_links));
+        std::vector<link> links;
+        links.reserve(kept_links.size() + m_added_links.size());
+        std::merge(kept_links.begin(), kept_links.end(), m_added_links.begin(), m_added_links.end(),
+                std::back_inserter(links));
+        m_links.swap(links);
+        m_added_links.clear();
+        m_removed_links.clear();
+    }
+    if (::fsync(m_data_fd) != 0) {
+        throw std::system_error(errno, std::system_category(), "Writing " + m_directory + "/objects.bin failed");
+    }
+    // The links are removed while the index is replaced. If the process is aborted before the links
+    // have been written again, they are rebuilt when the store is opened.
+    if (::unlink(links_filename().c_str()) != 0 && errno != ENOENT) {
+        throw std::system_error(errno, std::system_category(), "Cannot remove " + links_filename());
+    }
+    write_array_file(index_filename(), STATE_INDEX_MAGIC, m_index);
+    write_array_file(links_filename(), STATE_LINKS_MAGIC, m_links);
+}
+
+StateStoreHandler::StateStoreHandler(StateStore* store, const RouteManager& route_manager) :
+        m_store(store),
+        m_route_manager(route_manager) {
+}
+
+void StateStoreHandler::node(const osmium::Node& node) {
+    if (m_store && StateStore::relevant(node)) {
+        m_store->put(node);
+    }
+}
+
+void StateStoreHandler::way(const osmium::Way& way) {
+    if (m_store && StateStore::relevant(way)) {
+        m_store->put(way);
+    }
+}
+
+void StateStoreHandler::relation(const osmium::Relation& relation) {
+    if (m_store && m_route_manager.new_relation(relation)) {
+        m_store->put(relation);
+    }
+}
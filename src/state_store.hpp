@@ -0,0 +1,248 @@
+/*
+ * state_store.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_STATE_STORE_HPP_
+#define SRC_STATE_STORE_HPP_
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <osmium/handler.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+class RouteManager;
+
+/**
+ * Persistent store of the objects needed to revalidate routes after the input has changed.
+ *
+ * The store is a directory containing four files:
+ *
+ * * `locations.bin`: the locations of all nodes as a dense file array. It is written by the
+ *   location index of pass 2.
+ * * `objects.bin`: the PTv2 route relations, the ways and the nodes which can be members of them
+ *   (see `relevant()`). The objects are appended in the internal format of Osmium. Replaced or
+ *   deleted objects are not removed from this file.
+ * * `objects.idx`: pairs of a key (type and ID) and the offset of the current version of the object
+ *   in `objects.bin`, ordered by the key.
+ * * `links.idx`: reverse index of the relations (from their members to the relations) and of the
+ *   member ways of the relations (from their nodes to the ways). Links are pairs of keys ordered by
+ *   the key of the member. It is rebuilt from the objects if it is missing.
+ *
+ * The indexes are kept in memory and written by `save()`.
+ */
+class StateStore {
+
+    struct entry {
+        uint64_t key;
+        uint64_t offset;
+
+        bool operator<(const entry& other) const noexcept {
+            return key < other.key;
+        }
+    };
+
+    /// link from a member to a relation or from a node to a way
+    struct link {
+        uint64_t child;
+        uint64_t parent;
+
+        bool operator<(const link& other) const noexcept {
+            return child < other.child || (child == other.child && parent < other.parent);
+        }
+    };
+
+    /// offset of deleted objects in m_changes
+    static constexpr uint64_t DELETED = UINT64_MAX;
+
+    std::string m_directory;
+
+    int m_data_fd = -1;
+
+    /// size of the data file
+    uint64_t m_data_size = 0;
+
+    /// Index of the objects. It is unsorted while a new store is being created.
+    std::vector<entry> m_index;
+
+    /// objects added, replaced or deleted after the index has been loaded
+    std::map<uint64_t, uint64_t> m_changes;
+
+    /// Links of the relations and their member ways, sorted. It is empty while a new store is being created.
+    std::vector<link> m_links;
+
+    /// links added after m_links has been loaded
+    std::set<link> m_added_links;
+
+    /// links of m_links removed after it has been loaded
+    std::set<link> m_removed_links;
+
+    /// true if a new store is being created
+    bool m_create;
+
+    static uint64_t key(osmium::item_type type, osmium::object_id_type id) noexcept;
+
+    static osmium::object_id_type id_of_key(uint64_t key) noexcept;
+
+    /**
+     * Offset of an object in the data file, DELETED if it is not in the store.
+     */
+    uint64_t offset(uint64_t key) const;
+
+    std::string index_filename() const;
+
+    std::string links_filename() const;
+
+    /**
+     * Keys of the objects linked to an object.
+     */
+    std::vector<uint64_t> parents(uint64_t child) const;
+
+    void add_link(const link& l);
+
+    void remove_link(const link& l);
+
+    /**
+     * Add or remove the links from the nodes of a member way to the way.
+     */
+    void link_nodes(const osmium::Way& way, bool add);
+
+    /**
+     * Add or remove the links from the members of a relation to the relation. The links of member
+     * ways to their nodes are added or removed if the way gets its first or loses its last relation.
+     */
+    void link_members(const osmium::Relation& relation, bool add);
+
+    /**
+     * Add the links of a new version of an object.
+     */
+    void link_object(const osmium::OSMObject& object);
+
+    /**
+     * Remove the links of the stored version of an object.
+     */
+    void unlink_object(osmium::item_type type, osmium::object_id_type id);
+
+    /**
+     * Build the links of all stored relations.
+     */
+    void rebuild_links();
+
+public:
+    StateStore() = delete;
+
+    /**
+     * Open a store.
+     *
+     * \param directory directory of the store
+     * \param create create a new store in this directory (the directory is created if necessary)
+     *        instead of opening an existing one
+     *
+     * \throws std::system_error if the files cannot be opened
+     */
+    StateStore(const std::string& directory, bool create);
+
+    ~StateStore();
+
+    StateStore(const StateStore&) = delete;
+    StateStore& operator=(const StateStore&) = delete;
+
+    /**
+     * Name of the file of the node locations.
+     */
+    std::string locations_filename() const;
+
+    /**
+     * Can this node be a member of a route we are interested in?
+     */
+    static bool relevant(const osmium::Node& node);
+
+    /**
+     * Can this way be a member of a route we are interested in?
+     */
+    static bool relevant(const osmium::Way& way);
+
+    /**
+     * Add an object or replace the stored version of it.
+     */
+    void put(const osmium::OSMObject& object);
+
+    /**
+     * Remove an object. Nothing happens if it is not in the store.
+     */
+    void erase(osmium::item_type type, osmium::object_id_type id);
+
+    /**
+     * Copy an object from the store into a buffer.
+     *
+     * \returns false if the object is not in the store
+     */
+    bool get(osmium::item_type type, osmium::object_id_type id, osmium::memory::Buffer& buffer) const;
+
+    /**
+     * IDs of all stored relations in ascending order.
+     */
+    std::vector<osmium::object_id_type> relation_ids() const;
+
+    /**
+     * IDs of the stored relations which have an object as a member.
+     */
+    std::vector<osmium::object_id_type> relations_of(osmium::item_type type, osmium::object_id_type id) const;
+
+    /**
+     * IDs of the ways which contain a node and are members of stored relations.
+     */
+    std::vector<osmium::object_id_type> member_ways_of(osmium::object_id_type node_id) const;
+
+    /**
+     * Forget the objects added, replaced or deleted since the store has been opened or saved. The
+     * node locations are not restored.
+     */
+    void discard_changes();
+
+    /**
+     * Write the indexes.
+     *
+     * \throws std::system_error if writing fails
+     */
+    void save();
+};
+
+/**
+ * This handler writes the objects needed to update the routes later into a StateStore.
+ *
+ * It does nothing if no store is given.
+ */
+class StateStoreHandler : public osmium::handler::Handler {
+
+    StateStore* m_store;
+
+    const RouteManager& m_route_manager;
+
+public:
+    StateStoreHandler() = delete;
+
+    /**
+     * \param store store to write to, nullptr if nothing should be stored
+     * \param route_manager route manager deciding which relations are stored
+     */
+    StateStoreHandler(StateStore* store, const RouteManager& route_manager);
+
+    void node(const osmium::Node& node);
+
+    void way(const osmium::Way& way);
+
+    void relation(const osmium::Relation& relation);
+};
+
+#endif /* SRC_STATE_STORE_HPP_ */
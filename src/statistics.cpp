@@ -0,0 +1,250 @@
+/*
+ * statistics.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/resource.h>
+
+#include "statistics.hpp"
+
+/// names of the bits of RouteError as used in the JSON output
+static const char* ROUTE_ERROR_NAMES[RouteStatistics::ERROR_BITS] = {
+    "over_non_rail",
+    "over_non_road",
+    "no_trolley_wire",
+    "unordered_gap",
+    "wrong_structure",
+    "no_stop_platform_at_front",
+    "empty_role_non_way",
+    "stop_platform_after_route",
+    "stop_not_on_way",
+    "no_route",
+    "unknown_role",
+    "unknown_type",
+    "stop_tag_missing",
+    "platform_tag_missing",
+    "stop_is_not_node",
+    "no_ferry"
+};
+
+void RouteStatistics::add(const RouteError validation_result) {
+    if (validation_result == RouteError::CLEAN) {
+        ++valid;
+        return;
+    }
+    ++invalid;
+    const uint32_t bits = static_cast<uint32_t>(validation_result);
+    for (size_t i = 0; i < ERROR_BITS; ++i) {
+        if (bits & (1u << i)) {
+            ++errors[i];
+        }
+    }
+}
+
+void RouteStatistics::add(const RouteStatistics& other) {
+    valid += other.valid;
+    invalid += other.invalid;
+    for (size_t i = 0; i < ERROR_BITS; ++i) {
+        errors[i] += other.errors[i];
+    }
+}
+
+/**
+ * Write a string as JSON string literal.
+ */
+static void write_json_string(std::ostream& out, const std::string& str) {
+    out << '"';
+    for (const char c : str) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+/*static*/ double Statistics::cpu_time() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+/*static*/ uint64_t Statistics::peak_rss() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    // ru_maxrss is reported in KB on Linux
+    return static_cast<uint64_t>(usage.ru_maxrss);
+}
+
+void Statistics::start_pass(const char* name) {
+    m_passes.emplace_back();
+    m_passes.back().name = name;
+    m_pass_start = std::chrono::steady_clock::now();
+    m_pass_start_cpu = cpu_time();
+}
+
+void Statistics::end_pass() {
+    Pass& pass = m_passes.back();
+    pass.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_pass_start).count();
+    pass.cpu_seconds = cpu_time() - m_pass_start_cpu;
+    pass.peak_rss = peak_rss();
+}
+
+void Statistics::set_location_index(const std::string& type, const size_t used_memory) {
+    m_location_index_type = type;
+    m_location_index_memory = used_memory;
+}
+
+void Statistics::set_item_stash_memory(const size_t used_memory) {
+    m_item_stash_memory = used_memory;
+}
+
+void Statistics::set_relations_manager_memory(const size_t relations_db, const size_t members_db, const size_t stash) {
+    m_relations_db_memory = relations_db;
+    m_members_db_memory = members_db;
+    m_relations_stash_memory = stash;
+}
+
+void Statistics::set_routes(const RouteStatistics& routes) {
+    m_routes = routes;
+}
+
+void Statistics::set_layer_features(std::vector<std::pair<std::string, int64_t>>&& layer_features) {
+    m_layer_features = std::move(layer_features);
+}
+
+void Statistics::save(const std::string& filename) const {
+    std::ofstream out(filename);
+    if (!out) {
+        throw std::runtime_error{"Cannot open " + filename};
+    }
+    out.precision(std::numeric_limits<double>::max_digits10);
+    for (const Pass& pass : m_passes) {
+        out << "pass " << pass.name << ' ' << pass.wall_seconds << ' ' << pass.cpu_seconds << ' ' << pass.nodes
+            << ' ' << pass.ways << ' ' << pass.relations << ' ' << pass.peak_rss << '\n';
+    }
+    out << "memory " << m_location_index_memory << ' ' << m_item_stash_memory << ' ' << m_relations_db_memory
+        << ' ' << m_members_db_memory << ' ' << m_relations_stash_memory << ' ' << peak_rss() << '\n';
+    out << "routes " << m_routes.valid << ' ' << m_routes.invalid;
+    for (const uint64_t count : m_routes.errors) {
+        out << ' ' << count;
+    }
+    // The type may contain a file name, therefore it is the last line.
+    out << "\nlocation_index_type " << m_location_index_type << '\n';
+    if (!out) {
+        throw std::runtime_error{"Writing " + filename + " failed"};
+    }
+}
+
+void Statistics::add_saved(const std::string& filename) {
+    std::ifstream in(filename);
+    if (!in) {
+        throw std::runtime_error{"Cannot open " + filename};
+    }
+    size_t pass_index = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        fields >> key;
+        if (key == "pass") {
+            Pass pass;
+            fields >> pass.name >> pass.wall_seconds >> pass.cpu_seconds >> pass.nodes >> pass.ways >> pass.relations
+                >> pass.peak_rss;
+            if (pass_index == m_passes.size()) {
+                m_passes.emplace_back();
+                m_passes.back().name = pass.name;
+            }
+            Pass& sum = m_passes.at(pass_index++);
+            sum.wall_seconds = std::max(sum.wall_seconds, pass.wall_seconds);
+            sum.cpu_seconds += pass.cpu_seconds;
+            sum.nodes += pass.nodes;
+            sum.ways += pass.ways;
+            sum.relations += pass.relations;
+            sum.peak_rss += pass.peak_rss;
+        } else if (key == "memory") {
+            size_t location_index = 0;
+            size_t item_stash = 0;
+            size_t relations_db = 0;
+            size_t members_db = 0;
+            size_t relations_stash = 0;
+            uint64_t process_peak_rss = 0;
+            fields >> location_index >> item_stash >> relations_db >> members_db >> relations_stash >> process_peak_rss;
+            m_location_index_memory += location_index;
+            m_item_stash_memory += item_stash;
+            m_relations_db_memory += relations_db;
+            m_members_db_memory += members_db;
+            m_relations_stash_memory += relations_stash;
+            m_workers_peak_rss += process_peak_rss;
+        } else if (key == "routes") {
+            RouteStatistics routes;
+            fields >> routes.valid >> routes.invalid;
+            for (uint64_t& count : routes.errors) {
+                fields >> count;
+            }
+            m_routes.add(routes);
+        } else if (key == "location_index_type") {
+            // All workers use the same type.
+            m_location_index_type = line.size() > key.size() ? line.substr(key.size() + 1) : "";
+        } else {
+            throw std::runtime_error{"Invalid line in " + filename + ": " + line};
+        }
+        if (fields.fail()) {
+            throw std::runtime_error{"Invalid line in " + filename + ": " + line};
+        }
+    }
+}
+
+void Statistics::write(const std::string& filename) const {
+    std::ofstream out(filename);
+    if (!out) {
+        throw std::runtime_error{"Cannot open " + filename};
+    }
+    out << "{\n  \"passes\": [";
+    for (size_t i = 0; i < m_passes.size(); ++i) {
+        const Pass& pass = m_passes[i];
+        const double seconds = pass.wall_seconds > 0 ? pass.wall_seconds : 1.0;
+        out << (i ? ",\n" : "\n") << "    {\"name\": ";
+        write_json_string(out, pass.name);
+        out << ", \"wall_seconds\": " << pass.wall_seconds
+            << ", \"cpu_seconds\": " << pass.cpu_seconds
+            << ", \"nodes\": " << pass.nodes
+            << ", \"ways\": " << pass.ways
+            << ", \"relations\": " << pass.relations
+            << ", \"nodes_per_second\": " << static_cast<uint64_t>(pass.nodes / seconds)
+            << ", \"ways_per_second\": " << static_cast<uint64_t>(pass.ways / seconds)
+            << ", \"relations_per_second\": " << static_cast<uint64_t>(pass.relations / seconds)
+            << ", \"peak_rss_kb\": " << pass.peak_rss << '}';
+    }
+    out << "\n  ],\n  \"layers\": {";
+    for (size_t i = 0; i < m_layer_features.size(); ++i) {
+        out << (i ? ",\n" : "\n") << "    ";
+        write_json_string(out, m_layer_features[i].first);
+        out << ": " << m_layer_features[i].second;
+    }
+    out << "\n  },\n  \"routes\": {\"valid\": " << m_routes.valid << ", \"invalid\": " << m_routes.invalid << ", \"errors\": {";
+    for (size_t i = 0; i < RouteStatistics::ERROR_BITS; ++i) {
+        out << (i ? ", " : "") << '"' << ROUTE_ERROR_NAMES[i] << "\": " << m_routes.errors[i];
+    }
+    out << "}},\n  \"memory\": {\"location_index_type\": ";
+    write_json_string(out, m_location_index_type);
+    out << ", \"location_index_bytes\": " << m_location_index_memory
+        << ", \"item_stash_bytes\": " << m_item_stash_memory
+        << ", \"relations_db_bytes\": " << m_relations_db_memory
+        << ", \"members_db_bytes\": " << m_members_db_memory
+        << ", \"relations_stash_bytes\": " << m_relations_stash_memory
+        << ", \"peak_rss_kb\": " << (m_workers_peak_rss + peak_rss()) << "}\n}\n";
+    if (!out) {
+        throw std::runtime_error{"Writing " + filename + " failed"};
+    }
+}
@@ -0,0 +1,154 @@
+/*
+ * statistics.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_STATISTICS_HPP_
+#define SRC_STATISTICS_HPP_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <osmium/handler.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+
+#include "route_writer.hpp"
+
+/**
+ * Counters of the validation results of the routes.
+ */
+struct RouteStatistics {
+    /// number of bits of RouteError
+    static constexpr size_t ERROR_BITS = 16;
+
+    uint64_t valid = 0;
+
+    uint64_t invalid = 0;
+
+    /// number of invalid routes per error bit
+    std::array<uint64_t, ERROR_BITS> errors {};
+
+    void add(const RouteError validation_result);
+
+    /**
+     * Add the counters of another instance.
+     */
+    void add(const RouteStatistics& other);
+};
+
+/**
+ * Collect timings, throughput and memory usage of a run and write them as JSON.
+ *
+ * It is a handler counting the objects read by the current pass. Add it to the handlers of
+ * each pass and enclose each pass in start_pass() and end_pass().
+ */
+class Statistics : public osmium::handler::Handler {
+
+    struct Pass {
+        std::string name;
+        double wall_seconds = 0.0;
+        double cpu_seconds = 0.0;
+        uint64_t nodes = 0;
+        uint64_t ways = 0;
+        uint64_t relations = 0;
+        /// peak resident set size at the end of the pass in KB
+        uint64_t peak_rss = 0;
+    };
+
+    std::vector<Pass> m_passes;
+
+    std::chrono::steady_clock::time_point m_pass_start;
+
+    double m_pass_start_cpu = 0.0;
+
+    std::string m_location_index_type;
+
+    size_t m_location_index_memory = 0;
+
+    size_t m_item_stash_memory = 0;
+
+    size_t m_relations_db_memory = 0;
+
+    size_t m_members_db_memory = 0;
+
+    size_t m_relations_stash_memory = 0;
+
+    RouteStatistics m_routes;
+
+    std::vector<std::pair<std::string, int64_t>> m_layer_features;
+
+    /// sum of the peak resident set sizes of the worker processes added by add_saved() in KB
+    uint64_t m_workers_peak_rss = 0;
+
+    /**
+     * User and system CPU time used by the process in seconds.
+     */
+    static double cpu_time();
+
+    /**
+     * Peak resident set size of the process in KB.
+     */
+    static uint64_t peak_rss();
+
+public:
+    void start_pass(const char* name);
+
+    void end_pass();
+
+    void node(const osmium::Node&) noexcept {
+        ++m_passes.back().nodes;
+    }
+
+    void way(const osmium::Way&) noexcept {
+        ++m_passes.back().ways;
+    }
+
+    void relation(const osmium::Relation&) noexcept {
+        ++m_passes.back().relations;
+    }
+
+    void set_location_index(const std::string& type, const size_t used_memory);
+
+    void set_item_stash_memory(const size_t used_memory);
+
+    void set_relations_manager_memory(const size_t relations_db, const size_t members_db, const size_t stash);
+
+    void set_routes(const RouteStatistics& routes);
+
+    void set_layer_features(std::vector<std::pair<std::string, int64_t>>&& layer_features);
+
+    /**
+     * Save the passes, the memory usage and the route counters in a line-based format read by
+     * add_saved(). Worker processes use it to hand their statistics to the main process.
+     *
+     * \throws std::runtime_error if the file cannot be written
+     */
+    void save(const std::string& filename) const;
+
+    /**
+     * Add the statistics of a worker process which ran in parallel to the other workers.
+     *
+     * Passes are matched by their position. The wall time of a pass is the longest one of all workers,
+     * the CPU time, the object counters and the peak memory usage are summed up. Layer feature counts
+     * are not saved, set them using set_layer_features().
+     *
+     * \throws std::runtime_error if the file cannot be read or is invalid
+     */
+    void add_saved(const std::string& filename);
+
+    /**
+     * Write the statistics as JSON.
+     *
+     * \throws std::runtime_error if the file cannot be written
+     */
+    void write(const std::string& filename) const;
+};
+
+#endif /* SRC_STATISTICS_HPP_ */
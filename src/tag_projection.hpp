@@ -0,0 +1,118 @@
+/*
+ * tag_projection.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_TAG_PROJECTION_HPP_
+#define SRC_TAG_PROJECTION_HPP_
+
+#include <cstddef>
+#include <cstring>
+
+#include <osmium/osm/tag.hpp>
+
+/**
+ * Compare two keys like strcmp(). This can be evaluated by the compiler.
+ */
+constexpr int tag_key_compare(const char* a, const char* b) {
+    return (*a != *b || !*a) ? static_cast<unsigned char>(*a) - static_cast<unsigned char>(*b) : tag_key_compare(a + 1, b + 1);
+}
+
+/**
+ * Are the keys in strictly ascending order? Use this in a static_assert for the key sets of TagProjection.
+ */
+template <size_t N>
+constexpr bool tag_keys_sorted(const char* const (&keys)[N], size_t i = 1) {
+    return i >= N || (tag_key_compare(keys[i - 1], keys[i]) < 0 && tag_keys_sorted(keys, i + 1));
+}
+
+/**
+ * Values of a fixed set of keys read in one pass over a tag list.
+ *
+ * The key set is an array of keys in ascending order. The position of a key in the array is the
+ * index of its value. Each tag of the list is looked up in the key set by binary search. This
+ * replaces one linear scan of the tag list per key by calls of get_value_by_key().
+ *
+ * Like get_value_by_key(), the first tag with a key wins. The values point into the tag list
+ * and are valid as long as the tag list is.
+ */
+template <size_t N>
+class TagProjection {
+
+    const char* const (&m_keys)[N];
+
+    const char* m_values[N];
+
+    /**
+     * Index of a key in the key set, N if the key is not in the set.
+     */
+    size_t find(const char* key) const noexcept {
+        size_t first = 0;
+        size_t last = N;
+        while (first < last) {
+            const size_t middle = first + (last - first) / 2;
+            const int comparison = strcmp(key, m_keys[middle]);
+            if (comparison == 0) {
+                return middle;
+            }
+            if (comparison < 0) {
+                last = middle;
+            } else {
+                first = middle + 1;
+            }
+        }
+        return N;
+    }
+
+public:
+    TagProjection() = delete;
+
+    /**
+     * \param keys key set, the array has to live as long as the projection
+     */
+    explicit TagProjection(const char* const (&keys)[N]) noexcept :
+            m_keys(keys),
+            m_values() {
+    }
+
+    TagProjection(const char* const (&keys)[N], const osmium::TagList& tags) noexcept :
+            m_keys(keys),
+            m_values() {
+        project(tags);
+    }
+
+    /**
+     * Read the values of a tag list. The values of the previous tag list are discarded.
+     */
+    void project(const osmium::TagList& tags) noexcept {
+        for (size_t i = 0; i < N; ++i) {
+            m_values[i] = nullptr;
+        }
+        for (const osmium::Tag& tag : tags) {
+            const size_t index = find(tag.key());
+            if (index < N && !m_values[index]) {
+                m_values[index] = tag.value();
+            }
+        }
+    }
+
+    /**
+     * Get the value of a key.
+     *
+     * \param index index of the key in the key set
+     * \param default_value value returned if the tag list does not contain the key
+     */
+    const char* get(size_t index, const char* default_value = nullptr) const noexcept {
+        return m_values[index] ? m_values[index] : default_value;
+    }
+
+    /**
+     * Does the tag list contain the key with this value?
+     */
+    bool has(size_t index, const char* value) const noexcept {
+        return m_values[index] && !strcmp(m_values[index], value);
+    }
+};
+
+#endif /* SRC_TAG_PROJECTION_HPP_ */
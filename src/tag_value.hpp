@@ -0,0 +1,205 @@
+/*
+ * tag_value.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_TAG_VALUE_HPP_
+#define SRC_TAG_VALUE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Tag values this program is interested in (values of railway, public_transport, route, highway,
+ * crossing:barrier etc. and member roles). The order has to match TAG_VALUE_NAMES.
+ */
+enum class TagValue : uint8_t {
+    UNKNOWN = 0,
+    AERIALWAY,
+    BUFFER_STOP,
+    BUS,
+    BUS_GUIDEWAY,
+    CROSSING,
+    DERAIL,
+    DOUBLE_HALF,
+    FERRY,
+    FULL,
+    FUNICULAR,
+    GATES,
+    HALF,
+    HALT,
+    ISOLATED_TRACK_SECTION,
+    LEVEL_CROSSING,
+    LIGHT_RAIL,
+    LIVING_STREET,
+    MILESTONE,
+    MINIATURE,
+    MOTORWAY,
+    MOTORWAY_LINK,
+    NARROW_GAUGE,
+    NO,
+    PEDESTRIAN,
+    PLATFORM,
+    PLATFORM_ENTRY_ONLY,
+    PLATFORM_EXIT_ONLY,
+    PRESERVED,
+    PRIMARY,
+    PRIMARY_LINK,
+    RAIL,
+    RAILWAY_CROSSING,
+    RESIDENTIAL,
+    ROUTE,
+    SECONDARY,
+    SECONDARY_LINK,
+    SERVICE,
+    SHARE_TAXI,
+    SIGNAL,
+    STATION,
+    STOP,
+    STOP_ENTRY_ONLY,
+    STOP_EXIT_ONLY,
+    STOP_POSITION,
+    SUBWAY,
+    SWITCH,
+    TERTIARY,
+    TERTIARY_LINK,
+    TRACK,
+    TRAIN,
+    TRAM,
+    TRAM_STOP,
+    TROLLEYBUS,
+    TRUNK,
+    TRUNK_LINK,
+    UNCLASSIFIED,
+    YES,
+    COUNT
+};
+
+/// names of the tag values in the order of TagValue
+constexpr const char* TAG_VALUE_NAMES[] = {
+    "",
+    "aerialway", "buffer_stop", "bus", "bus_guideway", "crossing", "derail", "double_half", "ferry",
+    "full", "funicular", "gates", "half", "halt", "isolated_track_section", "level_crossing",
+    "light_rail", "living_street", "milestone", "miniature", "motorway", "motorway_link",
+    "narrow_gauge", "no", "pedestrian", "platform", "platform_entry_only", "platform_exit_only",
+    "preserved", "primary", "primary_link", "rail", "railway_crossing", "residential", "route",
+    "secondary", "secondary_link", "service", "share_taxi", "signal", "station", "stop",
+    "stop_entry_only", "stop_exit_only", "stop_position", "subway", "switch", "tertiary",
+    "tertiary_link", "track", "train", "tram", "tram_stop", "trolleybus", "trunk", "trunk_link",
+    "unclassified", "yes"
+};
+
+static_assert(sizeof(TAG_VALUE_NAMES) / sizeof(TAG_VALUE_NAMES[0]) == static_cast<size_t>(TagValue::COUNT),
+        "TAG_VALUE_NAMES does not match TagValue");
+
+/**
+ * Perfect hash of the names of TagValue.
+ *
+ * The slot of a value is taken from a FNV-1a hash. The seed has been chosen by trying seeds until
+ * all names got different slots. The static_assert below fails if a new value collides with
+ * another one. Choose a different seed (or a larger table) in that case.
+ */
+namespace tag_value_hash {
+
+    constexpr uint32_t SEED = 2166157455u;
+
+    constexpr uint32_t PRIME = 16777619u;
+
+    constexpr size_t TABLE_SIZE = 128;
+
+    constexpr uint32_t hash(const char* str, uint32_t value = SEED) {
+        return *str ? hash(str + 1, (value ^ static_cast<uint8_t>(*str)) * PRIME) : value;
+    }
+
+    constexpr size_t slot(uint32_t hash_value) {
+        return (hash_value >> 16) & (TABLE_SIZE - 1);
+    }
+
+    constexpr size_t length(const char* str) {
+        return *str ? 1 + length(str + 1) : 0;
+    }
+
+    constexpr bool collides(size_t i, size_t j) {
+        return j < static_cast<size_t>(TagValue::COUNT)
+            && (slot(hash(TAG_VALUE_NAMES[i])) == slot(hash(TAG_VALUE_NAMES[j])) || collides(i, j + 1));
+    }
+
+    constexpr bool perfect(size_t i = 1) {
+        return i >= static_cast<size_t>(TagValue::COUNT) || (!collides(i, i + 1) && perfect(i + 1));
+    }
+
+    static_assert(perfect(), "The hash of the tag values is not perfect. Choose a different seed.");
+
+    /**
+     * Value whose name is in a slot, UNKNOWN if the slot is empty.
+     */
+    constexpr TagValue value_in_slot(size_t slot_index, size_t i = 1) {
+        return i >= static_cast<size_t>(TagValue::COUNT) ? TagValue::UNKNOWN
+            : (slot(hash(TAG_VALUE_NAMES[i])) == slot_index ? static_cast<TagValue>(i) : value_in_slot(slot_index, i + 1));
+    }
+
+    template <size_t... I>
+    struct index_list {};
+
+    template <size_t N, size_t... I>
+    struct make_index_list : make_index_list<N - 1, N - 1, I...> {};
+
+    template <size_t... I>
+    struct make_index_list<0, I...> {
+        using type = index_list<I...>;
+    };
+
+    struct Table {
+        TagValue values[TABLE_SIZE];
+        uint8_t lengths[static_cast<size_t>(TagValue::COUNT)];
+    };
+
+    template <size_t... S, size_t... V>
+    constexpr Table make_table(index_list<S...>, index_list<V...>) {
+        return Table{{value_in_slot(S)...}, {static_cast<uint8_t>(length(TAG_VALUE_NAMES[V]))...}};
+    }
+
+    /// table built by the compiler
+    constexpr Table TABLE = make_table(make_index_list<TABLE_SIZE>::type{},
+            make_index_list<static_cast<size_t>(TagValue::COUNT)>::type{});
+
+    constexpr size_t max_length(size_t i = 1, size_t result = 0) {
+        return i >= static_cast<size_t>(TagValue::COUNT) ? result
+            : max_length(i + 1, length(TAG_VALUE_NAMES[i]) > result ? length(TAG_VALUE_NAMES[i]) : result);
+    }
+
+    /// length of the longest name
+    constexpr size_t MAX_LENGTH = max_length();
+
+} // namespace tag_value_hash
+
+/**
+ * Classify a tag value or role using one hash and one comparison.
+ *
+ * \param value tag value, may be nullptr
+ * \returns TagValue::UNKNOWN if the value is nullptr or not one of TagValue
+ */
+inline TagValue classify_tag_value(const char* value) noexcept {
+    if (!value) {
+        return TagValue::UNKNOWN;
+    }
+    uint32_t hash = tag_value_hash::SEED;
+    size_t length = 0;
+    for (; value[length]; ++length) {
+        if (length == tag_value_hash::MAX_LENGTH) {
+            return TagValue::UNKNOWN;
+        }
+        hash = (hash ^ static_cast<uint8_t>(value[length])) * tag_value_hash::PRIME;
+    }
+    const TagValue result = tag_value_hash::TABLE.values[tag_value_hash::slot(hash)];
+    const size_t index = static_cast<size_t>(result);
+    if (result == TagValue::UNKNOWN || tag_value_hash::TABLE.lengths[index] != length
+            || memcmp(value, TAG_VALUE_NAMES[index], length)) {
+        return TagValue::UNKNOWN;
+    }
+    return result;
+}
+
+#endif /* SRC_TAG_VALUE_HPP_ */
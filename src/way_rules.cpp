@@ -0,0 +1,289 @@
+/*
+ * way_rules.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+#include "tag_value.hpp"
+#include "way_rules.hpp"
+
+/*static*/ constexpr size_t WayRules::MAX_KEYS;
+/*static*/ constexpr size_t WayRules::MAX_VALUES;
+
+/// rules used if no rule file is given
+static const char* DEFAULT_RULES = R"(# rail-guided routes
+train railway=rail|light_rail|tram|subway|funicular|preserved|miniature|narrow_gauge
+train route=ferry
+tram railway=rail|light_rail|tram|subway|funicular|preserved|miniature|narrow_gauge
+tram route=ferry
+subway railway=*
+subway route=ferry
+
+# road vehicles, ways tagged with highway=* and route=ferry are not considered as ferries
+@roads motorway|motorway_link|trunk|trunk_link|primary|primary_link|secondary|secondary_link|tertiary|tertiary_link|unclassified|residential|service|track|pedestrian|living_street|bus_guideway
+bus highway=@roads
+bus !highway route=ferry
+trolleybus trolley_wire=yes|forward|backward highway=@roads
+trolleybus trolley_wire=yes|forward|backward !highway route=ferry
+trolleybus trolley_wire:forward=yes highway=@roads
+trolleybus trolley_wire:forward=yes !highway route=ferry
+trolleybus trolley_wire:backward=yes highway=@roads
+trolleybus trolley_wire:backward=yes !highway route=ferry
+
+# ferries, ways without route=* are allowed
+ferry route=ferry
+ferry !route
+)";
+
+/**
+ * A condition of a rule before the keys and values are numbered.
+ */
+struct ParsedCondition {
+    std::string key;
+    bool absent = false;
+    bool any_value = false;
+    std::vector<std::string> values;
+};
+
+struct ParsedRule {
+    RouteType type;
+    std::vector<ParsedCondition> conditions;
+};
+
+/**
+ * Route type of a rule, RouteType::NONE if the route type cannot be checked.
+ */
+static RouteType parse_route_type(const std::string& name) {
+    switch (classify_tag_value(name.c_str())) {
+    case TagValue::TRAIN:
+        return RouteType::TRAIN;
+    case TagValue::SUBWAY:
+        return RouteType::SUBWAY;
+    case TagValue::TRAM:
+        return RouteType::TRAM;
+    case TagValue::BUS:
+        return RouteType::BUS;
+    case TagValue::TROLLEYBUS:
+        return RouteType::TROLLEYBUS;
+    case TagValue::FERRY:
+        return RouteType::FERRY;
+    default:
+        return RouteType::NONE;
+    }
+}
+
+WayRules::WayRules() :
+        m_keys(),
+        m_values(),
+        m_conditions(),
+        m_rules(),
+        m_type_rules() {
+}
+
+/*static*/ const WayRules& WayRules::defaults() {
+    static const WayRules rules = [](){
+        std::istringstream input {DEFAULT_RULES};
+        return parse(input, "default rules");
+    }();
+    return rules;
+}
+
+/*static*/ WayRules WayRules::from_file(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file) {
+        throw std::runtime_error{"Cannot open way rules " + filename};
+    }
+    return parse(file, filename);
+}
+
+/*static*/ WayRules WayRules::parse(std::istream& input, const std::string& name) {
+    std::map<std::string, std::vector<std::string>> value_lists;
+    std::vector<ParsedRule> parsed_rules;
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(input, line)) {
+        ++line_number;
+        const std::string error = "Invalid line " + std::to_string(line_number) + " in way rules " + name + ": ";
+        std::istringstream in(line);
+        std::string first;
+        if (!(in >> first) || first[0] == '#') {
+            continue;
+        }
+        if (first[0] == '@') {
+            std::string values;
+            if (first.size() == 1 || !(in >> values)) {
+                throw std::runtime_error{error + line};
+            }
+            std::vector<std::string>& list = value_lists[first.substr(1)];
+            std::istringstream value_stream(values);
+            std::string value;
+            while (std::getline(value_stream, value, '|')) {
+                list.push_back(value);
+            }
+            continue;
+        }
+        ParsedRule rule;
+        rule.type = parse_route_type(first);
+        if (rule.type == RouteType::NONE) {
+            throw std::runtime_error{error + "unknown route type " + first};
+        }
+        std::string token;
+        while (in >> token) {
+            ParsedCondition condition;
+            const size_t equals = token.find('=');
+            if (token[0] == '!') {
+                condition.key = token.substr(1);
+                condition.absent = true;
+            } else if (equals != std::string::npos) {
+                condition.key = token.substr(0, equals);
+                const std::string values = token.substr(equals + 1);
+                if (values == "*") {
+                    condition.any_value = true;
+                }
+                std::istringstream value_stream(values);
+                std::string value;
+                while (!condition.any_value && std::getline(value_stream, value, '|')) {
+                    if (value.empty() || value[0] != '@') {
+                        condition.values.push_back(value);
+                        continue;
+                    }
+                    const auto list = value_lists.find(value.substr(1));
+                    if (list == value_lists.end()) {
+                        throw std::runtime_error{error + "unknown value list " + value};
+                    }
+                    condition.values.insert(condition.values.end(), list->second.begin(), list->second.end());
+                }
+            }
+            if (condition.key.empty() || (!condition.absent && !condition.any_value && condition.values.empty())) {
+                throw std::runtime_error{error + "invalid condition " + token};
+            }
+            for (const ParsedCondition& other : rule.conditions) {
+                if (other.key == condition.key) {
+                    throw std::runtime_error{error + "key " + condition.key + " is used twice"};
+                }
+            }
+            rule.conditions.push_back(std::move(condition));
+        }
+        if (rule.conditions.empty()) {
+            throw std::runtime_error{error + "rule without conditions"};
+        }
+        parsed_rules.push_back(std::move(rule));
+    }
+
+    // Number the keys and values in ascending order.
+    WayRules rules;
+    std::map<std::string, std::vector<std::string>> key_values;
+    for (const ParsedRule& rule : parsed_rules) {
+        for (const ParsedCondition& condition : rule.conditions) {
+            std::vector<std::string>& values = key_values[condition.key];
+            values.insert(values.end(), condition.values.begin(), condition.values.end());
+        }
+    }
+    if (key_values.size() > MAX_KEYS) {
+        throw std::runtime_error{"Way rules " + name + " use more than " + std::to_string(MAX_KEYS) + " keys"};
+    }
+    for (auto& key_value : key_values) {
+        std::vector<std::string>& values = key_value.second;
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+        if (values.size() > MAX_VALUES) {
+            throw std::runtime_error{"Way rules " + name + " use more than " + std::to_string(MAX_VALUES)
+                + " values of key " + key_value.first};
+        }
+        rules.m_keys.push_back(key_value.first);
+        rules.m_values.push_back(std::move(values));
+    }
+
+    // Compile the conditions into bitmasks of value IDs.
+    std::stable_sort(parsed_rules.begin(), parsed_rules.end(), [](const ParsedRule& a, const ParsedRule& b) {
+        return a.type < b.type;
+    });
+    for (const ParsedRule& rule : parsed_rules) {
+        const size_t type = static_cast<size_t>(rule.type);
+        if (rules.m_type_rules[type].first == rules.m_type_rules[type].second) {
+            rules.m_type_rules[type].first = static_cast<uint32_t>(rules.m_rules.size());
+        }
+        rules.m_rules.push_back(Rule{static_cast<uint32_t>(rules.m_conditions.size()),
+            static_cast<uint32_t>(rule.conditions.size())});
+        rules.m_type_rules[type].second = static_cast<uint32_t>(rules.m_rules.size());
+        for (const ParsedCondition& condition : rule.conditions) {
+            const size_t key = rules.find_key(condition.key.c_str());
+            uint64_t mask = 0;
+            if (condition.absent) {
+                mask = uint64_t{1} << ABSENT;
+            } else if (condition.any_value) {
+                mask = ~(uint64_t{1} << ABSENT);
+            } else {
+                for (const std::string& value : condition.values) {
+                    mask |= uint64_t{1} << rules.find_value(key, value.c_str());
+                }
+            }
+            rules.m_conditions.push_back(Condition{static_cast<uint8_t>(key), mask});
+        }
+    }
+    return rules;
+}
+
+const std::vector<std::string>& WayRules::keys() const noexcept {
+    return m_keys;
+}
+
+size_t WayRules::find_key(const char* key) const noexcept {
+    const auto it = std::lower_bound(m_keys.begin(), m_keys.end(), key, [](const std::string& a, const char* b) {
+        return strcmp(a.c_str(), b) < 0;
+    });
+    if (it == m_keys.end() || strcmp(it->c_str(), key)) {
+        return MAX_KEYS;
+    }
+    return static_cast<size_t>(it - m_keys.begin());
+}
+
+uint8_t WayRules::find_value(size_t key, const char* value) const noexcept {
+    const std::vector<std::string>& values = m_values[key];
+    const auto it = std::lower_bound(values.begin(), values.end(), value, [](const std::string& a, const char* b) {
+        return strcmp(a.c_str(), b) < 0;
+    });
+    if (it == values.end() || strcmp(it->c_str(), value)) {
+        return OTHER_VALUE;
+    }
+    return static_cast<uint8_t>(it - values.begin() + 2);
+}
+
+bool WayRules::checks(RouteType type) const noexcept {
+    const auto& range = m_type_rules[static_cast<size_t>(type)];
+    return range.first != range.second;
+}
+
+bool WayRules::allows(RouteType type, const osmium::TagList& tags) const noexcept {
+    const auto& range = m_type_rules[static_cast<size_t>(type)];
+    if (range.first == range.second) {
+        return true;
+    }
+    // Like get_value_by_key(), the first tag with a key wins.
+    uint8_t value_ids[MAX_KEYS] = {};
+    for (const osmium::Tag& tag : tags) {
+        const size_t key = find_key(tag.key());
+        if (key < MAX_KEYS && value_ids[key] == ABSENT) {
+            value_ids[key] = find_value(key, tag.value());
+        }
+    }
+    for (uint32_t r = range.first; r < range.second; ++r) {
+        const Rule& rule = m_rules[r];
+        bool matches = true;
+        for (uint32_t c = rule.first_condition; matches && c < rule.first_condition + rule.condition_count; ++c) {
+            const Condition& condition = m_conditions[c];
+            matches = (condition.values >> value_ids[condition.key]) & 1;
+        }
+        if (matches) {
+            return true;
+        }
+    }
+    return false;
+}
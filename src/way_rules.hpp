@@ -0,0 +1,138 @@
+/*
+ * way_rules.hpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#ifndef SRC_WAY_RULES_HPP_
+#define SRC_WAY_RULES_HPP_
+
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <osmium/osm/tag.hpp>
+
+#include "route_writer.hpp"
+
+/**
+ * Rules which ways a route of a given type may use, compiled into a decision table.
+ *
+ * The rules are read from a text file with one rule per line. A rule consists of a route type
+ * (the value of the route tag: train, subway, tram, bus, trolleybus, ferry) and one or more
+ * conditions which all have to match:
+ *
+ * * `key=value1|value2` – the way has the key with one of the values
+ * * `key=*` – the way has the key with any value
+ * * `!key` – the way does not have the key
+ *
+ * A way is usable for a route type if any rule of the type matches. Route types without rules are
+ * not checked. A line `@name value1|value2` defines a list of values which can be used as
+ * `key=@name` in the following lines, also combined with other values. Empty lines and lines
+ * starting with `#` are ignored.
+ *
+ * The compiled table stores the values of each key in a sorted list. A condition is a bitmask over
+ * the positions in this list, bit 0 standing for a missing key and bit 1 for any value not in the
+ * list. A way is classified by one pass over its tags.
+ */
+class WayRules {
+public:
+    /// maximum number of different keys in the rules
+    static constexpr size_t MAX_KEYS = 32;
+
+    /// maximum number of different values of a key in the rules
+    static constexpr size_t MAX_VALUES = 62;
+
+private:
+    static constexpr size_t ROUTE_TYPE_COUNT = static_cast<size_t>(RouteType::SUBWAY) + 1;
+
+    /// value ID of a key which is missing
+    static constexpr uint8_t ABSENT = 0;
+
+    /// value ID of a value which is not used by any rule
+    static constexpr uint8_t OTHER_VALUE = 1;
+
+    struct Condition {
+        /// index in m_keys
+        uint8_t key;
+        /// bit i is set if value ID i matches
+        uint64_t values;
+    };
+
+    struct Rule {
+        /// index of the first condition in m_conditions
+        uint32_t first_condition;
+        uint32_t condition_count;
+    };
+
+    /// keys used by the rules, in ascending order
+    std::vector<std::string> m_keys;
+
+    /// values of each key used by the rules, in ascending order. The value ID is the position plus 2.
+    std::vector<std::vector<std::string>> m_values;
+
+    std::vector<Condition> m_conditions;
+
+    /// rules ordered by route type
+    std::vector<Rule> m_rules;
+
+    /// range of m_rules of each route type
+    std::array<std::pair<uint32_t, uint32_t>, ROUTE_TYPE_COUNT> m_type_rules;
+
+    WayRules();
+
+    /**
+     * Index of a key in m_keys, MAX_KEYS if the key is not used by the rules.
+     */
+    size_t find_key(const char* key) const noexcept;
+
+    /**
+     * Value ID of the value of a key.
+     */
+    uint8_t find_value(size_t key, const char* value) const noexcept;
+
+public:
+    /**
+     * Rules reproducing the checks of OSMI Public Transport: rail-guided routes on railways, buses
+     * on roads, trolley buses on roads with trolley wire, ferries on ferry routes. Routes over
+     * ferries are allowed for all types.
+     */
+    static const WayRules& defaults();
+
+    /**
+     * Read rules from a file. They replace the default rules.
+     *
+     * \throws std::runtime_error if the file cannot be read or parsed
+     */
+    static WayRules from_file(const std::string& filename);
+
+    /**
+     * Read rules from a stream.
+     *
+     * \param name name of the input used in error messages
+     *
+     * \throws std::runtime_error if the rules cannot be parsed
+     */
+    static WayRules parse(std::istream& input, const std::string& name);
+
+    /**
+     * Keys used by the rules in ascending order.
+     */
+    const std::vector<std::string>& keys() const noexcept;
+
+    /**
+     * Does the route type have rules?
+     */
+    bool checks(RouteType type) const noexcept;
+
+    /**
+     * May a route of the given type use a way with these tags? Route types without rules may use
+     * any way.
+     */
+    bool allows(RouteType type, const osmium::TagList& tags) const noexcept;
+};
+
+#endif /* SRC_WAY_RULES_HPP_ */
@@ -0,0 +1,216 @@
+/*
+ * test_blob_index.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include "catch.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <protozero/pbf_writer.hpp>
+
+#include <blob_index.hpp>
+
+static const std::string PBF_FILENAME = "test_blob_index.osm.pbf";
+static const std::string INDEX_FILENAME = "test_blob_index.osm.pbf.idx";
+
+/**
+ * Type of the objects of a primitive group (field number of the group in PrimitiveGroup).
+ */
+enum class GroupType : int {
+    NODES = 1,
+    WAYS = 3,
+    RELATIONS = 4
+};
+
+/**
+ * Build a primitive block with one group of objects which have nothing but an ID.
+ */
+static std::string primitive_block(const GroupType type, const std::vector<int64_t>& ids) {
+    std::string group;
+    protozero::pbf_writer group_writer(group);
+    for (const int64_t id : ids) {
+        std::string object;
+        protozero::pbf_writer object_writer(object);
+        if (type == GroupType::NODES) {
+            object_writer.add_sint64(1, id);
+        } else {
+            object_writer.add_int64(1, id);
+        }
+        group_writer.add_message(static_cast<int>(type), object);
+    }
+    std::string block;
+    protozero::pbf_writer block_writer(block);
+    block_writer.add_bytes(1, ""); // stringtable
+    block_writer.add_message(2, group);
+    return block;
+}
+
+/**
+ * Append a blob with uncompressed content to the file. The blob_field is the field of the data in
+ * message Blob, 1 is raw.
+ */
+static void write_blob(std::ofstream& file, const char* type, const std::string& content, const int blob_field = 1) {
+    std::string blob;
+    protozero::pbf_writer blob_writer(blob);
+    blob_writer.add_bytes(blob_field, content);
+    std::string header;
+    protozero::pbf_writer header_writer(header);
+    header_writer.add_string(1, type);
+    header_writer.add_int32(3, static_cast<int32_t>(blob.size()));
+    const uint32_t size = static_cast<uint32_t>(header.size());
+    const char size_buffer[4] = {static_cast<char>(size >> 24), static_cast<char>(size >> 16),
+            static_cast<char>(size >> 8), static_cast<char>(size)};
+    file.write(size_buffer, sizeof(size_buffer));
+    file << header << blob;
+}
+
+/**
+ * Write a PBF file with a header blob, two node blobs, a way blob and a relation blob.
+ */
+static void write_pbf_file() {
+    std::ofstream file(PBF_FILENAME, std::ios::binary | std::ios::trunc);
+    write_blob(file, "OSMHeader", "");
+    write_blob(file, "OSMData", primitive_block(GroupType::NODES, {3, 1, 2}));
+    write_blob(file, "OSMData", primitive_block(GroupType::NODES, {10, 12}));
+    write_blob(file, "OSMData", primitive_block(GroupType::WAYS, {7, 5}));
+    write_blob(file, "OSMData", primitive_block(GroupType::RELATIONS, {4}));
+}
+
+static void remove_files() {
+    std::remove(PBF_FILENAME.c_str());
+    std::remove(INDEX_FILENAME.c_str());
+}
+
+TEST_CASE("build the blob index") {
+    remove_files();
+    write_pbf_file();
+    BlobIndex index;
+    index.build(PBF_FILENAME);
+    const std::vector<BlobIndexEntry>& entries = index.entries();
+    REQUIRE(entries.size() == 5);
+
+    SECTION("entries") {
+        CHECK(entries[0].offset == 0);
+        CHECK(entries[0].types == 0);
+        for (size_t i = 1; i < entries.size(); ++i) {
+            CHECK(entries[i].offset == entries[i - 1].offset + entries[i - 1].size);
+        }
+        CHECK(entries[1].types == osmium::osm_entity_bits::node);
+        CHECK(entries[1].min_id == 1);
+        CHECK(entries[1].max_id == 3);
+        CHECK(entries[3].types == osmium::osm_entity_bits::way);
+        CHECK(entries[3].min_id == 5);
+        CHECK(entries[3].max_id == 7);
+        CHECK(entries[4].types == osmium::osm_entity_bits::relation);
+        CHECK(index.max_id(osmium::osm_entity_bits::node) == 12);
+        CHECK(index.max_id(osmium::osm_entity_bits::way) == 7);
+        CHECK(index.max_id(osmium::osm_entity_bits::relation) == 4);
+    }
+
+    SECTION("ranges") {
+        // The header blob is always part of the ranges, adjacent blobs are joined.
+        const auto nodes = index.ranges(osmium::osm_entity_bits::node);
+        REQUIRE(nodes.size() == 1);
+        CHECK(nodes[0].first == 0);
+        CHECK(nodes[0].second == entries[0].size + entries[1].size + entries[2].size);
+
+        const auto ways = index.ranges(osmium::osm_entity_bits::way);
+        REQUIRE(ways.size() == 2);
+        CHECK(ways[0].first == 0);
+        CHECK(ways[0].second == entries[0].size);
+        CHECK(ways[1].first == entries[3].offset);
+        CHECK(ways[1].second == entries[3].size);
+
+        const auto ways_and_relations = index.ranges(osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation);
+        REQUIRE(ways_and_relations.size() == 2);
+        CHECK(ways_and_relations[1].first == entries[3].offset);
+        CHECK(ways_and_relations[1].second == entries[3].size + entries[4].size);
+
+        const auto everything = index.ranges(osmium::osm_entity_bits::nwr);
+        REQUIRE(everything.size() == 1);
+        CHECK(everything[0].second == entries[4].offset + entries[4].size);
+    }
+    remove_files();
+}
+
+TEST_CASE("save and load the blob index") {
+    remove_files();
+    write_pbf_file();
+    BlobIndex index;
+    index.build(PBF_FILENAME);
+
+    SECTION("round trip") {
+        index.save(INDEX_FILENAME, PBF_FILENAME);
+        BlobIndex loaded;
+        REQUIRE(loaded.load(INDEX_FILENAME, PBF_FILENAME));
+        REQUIRE(loaded.entries().size() == index.entries().size());
+        for (size_t i = 0; i < index.entries().size(); ++i) {
+            CHECK(loaded.entries()[i].offset == index.entries()[i].offset);
+            CHECK(loaded.entries()[i].size == index.entries()[i].size);
+            CHECK(loaded.entries()[i].min_id == index.entries()[i].min_id);
+            CHECK(loaded.entries()[i].max_id == index.entries()[i].max_id);
+            CHECK(loaded.entries()[i].types == index.entries()[i].types);
+        }
+    }
+
+    SECTION("missing index file") {
+        BlobIndex loaded;
+        CHECK_FALSE(loaded.load(INDEX_FILENAME, PBF_FILENAME));
+        CHECK(loaded.entries().empty());
+    }
+
+    SECTION("changed PBF file") {
+        index.save(INDEX_FILENAME, PBF_FILENAME);
+        {
+            std::ofstream file(PBF_FILENAME, std::ios::binary | std::ios::app);
+            write_blob(file, "OSMData", primitive_block(GroupType::NODES, {20}));
+        }
+        BlobIndex loaded;
+        CHECK_FALSE(loaded.load(INDEX_FILENAME, PBF_FILENAME));
+        CHECK(loaded.entries().empty());
+    }
+
+    SECTION("invalid index file") {
+        {
+            std::ofstream file(INDEX_FILENAME, std::ios::binary | std::ios::trunc);
+            file << "OSMIBLX0 not an index";
+        }
+        BlobIndex loaded;
+        CHECK_FALSE(loaded.load(INDEX_FILENAME, PBF_FILENAME));
+        CHECK(loaded.entries().empty());
+    }
+    remove_files();
+}
+
+TEST_CASE("blob index of unsupported files") {
+    remove_files();
+
+    SECTION("Zstandard compressed blob") {
+        {
+            std::ofstream file(PBF_FILENAME, std::ios::binary | std::ios::trunc);
+            write_blob(file, "OSMHeader", "");
+            write_blob(file, "OSMData", primitive_block(GroupType::NODES, {1}), 7);
+        }
+        BlobIndex index;
+        CHECK_THROWS_AS(index.build(PBF_FILENAME), BlobIndexUnsupportedError);
+        CHECK(index.entries().empty());
+    }
+
+    SECTION("truncated file") {
+        {
+            std::ofstream file(PBF_FILENAME, std::ios::binary | std::ios::trunc);
+            write_blob(file, "OSMHeader", "");
+            file.write("\0\0\1", 3);
+        }
+        BlobIndex index;
+        CHECK_THROWS_AS(index.build(PBF_FILENAME), std::runtime_error);
+        CHECK(index.entries().empty());
+    }
+    remove_files();
+}
@@ -0,0 +1,98 @@
+/*
+ * test_candidate_filter.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include "catch.hpp"
+#include "object_builder_utilities.hpp"
+
+#include <vector>
+#include <candidate_filter.hpp>
+
+static const osmium::Way& way_with_tags(osmium::memory::Buffer& buffer, const tagmap& tags) {
+    std::vector<const osmium::NodeRef*> node_refs;
+    const osmium::Way& way = test_utils::create_way(buffer, 1, node_refs, tags);
+    buffer.commit();
+    return way;
+}
+
+static const osmium::Node& node_with_tags(osmium::memory::Buffer& buffer, const tagmap& tags) {
+    const osmium::Node& node = test_utils::create_new_node(buffer, 1, osmium::Location{1.0, 1.0}, tags);
+    buffer.commit();
+    return node;
+}
+
+/**
+ * Handler counting the objects it gets.
+ */
+struct CountingHandler {
+    int nodes = 0;
+    int ways = 0;
+
+    void node(const osmium::Node&) {
+        ++nodes;
+    }
+
+    void way(const osmium::Way&) {
+        ++ways;
+    }
+
+    void relation(const osmium::Relation&) {
+    }
+};
+
+TEST_CASE("candidate keys") {
+    static constexpr int buffer_size = 1000 * 1000;
+    osmium::memory::Buffer buffer(buffer_size);
+    const CandidateKeys keys {"highway", "public_transport", "railway", "\xc3\xbc" "ber"};
+
+    SECTION("keys of the set") {
+        CHECK(keys.matches(way_with_tags(buffer, {{"railway", "rail"}}).tags()));
+        CHECK(keys.matches(way_with_tags(buffer, {{"name", "Hauptbahn"}, {"public_transport", "platform"}}).tags()));
+        CHECK(keys.matches(way_with_tags(buffer, {{"\xc3\xbc" "ber", "yes"}}).tags()));
+    }
+
+    SECTION("keys with the same first byte") {
+        CHECK_FALSE(keys.matches(way_with_tags(buffer, {{"ref", "1"}, {"route", "bus"}}).tags()));
+        CHECK_FALSE(keys.matches(way_with_tags(buffer, {{"rail", "yes"}, {"railways", "rail"}}).tags()));
+        CHECK_FALSE(keys.matches(way_with_tags(buffer, {{"\xc3\xbc", "yes"}, {"\xc3\xa4" "ber", "yes"}}).tags()));
+    }
+
+    SECTION("keys with other first bytes") {
+        CHECK_FALSE(keys.matches(way_with_tags(buffer, {}).tags()));
+        CHECK_FALSE(keys.matches(way_with_tags(buffer, {{"name", "Hauptbahn"}, {"building", "yes"}}).tags()));
+        CHECK_FALSE(keys.matches(way_with_tags(buffer, {{"", "empty key"}}).tags()));
+        CHECK_FALSE(keys.matches(way_with_tags(buffer, {{"\xe2\x80\x8b" "railway", "rail"}}).tags()));
+    }
+}
+
+TEST_CASE("candidate filter") {
+    static constexpr int buffer_size = 1000 * 1000;
+    osmium::memory::Buffer buffer(buffer_size);
+    const CandidateKeys node_keys {"railway"};
+    const CandidateKeys way_keys {"highway"};
+    CountingHandler handler;
+
+    SECTION("nodes are filtered by their keys") {
+        CandidateFilter<CountingHandler> filter {handler, node_keys, &way_keys};
+        filter.node(node_with_tags(buffer, {{"railway", "station"}}));
+        filter.node(node_with_tags(buffer, {{"highway", "bus_stop"}}));
+        filter.node(node_with_tags(buffer, {}));
+        CHECK(handler.nodes == 1);
+    }
+
+    SECTION("ways are filtered by their keys") {
+        CandidateFilter<CountingHandler> filter {handler, node_keys, &way_keys};
+        filter.way(way_with_tags(buffer, {{"highway", "primary"}}));
+        filter.way(way_with_tags(buffer, {{"railway", "rail"}}));
+        CHECK(handler.ways == 1);
+    }
+
+    SECTION("all ways are passed without way keys") {
+        CandidateFilter<CountingHandler> filter {handler, node_keys, nullptr};
+        filter.way(way_with_tags(buffer, {{"highway", "primary"}}));
+        filter.way(way_with_tags(buffer, {}));
+        CHECK(handler.ways == 2);
+    }
+}
@@ -0,0 +1,125 @@
+/*
+ * test_region.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include "catch.hpp"
+#include "object_builder_utilities.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <region.hpp>
+
+static Region region_from_poly(const std::string& content) {
+    const std::string filename = "test_region.poly";
+    {
+        std::ofstream file(filename);
+        file << content;
+    }
+    try {
+        Region region = Region::from_poly_file(filename);
+        std::remove(filename.c_str());
+        return region;
+    } catch (...) {
+        std::remove(filename.c_str());
+        throw;
+    }
+}
+
+static const osmium::Way& way_at(osmium::memory::Buffer& buffer, const std::vector<osmium::Location>& locations) {
+    std::vector<osmium::NodeRef> nodes;
+    osmium::object_id_type id = 1;
+    for (const osmium::Location& location : locations) {
+        nodes.emplace_back(id++, location);
+    }
+    std::vector<const osmium::NodeRef*> node_refs;
+    for (const osmium::NodeRef& node : nodes) {
+        node_refs.push_back(&node);
+    }
+    const osmium::Way& way = test_utils::create_way(buffer, 1, node_refs, {});
+    buffer.commit();
+    return way;
+}
+
+TEST_CASE("region from a bounding box") {
+    SECTION("valid bounding box") {
+        const Region region = Region::from_bbox("1.5,2,3,4.5");
+        CHECK(region.box() == osmium::Box(1.5, 2.0, 3.0, 4.5));
+        CHECK(region.contains(osmium::Location{2.0, 3.0}));
+        CHECK(region.contains(osmium::Location{1.5, 2.0}));
+        CHECK_FALSE(region.contains(osmium::Location{3.5, 3.0}));
+        CHECK_FALSE(region.contains(osmium::Location{}));
+    }
+
+    SECTION("invalid bounding boxes") {
+        CHECK_THROWS_AS(Region::from_bbox(""), std::invalid_argument);
+        CHECK_THROWS_AS(Region::from_bbox("1,2,3"), std::invalid_argument);
+        CHECK_THROWS_AS(Region::from_bbox("1;2;3;4"), std::invalid_argument);
+        CHECK_THROWS_AS(Region::from_bbox("a,2,3,4"), std::invalid_argument);
+        CHECK_THROWS_AS(Region::from_bbox("3,2,1,4"), std::invalid_argument);
+        CHECK_THROWS_AS(Region::from_bbox("1,4,3,2"), std::invalid_argument);
+    }
+}
+
+TEST_CASE("region from a polygon file") {
+    static constexpr int buffer_size = 1000 * 1000;
+    osmium::memory::Buffer buffer(buffer_size);
+
+    SECTION("polygon with a hole") {
+        const Region region = region_from_poly(
+                "square\n"
+                "outer\n"
+                "   0.0 0.0\n"
+                "   10.0 0.0\n"
+                "   10.0 10.0\n"
+                "   0.0 10.0\n"
+                "   0.0 0.0\n"
+                "END\n"
+                "!hole\n"
+                "   4.0 4.0\n"
+                "   6.0 4.0\n"
+                "   6.0 6.0\n"
+                "   4.0 6.0\n"
+                "   4.0 4.0\n"
+                "END\n"
+                "END\n");
+        CHECK(region.box() == osmium::Box(0.0, 0.0, 10.0, 10.0));
+        CHECK(region.contains(osmium::Location{2.0, 2.0}));
+        CHECK(region.contains(osmium::Location{8.0, 5.0}));
+        CHECK_FALSE(region.contains(osmium::Location{5.0, 5.0}));
+        CHECK_FALSE(region.contains(osmium::Location{12.0, 5.0}));
+        CHECK(region.contains(way_at(buffer, {osmium::Location{5.0, 5.0}, osmium::Location{8.0, 5.0}})));
+        CHECK_FALSE(region.contains(way_at(buffer, {osmium::Location{5.0, 5.0}, osmium::Location{5.5, 5.0}})));
+        CHECK(region.contains(way_at(buffer, {osmium::Location{}, osmium::Location{}})));
+    }
+
+    SECTION("two separate rings") {
+        const Region region = region_from_poly(
+                "two islands\n"
+                "1\n"
+                "   0.0 0.0\n"
+                "   1.0 0.0\n"
+                "   1.0 1.0\n"
+                "END\n"
+                "2\n"
+                "   5.0 5.0\n"
+                "   6.0 5.0\n"
+                "   6.0 6.0\n"
+                "END\n"
+                "END\n");
+        CHECK(region.contains(osmium::Location{0.8, 0.2}));
+        CHECK(region.contains(osmium::Location{5.8, 5.2}));
+        CHECK_FALSE(region.contains(osmium::Location{3.0, 3.0}));
+    }
+
+    SECTION("invalid polygon files") {
+        CHECK_THROWS_AS(Region::from_poly_file("does_not_exist.poly"), std::runtime_error);
+        CHECK_THROWS_AS(region_from_poly(""), std::runtime_error);
+        CHECK_THROWS_AS(region_from_poly("empty\nEND\n"), std::runtime_error);
+        CHECK_THROWS_AS(region_from_poly("no coordinates\n1\nEND\nEND\n"), std::runtime_error);
+        CHECK_THROWS_AS(region_from_poly("missing latitude\n1\n   1.0\nEND\nEND\n"), std::runtime_error);
+        CHECK_THROWS_AS(region_from_poly("not a number\n1\n   abc 1.0\nEND\nEND\n"), std::runtime_error);
+    }
+}
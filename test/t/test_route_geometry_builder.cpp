@@ -0,0 +1,93 @@
+/*
+ * test_route_geometry_builder.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include "catch.hpp"
+#include "object_builder_utilities.hpp"
+
+#include <route_geometry_builder.hpp>
+
+using node_ids = std::vector<osmium::object_id_type>;
+
+static const osmium::Way& way_with_nodes(osmium::memory::Buffer& buffer, const osmium::object_id_type id,
+        const node_ids& ids, const tagmap& tags = {}) {
+    std::vector<osmium::NodeRef> nodes;
+    for (const osmium::object_id_type node_id : ids) {
+        nodes.emplace_back(node_id, osmium::Location{static_cast<double>(node_id), 1.0});
+    }
+    std::vector<const osmium::NodeRef*> node_refs;
+    for (const osmium::NodeRef& node : nodes) {
+        node_refs.push_back(&node);
+    }
+    const osmium::Way& way = test_utils::create_way(buffer, id, node_refs, tags);
+    buffer.commit();
+    return way;
+}
+
+static std::vector<node_ids> section_ids(RouteGeometryBuilder& builder) {
+    std::vector<node_ids> result;
+    for (const RouteGeometryBuilder::section_type& section : builder.finish()) {
+        result.emplace_back();
+        for (const osmium::NodeRef& node : section) {
+            result.back().push_back(node.ref());
+        }
+    }
+    return result;
+}
+
+TEST_CASE("merge member ways into sections") {
+    static constexpr int buffer_size = 1000 * 1000;
+    osmium::memory::Buffer buffer(buffer_size);
+    RouteGeometryBuilder builder;
+
+    SECTION("chain with reversed ways") {
+        const osmium::Way& way1 = way_with_nodes(buffer, 1, {2, 1});
+        const osmium::Way& way2 = way_with_nodes(buffer, 2, {2, 3, 4});
+        const osmium::Way& way3 = way_with_nodes(buffer, 3, {6, 5, 4});
+        builder.add_way(way1, "");
+        builder.add_way(way2, "");
+        builder.add_way(way3, "");
+        CHECK(section_ids(builder) == std::vector<node_ids>({{1, 2, 3, 4, 5, 6}}));
+    }
+
+    SECTION("gaps start new sections") {
+        const osmium::Way& way1 = way_with_nodes(buffer, 1, {1, 2});
+        const osmium::Way& way2 = way_with_nodes(buffer, 2, {3, 4});
+        const osmium::Way& way3 = way_with_nodes(buffer, 3, {4, 5});
+        builder.add_way(way1, "");
+        builder.add_way(way2, "");
+        builder.add_gap();
+        builder.add_way(way3, "");
+        CHECK(section_ids(builder) == std::vector<node_ids>({{1, 2}, {3, 4}, {4, 5}}));
+    }
+
+    SECTION("roundabout cut to the traversed arc") {
+        const osmium::Way& way1 = way_with_nodes(buffer, 1, {1, 10});
+        const osmium::Way& roundabout = way_with_nodes(buffer, 2, {10, 11, 12, 13, 10}, {{"junction", "roundabout"}});
+        const osmium::Way& way3 = way_with_nodes(buffer, 3, {20, 12});
+        builder.add_way(way1, "");
+        builder.add_way(roundabout, "");
+        builder.add_way(way3, "");
+        CHECK(section_ids(builder) == std::vector<node_ids>({{1, 10, 11, 12, 20}}));
+    }
+
+    SECTION("roundabout at the beginning") {
+        const osmium::Way& roundabout = way_with_nodes(buffer, 1, {10, 11, 12, 13, 10}, {{"junction", "roundabout"}});
+        const osmium::Way& way2 = way_with_nodes(buffer, 2, {12, 20});
+        builder.add_way(roundabout, "");
+        builder.add_way(way2, "");
+        CHECK(section_ids(builder) == std::vector<node_ids>({{12, 13, 10, 11, 12, 20}}));
+    }
+
+    SECTION("ways with a direction role") {
+        const osmium::Way& way1 = way_with_nodes(buffer, 1, {1, 2});
+        const osmium::Way& way2 = way_with_nodes(buffer, 2, {3, 2});
+        const osmium::Way& way3 = way_with_nodes(buffer, 3, {3, 4});
+        builder.add_way(way1, "");
+        builder.add_way(way2, "backward");
+        builder.add_way(way3, "");
+        CHECK(section_ids(builder) == std::vector<node_ids>({{1, 2}, {2, 3}, {3, 4}}));
+    }
+}
@@ -0,0 +1,163 @@
+/*
+ * test_statistics.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include "catch.hpp"
+#include "object_builder_utilities.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <statistics.hpp>
+
+static const std::string JSON_FILENAME = "test_statistics.json";
+static const std::string SAVED_FILENAME = "test_statistics.txt";
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream in(filename);
+    std::ostringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+/**
+ * Check that the brackets and braces outside of string literals are balanced.
+ */
+static bool balanced_json(const std::string& json) {
+    std::string open;
+    bool in_string = false;
+    for (size_t i = 0; i < json.size(); ++i) {
+        const char c = json[i];
+        if (in_string) {
+            if (c == '\\') {
+                ++i;
+            } else if (c == '"') {
+                in_string = false;
+            }
+        } else if (c == '"') {
+            in_string = true;
+        } else if (c == '{' || c == '[') {
+            open += c;
+        } else if (c == '}' || c == ']') {
+            if (open.empty() || open.back() != (c == '}' ? '{' : '[')) {
+                return false;
+            }
+            open.pop_back();
+        }
+    }
+    return open.empty() && !in_string;
+}
+
+/**
+ * Fill the statistics with a pass which reads two nodes, a way and a relation.
+ */
+static void fill(Statistics& statistics, const char* pass_name) {
+    static constexpr int buffer_size = 1000 * 1000;
+    osmium::memory::Buffer buffer(buffer_size);
+    const osmium::Node& node1 = test_utils::create_new_node(buffer, 1, osmium::Location{1.0, 1.0}, {});
+    buffer.commit();
+    const osmium::Node& node2 = test_utils::create_new_node(buffer, 2, osmium::Location{1.0, 2.0}, {});
+    buffer.commit();
+    std::vector<const osmium::NodeRef*> node_refs;
+    const osmium::Way& way = test_utils::create_way(buffer, 3, node_refs, {});
+    buffer.commit();
+    std::vector<osmium::object_id_type> member_ids;
+    std::vector<osmium::item_type> member_types;
+    std::vector<std::string> member_roles;
+    const osmium::Relation& relation = test_utils::create_relation(buffer, 4, {{"type", "route"}}, member_ids,
+            member_types, member_roles);
+    buffer.commit();
+
+    statistics.start_pass(pass_name);
+    statistics.node(node1);
+    statistics.node(node2);
+    statistics.way(way);
+    statistics.relation(relation);
+    statistics.end_pass();
+    statistics.set_location_index("flex_mem", 1024);
+    statistics.set_item_stash_memory(2048);
+    statistics.set_relations_manager_memory(10, 20, 30);
+    RouteStatistics routes;
+    routes.add(RouteError::CLEAN);
+    RouteError error = RouteError::OVER_NON_RAIL;
+    error |= RouteError::NO_FERRY;
+    routes.add(error);
+    routes.add(RouteError::UNORDERED_GAP);
+    statistics.set_routes(routes);
+}
+
+TEST_CASE("route statistics") {
+    RouteStatistics routes;
+    routes.add(RouteError::CLEAN);
+    RouteError error = RouteError::OVER_NON_RAIL;
+    error |= RouteError::NO_FERRY;
+    routes.add(error);
+    CHECK(routes.valid == 1);
+    CHECK(routes.invalid == 1);
+    CHECK(routes.errors[0] == 1);
+    CHECK(routes.errors[1] == 0);
+    CHECK(routes.errors[15] == 1);
+
+    RouteStatistics sum;
+    sum.add(routes);
+    sum.add(routes);
+    CHECK(sum.valid == 2);
+    CHECK(sum.invalid == 2);
+    CHECK(sum.errors[15] == 2);
+}
+
+TEST_CASE("write statistics as JSON") {
+    Statistics statistics;
+    fill(statistics, "first \"pass\"");
+    statistics.set_layer_features({{"routes", 2}, {"odd \\ name", 0}});
+    statistics.write(JSON_FILENAME);
+    const std::string json = read_file(JSON_FILENAME);
+    std::remove(JSON_FILENAME.c_str());
+
+    CHECK(balanced_json(json));
+    CHECK(json.find("{\"name\": \"first \\\"pass\\\"\", \"wall_seconds\": ") != std::string::npos);
+    CHECK(json.find("\"nodes\": 2, \"ways\": 1, \"relations\": 1, ") != std::string::npos);
+    CHECK(json.find("\"routes\": 2,\n") != std::string::npos);
+    CHECK(json.find("\"odd \\\\ name\": 0\n") != std::string::npos);
+    CHECK(json.find("\"routes\": {\"valid\": 1, \"invalid\": 2, \"errors\": {\"over_non_rail\": 1, \"over_non_road\": 0, ")
+            != std::string::npos);
+    CHECK(json.find("\"unordered_gap\": 1, ") != std::string::npos);
+    CHECK(json.find("\"no_ferry\": 1}}") != std::string::npos);
+    CHECK(json.find("\"location_index_type\": \"flex_mem\", \"location_index_bytes\": 1024, \"item_stash_bytes\": 2048, "
+            "\"relations_db_bytes\": 10, \"members_db_bytes\": 20, \"relations_stash_bytes\": 30, ") != std::string::npos);
+}
+
+TEST_CASE("add saved statistics of workers") {
+    Statistics worker;
+    fill(worker, "relations");
+    worker.save(SAVED_FILENAME);
+
+    Statistics statistics;
+    statistics.add_saved(SAVED_FILENAME);
+    statistics.add_saved(SAVED_FILENAME);
+    std::remove(SAVED_FILENAME.c_str());
+    statistics.write(JSON_FILENAME);
+    const std::string json = read_file(JSON_FILENAME);
+    std::remove(JSON_FILENAME.c_str());
+
+    CHECK(balanced_json(json));
+    CHECK(json.find("{\"name\": \"relations\", ") != std::string::npos);
+    CHECK(json.find("\"nodes\": 4, \"ways\": 2, \"relations\": 2, ") != std::string::npos);
+    CHECK(json.find("\"routes\": {\"valid\": 2, \"invalid\": 4, \"errors\": {\"over_non_rail\": 2, ") != std::string::npos);
+    CHECK(json.find("\"location_index_type\": \"flex_mem\", \"location_index_bytes\": 2048, ") != std::string::npos);
+
+    SECTION("invalid file") {
+        {
+            std::ofstream out(SAVED_FILENAME);
+            out << "unknown 1 2 3\n";
+        }
+        CHECK_THROWS_AS(statistics.add_saved(SAVED_FILENAME), std::runtime_error);
+        std::remove(SAVED_FILENAME.c_str());
+        CHECK_THROWS_AS(statistics.add_saved(SAVED_FILENAME), std::runtime_error);
+    }
+}
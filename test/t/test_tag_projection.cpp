@@ -0,0 +1,89 @@
+/*
+ * test_tag_projection.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include "catch.hpp"
+#include "object_builder_utilities.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <tag_projection.hpp>
+
+using taglist = std::vector<std::pair<std::string, std::string>>;
+
+static const char* const KEYS[] = {"highway", "name", "railway", "ref"};
+
+static_assert(tag_keys_sorted(KEYS), "KEYS are not sorted");
+
+/**
+ * Build a tag list which may contain a key more than once. tagmap cannot do that.
+ */
+static const osmium::TagList& tag_list(osmium::memory::Buffer& buffer, const taglist& tags) {
+    {
+        osmium::builder::WayBuilder way_builder(buffer);
+        osmium::builder::TagListBuilder tl_builder(buffer, &way_builder);
+        for (const auto& tag : tags) {
+            tl_builder.add_tag(tag.first, tag.second);
+        }
+    }
+    const size_t offset = buffer.commit();
+    return buffer.get<osmium::Way>(offset).tags();
+}
+
+TEST_CASE("project tags on a key set") {
+    static constexpr int buffer_size = 1000 * 1000;
+    osmium::memory::Buffer buffer(buffer_size);
+
+    SECTION("keys in and out of the key set") {
+        const osmium::TagList& tags = tag_list(buffer, {{"railway", "rail"}, {"usage", "main"}, {"ref", "4711"}});
+        TagProjection<4> projection {KEYS, tags};
+        CHECK(projection.get(0) == nullptr);
+        CHECK(std::string{projection.get(0, "none")} == "none");
+        CHECK(projection.get(1) == nullptr);
+        CHECK(std::string{projection.get(2)} == "rail");
+        CHECK(std::string{projection.get(3)} == "4711");
+        CHECK(projection.has(2, "rail"));
+        CHECK_FALSE(projection.has(2, "tram"));
+        CHECK_FALSE(projection.has(0, "rail"));
+    }
+
+    SECTION("the first tag of a duplicate key wins") {
+        const osmium::TagList& tags = tag_list(buffer, {{"name", "first"}, {"railway", "tram"}, {"name", "second"},
+                {"railway", "rail"}});
+        TagProjection<4> projection {KEYS, tags};
+        CHECK(std::string{projection.get(1)} == "first");
+        CHECK(std::string{projection.get(2)} == "tram");
+        // same result as get_value_by_key()
+        for (size_t i = 0; i < 4; ++i) {
+            const char* expected = tags.get_value_by_key(KEYS[i]);
+            const char* value = projection.get(i);
+            REQUIRE((expected == nullptr) == (value == nullptr));
+            if (expected) {
+                CHECK(std::string{value} == expected);
+            }
+        }
+    }
+
+    SECTION("projecting another tag list discards the old values") {
+        const osmium::TagList& first = tag_list(buffer, {{"highway", "primary"}, {"ref", "B 1"}});
+        const osmium::TagList& second = tag_list(buffer, {{"highway", "secondary"}});
+        TagProjection<4> projection {KEYS};
+        projection.project(first);
+        CHECK(std::string{projection.get(3)} == "B 1");
+        projection.project(second);
+        CHECK(std::string{projection.get(0)} == "secondary");
+        CHECK(projection.get(3) == nullptr);
+    }
+
+    SECTION("key order") {
+        static const char* const unsorted[] = {"ref", "name"};
+        static const char* const duplicate[] = {"name", "name"};
+        CHECK_FALSE(tag_keys_sorted(unsorted));
+        CHECK_FALSE(tag_keys_sorted(duplicate));
+        CHECK(tag_key_compare("name", "name:de") < 0);
+        CHECK(tag_key_compare("ref", "railway") > 0);
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * test_tag_value.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include "catch.hpp"
+
+#include <cstring>
+#include <string>
+#include <tag_value.hpp>
+
+TEST_CASE("classify tag values") {
+    SECTION("all values of the table") {
+        for (size_t i = 1; i < static_cast<size_t>(TagValue::COUNT); ++i) {
+            INFO(TAG_VALUE_NAMES[i]);
+            CHECK(classify_tag_value(TAG_VALUE_NAMES[i]) == static_cast<TagValue>(i));
+        }
+    }
+
+    SECTION("values which are not in the table") {
+        CHECK(classify_tag_value(nullptr) == TagValue::UNKNOWN);
+        CHECK(classify_tag_value("") == TagValue::UNKNOWN);
+        CHECK(classify_tag_value("rai") == TagValue::UNKNOWN);
+        CHECK(classify_tag_value("rails") == TagValue::UNKNOWN);
+        CHECK(classify_tag_value("Rail") == TagValue::UNKNOWN);
+        CHECK(classify_tag_value("disused") == TagValue::UNKNOWN);
+        CHECK(classify_tag_value("isolated_track_sections") == TagValue::UNKNOWN);
+        CHECK(classify_tag_value(std::string(1000, 'a').c_str()) == TagValue::UNKNOWN);
+    }
+
+    SECTION("values colliding with a value of the table") {
+        // Strings which get the same slot as a value of the table have to be rejected by the comparison.
+        size_t collisions = 0;
+        size_t same_length_collisions = 0;
+        for (int i = 0; i < 100000; ++i) {
+            const std::string value = "v" + std::to_string(i);
+            const TagValue in_slot = tag_value_hash::TABLE.values[tag_value_hash::slot(tag_value_hash::hash(value.c_str()))];
+            if (in_slot == TagValue::UNKNOWN) {
+                continue;
+            }
+            ++collisions;
+            if (strlen(TAG_VALUE_NAMES[static_cast<size_t>(in_slot)]) == value.size()) {
+                ++same_length_collisions;
+            }
+            INFO(value);
+            CHECK(classify_tag_value(value.c_str()) == TagValue::UNKNOWN);
+        }
+        REQUIRE(collisions > 0);
+        REQUIRE(same_length_collisions > 0);
+    }
+}
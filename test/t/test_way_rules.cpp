@@ -0,0 +1,103 @@
+/*
+ * test_way_rules.cpp
+ *
+ *  Created on:  2026-10-18
+ */
+
+#include "catch.hpp"
+#include "object_builder_utilities.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <way_rules.hpp>
+
+static const osmium::TagList& tags_of_way(osmium::memory::Buffer& buffer, const tagmap& tags) {
+    std::vector<const osmium::NodeRef*> node_refs;
+    osmium::Way& way = test_utils::create_way(buffer, 1, node_refs, tags);
+    buffer.commit();
+    return way.tags();
+}
+
+static WayRules parse_rules(const std::string& text) {
+    std::istringstream input {text};
+    return WayRules::parse(input, "test");
+}
+
+TEST_CASE("default way rules") {
+    static constexpr int buffer_size = 1000 * 1000;
+    osmium::memory::Buffer buffer(buffer_size);
+    const WayRules& rules = WayRules::defaults();
+
+    SECTION("rail-guided routes") {
+        CHECK(rules.allows(RouteType::TRAIN, tags_of_way(buffer, {{"railway", "rail"}})));
+        CHECK(rules.allows(RouteType::TRAM, tags_of_way(buffer, {{"railway", "tram"}})));
+        CHECK_FALSE(rules.allows(RouteType::TRAIN, tags_of_way(buffer, {{"railway", "abandoned"}})));
+        CHECK(rules.allows(RouteType::SUBWAY, tags_of_way(buffer, {{"railway", "abandoned"}})));
+        CHECK(rules.allows(RouteType::TRAIN, tags_of_way(buffer, {{"route", "ferry"}})));
+        CHECK_FALSE(rules.allows(RouteType::TRAIN, tags_of_way(buffer, {{"highway", "primary"}})));
+    }
+
+    SECTION("buses") {
+        CHECK(rules.allows(RouteType::BUS, tags_of_way(buffer, {{"highway", "secondary"}})));
+        CHECK(rules.allows(RouteType::BUS, tags_of_way(buffer, {{"route", "ferry"}})));
+        CHECK_FALSE(rules.allows(RouteType::BUS, tags_of_way(buffer, {{"highway", "footway"}})));
+        CHECK_FALSE(rules.allows(RouteType::BUS, tags_of_way(buffer, {{"highway", "footway"}, {"route", "ferry"}})));
+        CHECK_FALSE(rules.allows(RouteType::BUS, tags_of_way(buffer, {})));
+    }
+
+    SECTION("trolley buses") {
+        CHECK(rules.allows(RouteType::TROLLEYBUS, tags_of_way(buffer, {{"highway", "primary"}, {"trolley_wire", "yes"}})));
+        CHECK(rules.allows(RouteType::TROLLEYBUS, tags_of_way(buffer, {{"highway", "primary"}, {"trolley_wire:backward", "yes"}})));
+        CHECK_FALSE(rules.allows(RouteType::TROLLEYBUS, tags_of_way(buffer, {{"highway", "primary"}})));
+        CHECK_FALSE(rules.allows(RouteType::TROLLEYBUS, tags_of_way(buffer, {{"highway", "footway"}, {"trolley_wire", "yes"}})));
+    }
+
+    SECTION("ferries") {
+        CHECK(rules.allows(RouteType::FERRY, tags_of_way(buffer, {{"route", "ferry"}})));
+        CHECK(rules.allows(RouteType::FERRY, tags_of_way(buffer, {})));
+        CHECK_FALSE(rules.allows(RouteType::FERRY, tags_of_way(buffer, {{"route", "bus"}})));
+    }
+
+    SECTION("route types without rules") {
+        CHECK_FALSE(rules.checks(RouteType::AERIALWAY));
+        CHECK(rules.allows(RouteType::AERIALWAY, tags_of_way(buffer, {{"highway", "footway"}})));
+    }
+}
+
+TEST_CASE("way rules from a file") {
+    static constexpr int buffer_size = 1000 * 1000;
+    osmium::memory::Buffer buffer(buffer_size);
+
+    SECTION("local variant with value lists") {
+        const WayRules rules = parse_rules("# buses may use busways\n"
+                "@roads primary|secondary\n"
+                "\n"
+                "bus highway=@roads|busway\n"
+                "bus !highway route=ferry\n");
+        CHECK(rules.allows(RouteType::BUS, tags_of_way(buffer, {{"highway", "busway"}})));
+        CHECK(rules.allows(RouteType::BUS, tags_of_way(buffer, {{"highway", "primary"}})));
+        CHECK_FALSE(rules.allows(RouteType::BUS, tags_of_way(buffer, {{"highway", "tertiary"}})));
+        CHECK_FALSE(rules.checks(RouteType::TRAIN));
+    }
+
+    SECTION("any value") {
+        const WayRules rules = parse_rules("tram railway=* !disused\n");
+        CHECK(rules.allows(RouteType::TRAM, tags_of_way(buffer, {{"railway", "anything"}})));
+        CHECK_FALSE(rules.allows(RouteType::TRAM, tags_of_way(buffer, {{"railway", "rail"}, {"disused", "yes"}})));
+        CHECK_FALSE(rules.allows(RouteType::TRAM, tags_of_way(buffer, {})));
+    }
+
+    SECTION("keys used by the rules") {
+        const WayRules rules = parse_rules("tram railway=tram !disused\n"
+                "bus highway=primary route=ferry\n");
+        CHECK(rules.keys() == std::vector<std::string>({"disused", "highway", "railway", "route"}));
+    }
+
+    SECTION("invalid rules") {
+        CHECK_THROWS_AS(parse_rules("boat route=ferry\n"), std::runtime_error);
+        CHECK_THROWS_AS(parse_rules("bus\n"), std::runtime_error);
+        CHECK_THROWS_AS(parse_rules("bus highway=@roads\n"), std::runtime_error);
+        CHECK_THROWS_AS(parse_rules("bus highway=primary highway=secondary\n"), std::runtime_error);
+        CHECK_THROWS_AS(parse_rules("bus highway=\n"), std::runtime_error);
+    }
+}